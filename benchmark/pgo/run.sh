@@ -0,0 +1,25 @@
+#!/bin/bash
+# Compares a release build of the benchmark with a build optimized with a
+# profile. The compiler finds the runtime in ../runtime, so the benchmark is
+# built from the benchmark directory.
+#
+# Usage: benchmark/pgo/run.sh [program.kush]
+set -e
+cd "$(dirname "$0")/.."
+KUSH=${KUSH:-../build/kush}
+PROGRAM=${1:-pgo/classify.kush}
+PROFILE=pgo/profile
+
+echo "[release]"
+"$KUSH" --release "$PROGRAM" -o pgo/release > /dev/null
+echo "[profile-generate]"
+"$KUSH" --release --profile-generate="$PROFILE" "$PROGRAM" -o pgo/instrumented > /dev/null
+./pgo/instrumented > /dev/null
+echo "[profile-use]"
+"$KUSH" --release --profile-use="$PROFILE" "$PROGRAM" -o pgo/optimized > /dev/null
+
+for build in release optimized
+do
+    echo "[$build]"
+    time ./pgo/$build > /dev/null
+done
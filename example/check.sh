@@ -0,0 +1,50 @@
+#!/bin/bash
+# Runs the examples that have an expected output with both kinds of references,
+# and reports the ones whose output differs. The statistics printed by the
+# collector and the allocator are left out of the comparison. The compiler
+# finds the runtime in ../runtime, so the examples are built from the example
+# directory.
+#
+# Usage: example/check.sh [name...]
+cd "$(dirname "$0")"
+KUSH=${KUSH:-../build/kush}
+OUTPUT=.check
+STATISTICS='^\[Collector Statistics\]$|^\[Allocator Statistics\]$|^Roots: |^Freed: |^Pages (Mapped|Unmapped) -> |^Chunks (Allocated|Freed) -> |^Free Lists Count -> |^$'
+
+if [ $# -eq 0 ]
+then
+    set -- $(ls *.expected | sed 's/\.expected$//')
+fi
+
+mkdir -p "$OUTPUT"
+failures=0
+for name in "$@"
+do
+    for references in default compressed
+    do
+        flags=
+        if [ $references = compressed ]
+        then
+            flags=--compressed-references
+        fi
+
+        executable="$OUTPUT/$name-$references"
+        if ! "$KUSH" $flags "$name.kush" -o "$executable" > "$executable.log" 2>&1
+        then
+            echo "[fail] $name ($references): see $executable.log"
+            failures=$((failures + 1))
+            continue
+        fi
+
+        "./$executable" 2>&1 | grep -Ev "$STATISTICS" > "$executable.output"
+        if diff -u "$name.expected" "$executable.output" > "$executable.diff"
+        then
+            echo "[pass] $name ($references)"
+        else
+            echo "[fail] $name ($references): see $executable.diff"
+            failures=$((failures + 1))
+        fi
+    done
+done
+
+exit $((failures > 0))
@@ -35,6 +35,11 @@
  */
 struct Analyzer {
     Compiler* compiler;
+    /* The handler that receives the semantic errors. By default, it is the
+     * error handler of the compiler. When the modules are resolved in
+     * parallel, each worker collects its errors separately.
+     */
+    ErrorHandler* errorHandler;
     const uint8_t* package;
     int32_t packageSize;
     Scope* scope;
@@ -44,7 +49,7 @@ struct Analyzer {
 
 typedef struct Analyzer Analyzer;
 
-Analyzer* newAnalyzer();
+Analyzer* newAnalyzer(Compiler* compiler);
 void deleteAnalyzer(Analyzer* self);
 void defineSymbols(Analyzer* analyzer, Module* module);
 void resetAnalyzer(Analyzer* analyzer);
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2017-2020 Samuel Rowe, Joel E. Rego
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Sunday, October 18, 2026
+
+#ifndef KUSH_BUILD_CACHE_H
+#define KUSH_BUILD_CACHE_H
+
+#include <jtk/collection/list/ArrayList.h>
+
+#include <kush/configuration.h>
+
+/*******************************************************************************
+ * BuildCache                                                                  *
+ *******************************************************************************/
+
+/**
+ * The name of the file, in the working directory, where the build cache is
+ * stored.
+ */
+#define KUSH_BUILD_CACHE_FILE ".kush-cache"
+
+/**
+ * The build cache records the hash of every input file that was compiled
+ * successfully. A module whose hash is unchanged, and whose generated files
+ * still exist, skips the frontend and the generator.
+ *
+ * The hash of a module covers the contents of the input file. The version of
+ * the compiler and the flags that affect the generated code are hashed into
+ * the key of the cache. When the key changes, all the entries are discarded.
+ *
+ * The cache is stored as text. The first line is the key, and each of the
+ * following lines contains the hash and the path of an input file.
+ */
+struct BuildCache {
+    const char* path;
+    uint64_t key;
+    jtk_ArrayList_t* entries;
+    bool dirty;
+};
+
+typedef struct BuildCache BuildCache;
+
+struct BuildCacheEntry {
+    uint8_t* path;
+    uint64_t hash;
+};
+
+typedef struct BuildCacheEntry BuildCacheEntry;
+
+// Constructor
+
+/**
+ * Loads the cache from the specified file. If the file does not exist, or it
+ * was written with a different key, the cache is empty.
+ */
+BuildCache* newBuildCache(const char* path, uint64_t key);
+
+// Destructor
+
+void deleteBuildCache(BuildCache* cache);
+
+// Cache
+
+bool isUpToDate(BuildCache* cache, const uint8_t* path, uint64_t hash);
+void updateBuildCache(BuildCache* cache, const uint8_t* path, uint64_t hash);
+bool saveBuildCache(BuildCache* cache);
+
+// Hash
+
+/**
+ * Returns the 64-bit FNV-1a hash of the bytes, continuing from the
+ * specified hash. The initial hash is `KUSH_HASH_SEED`.
+ */
+#define KUSH_HASH_SEED 0xCBF29CE484222325ULL
+
+uint64_t hashBytes(uint64_t hash, const void* bytes, size_t size);
+
+/**
+ * Hashes the contents of the specified file. Returns `false` if the file
+ * cannot be read.
+ */
+bool hashFile(const char* path, uint64_t* hash);
+
+// File
+
+/**
+ * Writes the contents to the specified file, unless the file already has the
+ * same contents. An unchanged file keeps its modification time, so that the
+ * C compiler does not consider it stale.
+ */
+bool writeIfChanged(const char* path, const uint8_t* contents, size_t size);
+
+/**
+ * Creates the directory and its parents, like `mkdir -p`. Returns `true` if
+ * the directory exists afterwards.
+ */
+bool makeDirectories(const char* path);
+
+// Dependencies
+
+/**
+ * Determines whether the target must be rebuilt. The target is outdated when
+ * it is missing, or when it is older than the command file or any of the
+ * files listed in the dependency file. The dependency file is in the format
+ * that the C compiler writes with `-MMD`. When it is missing, the target is
+ * considered outdated.
+ */
+bool isOutdated(const char* target, const char* commandFile,
+    const char* dependencyFile);
+
+/*******************************************************************************
+ * ObjectCache                                                                 *
+ *******************************************************************************/
+
+/**
+ * The default limit on the size of the object cache, in megabytes.
+ */
+#define KUSH_OBJECT_CACHE_SIZE 256
+
+/**
+ * The object cache stores the object files compiled by the C compiler,
+ * shared by all the builds. Each object is stored under a key that hashes
+ * the inputs of the compilation, that is, the C file, the headers that it
+ * includes, and the flags of the C compiler. Therefore, an object that was
+ * compiled from the same inputs before is copied instead of compiled, even
+ * after the generated files are deleted.
+ *
+ * When the cache grows beyond its limit, the objects that were used least
+ * recently are evicted. The modification time of an object records its last
+ * use.
+ */
+struct ObjectCache {
+    char* directory;
+    uint64_t limit;
+};
+
+typedef struct ObjectCache ObjectCache;
+
+// Constructor
+
+/**
+ * Creates the directory of the cache, if it does not exist. Returns `NULL` if
+ * the directory cannot be created.
+ */
+ObjectCache* newObjectCache(const char* directory, uint64_t limit);
+
+// Destructor
+
+void deleteObjectCache(ObjectCache* cache);
+
+// Cache
+
+/**
+ * Copies the object stored under the key to the specified path. Returns
+ * `false` if the cache does not have the object.
+ */
+bool fetchObject(ObjectCache* cache, uint64_t key, const char* path);
+
+/**
+ * Copies the object at the specified path to the cache. This function is
+ * safe to call from multiple threads and processes.
+ */
+void storeObject(ObjectCache* cache, uint64_t key, const char* path);
+
+/**
+ * Evicts the least recently used objects until the cache is within its
+ * limit.
+ */
+void trimObjectCache(ObjectCache* cache);
+
+#endif /* KUSH_BUILD_CACHE_H */
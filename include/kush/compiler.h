@@ -20,6 +20,7 @@
 #define KUSH_COMPILER_COMPILER_H
 
 #include <kush/configuration.h>
+#include <kush/build-cache.h>
 #include <kush/error-handler.h>
 #include <kush/symbol-loader.h>
 
@@ -33,6 +34,19 @@
 
 typedef struct Module Module;
 
+/* The optimization levels of the C compiler, selected with the `--opt`
+ * flag.
+ */
+enum OptimizationLevel {
+    OPTIMIZE_NONE,
+    OPTIMIZE_BASIC,
+    OPTIMIZE_DEFAULT,
+    OPTIMIZE_AGGRESSIVE,
+    OPTIMIZE_SIZE
+};
+
+typedef enum OptimizationLevel OptimizationLevel;
+
 /**
  * @author Samuel Rowe
  * @since Kush 0.1
@@ -42,9 +56,66 @@ struct Compiler {
     bool dumpNodes;
     bool footprint;
     bool dumpInstructions;
+    bool reportBoundsChecks;
+    bool compressedReferences;
     jtk_Logger_t* logger;
     jtk_ArrayList_t* inputFiles;
-    int32_t currentFileIndex;
+    /* The flags forwarded to the linker, such as `-lm`, for the libraries
+     * that implement native functions.
+     */
+    jtk_ArrayList_t* linkerFlags;
+    /* The number of threads that parse, resolve, and generate the input
+     * files.
+     */
+    int32_t threads;
+    /* The number of C compiler processes that compile the generated files
+     * into object files at once.
+     */
+    int32_t jobs;
+    /* The flags of the C compiler for the generated code and the runtime.
+     * The optimized builds link the release variant of the runtime library.
+     */
+    OptimizationLevel optimization;
+    const char* targetCpu;
+    bool linkTimeOptimization;
+    bool debugInfo;
+    bool strip;
+    /* Determines whether the executable is instrumented to collect a profile,
+     * or optimized with a profile collected before. The profile is stored in
+     * the profile directory.
+     */
+    bool profileGenerate;
+    bool profileUse;
+    const char* profileDirectory;
+    /* Determines whether the generated files and the runtime are compiled as
+     * a single translation unit. The generated functions, except the entry
+     * point, have internal linkage.
+     */
+    bool unity;
+    /* Determines whether the generated code is kept in memory and piped to
+     * the C compiler. The code generated for each input file is stored in
+     * a buffer.
+     */
+    bool inMemory;
+    char** generatedSources;
+    size_t* generatedSizes;
+    /* The directory of the object cache, and its limit in megabytes. */
+    const char* objectCacheDirectory;
+    int32_t objectCacheSize;
+    /* Determines whether each input file is lexed on a separate thread while
+     * it is parsed.
+     */
+    bool pipeline;
+    /* Determines whether the input files that are unchanged since the
+     * previous build skip the frontend and the generator.
+     */
+    bool useBuildCache;
+    BuildCache* buildCache;
+    /* The hash of each input file, and whether its generated files are up to
+     * date.
+     */
+    uint64_t* hashes;
+    bool* upToDate;
     ErrorHandler* errorHandler;
     Module** modules;
     uint8_t** packages;
@@ -37,6 +37,8 @@
 #define TYPE_BOOLEAN 7
 #define TYPE_FUNCTION 8
 #define TYPE_UNKONWN 9
+#define TYPE_PARAMETER 10
+#define TYPE_VECTOR 11
 
 typedef struct Type Type;
 typedef struct Structure Structure;
@@ -49,6 +51,16 @@ struct Type {
     bool reference;
     Token* identifier;
     jtk_ArrayList_t* arrayTypes;
+
+    /* The instances of a generic type, such as `Map<string, i32>` for `Map`.
+     * Each combination of type arguments is instantiated once, so that the
+     * instances can be compared by identity, like the other types.
+     */
+    jtk_ArrayList_t* instances;
+
+    /* The type arguments of an instance of a generic type. Otherwise, `NULL`. */
+    jtk_ArrayList_t* arguments;
+
     union {
         struct {
             /**
@@ -80,6 +92,30 @@ struct Type {
         } decimal;
         Structure* structure;
         Function* function;
+        struct {
+            /* The position of the parameter in the type parameters of the
+             * generic type that declares it.
+             */
+            uint8_t index;
+            /* Determines whether the argument is restricted to the types that
+             * can be hashed, namely, strings, integers, and references.
+             */
+            bool hashable;
+            /* Determines whether the values of the parameter are stored
+             * unboxed, with the representation of the type argument. The
+             * generic functions of such types are passed the C types of the
+             * arguments, instead of values wrapped in k_Value_t.
+             */
+            bool unboxed;
+        } parameter;
+        struct {
+            /* The name of the type, such as "f32x8". */
+            const char* name;
+            /* The type of each lane. */
+            Type* lane;
+            /* The number of lanes. */
+            uint8_t lanes;
+        } vector;
     };
 };
 
@@ -103,6 +139,14 @@ struct Primitives {
     Type ui64;
     Type f32;
     Type f64;
+    Type i32x4;
+    Type i32x8;
+    Type i64x2;
+    Type i64x4;
+    Type f32x4;
+    Type f32x8;
+    Type f64x2;
+    Type f64x4;
     Type void_;
     Type null;
     Type string;
@@ -219,6 +263,8 @@ struct Symbol {
 
 struct VariableType {
     Token* token;
+    /* The type arguments, each a VariableType, or `NULL`. */
+    jtk_ArrayList_t* arguments;
     int32_t dimensions;
 };
 
@@ -329,6 +375,9 @@ void deletePostfixExpression(PostfixExpression* self);
 struct MemberAccess {
     ContextType tag;
     Token* identifier;
+    Type* previous;
+    /* The type of the member, recorded by the analyzer. */
+    Type* type;
 };
 
 typedef struct MemberAccess MemberAccess;
@@ -379,6 +428,17 @@ struct FunctionArguments {
     ContextType tag;
     Token* parenthesis;
     jtk_ArrayList_t* expressions;
+    /* The function that is invoked and, for generic functions, the instance
+     * of the generic type that its type parameters are bound to. The instance
+     * is `NULL` when an ordinary function is invoked.
+     */
+    Function* function;
+    Type* instance;
+    /* The types of the arguments when a native function is invoked, so that
+     * the value of a string can be told apart from a `ui8[]`. Otherwise,
+     * `NULL`.
+     */
+    jtk_ArrayList_t* types;
 };
 
 typedef struct FunctionArguments FunctionArguments;
@@ -394,6 +454,13 @@ struct Subscript {
     ContextType tag;
     Token* bracket;
     BinaryExpression* expression;
+    /* Indicates whether the index is checked against the size of the array at
+     * runtime. The analyzer clears this flag when the index is proven to be in
+     * range.
+     */
+    bool checked;
+    /* The type of the element, recorded by the analyzer. */
+    Type* type;
 };
 
 typedef struct Subscript Subscript;
@@ -459,7 +526,10 @@ struct Function {
     Type* returnType;
     Type* type;
     Scope* scope;
+    uint32_t modifiers;
     int32_t totalReferences;
+    int32_t boundsChecks;
+    int32_t eliminatedChecks;
 };
 
 typedef struct Function Function;
@@ -482,6 +552,10 @@ struct Structure {
     jtk_ArrayList_t* declarations;
     Type* type;
     Scope* scope;
+    /* The type parameters of a generic builtin structure, each a Type tagged
+     * TYPE_PARAMETER, or `NULL`.
+     */
+    jtk_ArrayList_t* typeParameters;
 };
 
 typedef struct Structure Structure;
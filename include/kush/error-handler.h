@@ -101,6 +101,10 @@ enum ErrorCode {
     ERROR_EMPTY_ARRAY_INITIALIZER,
     ERROR_EXPECTED_STRUCTURE_NAME,
     ERROR_EXPECTED_INTEGER_EXPRESSION,
+    ERROR_INVALID_TYPE_ARGUMENT_COUNT,
+    ERROR_INVALID_KEY_TYPE,
+    ERROR_INVALID_NATIVE_TYPE,
+    ERROR_ESCAPING_STRING_VALUE,
 
     // General Errors
 
@@ -30,10 +30,25 @@ struct Generator {
     Scope* scope;
     FILE* output;
     int32_t index;
+    /* The operator of the assignment whose target is the next postfix
+     * expression, or `NULL`. The target is stored to without decoding it.
+     */
+    Token* assignment;
+    /* Indicates that the target of the assignment being generated is a
+     * reference slot, so the value must be encoded.
+     */
+    bool encoding;
+    /* Indicates that the target of the assignment being generated is an
+     * element of a boolean array. The operator and the value are passed to
+     * the store macro that was opened for the target.
+     */
+    bool packing;
 };
 
 typedef struct Generator Generator;
 
 Generator* newGenerator(Compiler* compiler);
 void deleteGenerator(Generator* generator);
-void generateC(Generator* generator, Module* module);
+void generateC(Generator* generator, Module* module, const uint8_t* path);
+void generateInMemory(Generator* generator, Module* module, char** buffer,
+    size_t* size);
@@ -48,6 +48,19 @@ struct Lexer {
 
     Compiler* compiler;
 
+    /**
+     * The handler that receives the lexical errors. By default, it is the
+     * error handler of the compiler. When the input files are lexed in
+     * parallel, each worker collects its errors separately.
+     */
+    ErrorHandler* errorHandler;
+
+    /**
+     * The path of the file that is being lexed. It is recorded in the
+     * tokens.
+     */
+    const char* file;
+
     /**
      * The input stream of characters.
      */
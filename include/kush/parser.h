@@ -31,6 +31,8 @@
 
 struct Parser {
     Compiler* compiler;
+    /* The handler that receives the syntax errors. */
+    ErrorHandler* errorHandler;
     TokenStream* tokens;
     int32_t* followSet;
     int32_t followSetSize;
@@ -26,6 +26,47 @@
 #include <kush/lexer.h>
 
 
+/*******************************************************************************
+ * TokenRing                                                                   *
+ *******************************************************************************/
+
+/**
+ * The number of tokens that the lexer can produce ahead of the parser in the
+ * pipelined mode. It must be a power of two.
+ */
+#define KUSH_TOKEN_RING_CAPACITY 1024
+
+/**
+ * A bounded, lock-free queue that carries tokens from a lexer thread to a
+ * parser thread. There must be exactly one producer and one consumer. The
+ * counters increase monotonically and are reduced modulo the capacity when
+ * the slots are accessed. When the ring is full or empty, the waiting thread
+ * yields the processor.
+ */
+struct TokenRing {
+    Token** slots;
+    uint32_t capacity;
+
+    /**
+     * The number of tokens removed so far. It is written only by the
+     * consumer.
+     */
+    uint32_t head;
+
+    /**
+     * The number of tokens inserted so far. It is written only by the
+     * producer.
+     */
+    uint32_t tail;
+};
+
+typedef struct TokenRing TokenRing;
+
+TokenRing* newTokenRing(uint32_t capacity);
+void deleteTokenRing(TokenRing* ring);
+void pushToken(TokenRing* ring, Token* token);
+Token* popToken(TokenRing* ring);
+
 /*******************************************************************************
  * TokenStream                                                           *
  *******************************************************************************/
@@ -71,6 +112,13 @@ struct TokenStream {
     TokenChannel channel;
 
     jtk_ArrayList_t* trash;
+
+    /**
+     * The ring from which the tokens are fetched when the lexer runs on
+     * another thread, or `NULL` when the tokens are requested from the
+     * lexer directly.
+     */
+    TokenRing* ring;
 };
 
 typedef struct TokenStream TokenStream;
@@ -153,6 +153,17 @@ typedef enum TokenType TokenType;
 
 extern char tokenNames[][25];
 
+/*******************************************************************************
+ * Modifiers                                                                   *
+ *******************************************************************************/
+
+/* A native function is declared without a body and implemented in C. */
+#define KUSH_MODIFIER_NATIVE (1 << 0)
+
+#define hasNative(modifiers) (((modifiers) & KUSH_MODIFIER_NATIVE) != 0)
+
+uint32_t k_TokenType_toModifiers(TokenType type);
+
 /*******************************************************************************
  * TokenChannel                                                                *
  *******************************************************************************/
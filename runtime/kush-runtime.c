@@ -2,6 +2,15 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "kush-runtime.h"
 
@@ -16,6 +25,12 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+/* The value of the mark bit that indicates an object is reachable. It is
+ * flipped after every collection, which saves the collector from clearing the
+ * marks of the surviving objects.
+ */
+bool sense = true;
+
 static int32_t countFreeLists(k_Allocator_t* allocator);
 static bool isSorted(k_Allocator_t* allocator);
 static void coalesce(k_Allocator_t* allocator);
@@ -24,6 +39,141 @@ static void addPage(k_Allocator_t* allocator);
 static k_FreeList_t* findChunk(k_Allocator_t* allocator, size_t size);
 static size_t divide(size_t a, size_t b);
 static void* allocateLarge(k_Allocator_t* allocator, size_t size);
+static void reportOutOfMemory(size_t size) __attribute__((noreturn, cold));
+static void* mapPages(size_t size);
+static int unmapPages(void* address, size_t size);
+
+#ifdef KUSH_COMPRESSED_REFERENCES
+
+/* The heap is reserved near this address, so that the base is the same across
+ * runs whenever the address space allows it.
+ */
+#define K_HEAP_BASE_HINT ((void*)0x100000000000)
+
+uint8_t* k_heapBase = NULL;
+static uint8_t* heapTop = NULL;
+
+/* A range of pages in the reservation that was unmapped. The ranges are sorted
+ * by address, and adjacent ranges are merged, so that a large allocation can
+ * reuse the space of several smaller ones.
+ */
+struct k_HeapRange_t {
+    uint8_t* address;
+    size_t size;
+    struct k_HeapRange_t* next;
+};
+
+typedef struct k_HeapRange_t k_HeapRange_t;
+
+static k_HeapRange_t* freeRanges = NULL;
+
+/* Pages are handed out from a single reservation, so that every object can be
+ * addressed with a 32-bit offset from the base. The reservation does not commit
+ * any memory; the kernel backs the pages when they are first touched. The
+ * first unmapped range that is large enough is reused before the top of the
+ * heap is advanced.
+ */
+void* mapPages(size_t size) {
+    if (k_heapBase == NULL) {
+        void* address = mmap(K_HEAP_BASE_HINT, K_HEAP_CAPACITY, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (address == MAP_FAILED) {
+            return MAP_FAILED;
+        }
+        k_heapBase = (uint8_t*)address;
+        heapTop = k_heapBase;
+    }
+
+    k_HeapRange_t* previous = NULL;
+    k_HeapRange_t* range = freeRanges;
+    while (range != NULL) {
+        if (range->size >= size) {
+            void* result = range->address;
+            range->address += size;
+            range->size -= size;
+            if (range->size == 0) {
+                if (previous != NULL) {
+                    previous->next = range->next;
+                }
+                else {
+                    freeRanges = range->next;
+                }
+                free(range);
+            }
+            return result;
+        }
+        previous = range;
+        range = range->next;
+    }
+
+    if (size > (size_t)(k_heapBase + K_HEAP_CAPACITY - heapTop)) {
+        return MAP_FAILED;
+    }
+
+    void* result = heapTop;
+    heapTop += size;
+    return result;
+}
+
+/* The pages are returned to the kernel, and their addresses are recorded for
+ * reuse.
+ */
+int unmapPages(void* address, size_t size) {
+    if (madvise(address, size, MADV_DONTNEED) == -1) {
+        return -1;
+    }
+
+    uint8_t* start = (uint8_t*)address;
+    uint8_t* end = start + size;
+    k_HeapRange_t* previous = NULL;
+    k_HeapRange_t* next = freeRanges;
+    while ((next != NULL) && (next->address < start)) {
+        previous = next;
+        next = next->next;
+    }
+
+    if ((previous != NULL) && (previous->address + previous->size == start)) {
+        previous->size += size;
+        if ((next != NULL) && (end == next->address)) {
+            previous->size += next->size;
+            previous->next = next->next;
+            free(next);
+        }
+    }
+    else if ((next != NULL) && (end == next->address)) {
+        next->address = start;
+        next->size += size;
+    }
+    else {
+        k_HeapRange_t* range = malloc(sizeof (k_HeapRange_t));
+        if (range == NULL) {
+            return -1;
+        }
+        range->address = start;
+        range->size = size;
+        range->next = next;
+        if (previous != NULL) {
+            previous->next = range;
+        }
+        else {
+            freeRanges = range;
+        }
+    }
+    return 0;
+}
+
+#else
+
+void* mapPages(size_t size) {
+    return mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+
+int unmapPages(void* address, size_t size) {
+    return munmap(address, size);
+}
+
+#endif
 
 int32_t countFreeLists(k_Allocator_t* allocator) {
     int result = 0;
@@ -96,20 +246,27 @@ void insertFreeList(k_Allocator_t* allocator, k_FreeList_t* freeList) {
     }
 }
 
+/* The allocator has no access to the stack frames. Therefore, only the
+ * requested size is reported.
+ */
+void reportOutOfMemory(size_t size) {
+    k_Output_flush();
+    fprintf(stderr, "[error] Out of memory while allocating %zu bytes.\n", size);
+    exit(1);
+}
+
 void addPage(k_Allocator_t* allocator) {
-    void* address = mmap(NULL, K_PAGE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
-            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void* address = mapPages(K_PAGE_SIZE);
 
-    if ((intptr_t)address == -1) {
-        printf("[internal error] Failed to map a page.\n");
-    }
-    else {
-        k_FreeList_t* freeList = (k_FreeList_t*)address;
-        freeList->size = K_PAGE_SIZE;
-        freeList->next = NULL;
-        insertFreeList(allocator, freeList);
-        allocator->statistics.pagesMapped++;
+    if (address == MAP_FAILED) {
+        reportOutOfMemory(K_PAGE_SIZE);
     }
+
+    k_FreeList_t* freeList = (k_FreeList_t*)address;
+    freeList->size = K_PAGE_SIZE;
+    freeList->next = NULL;
+    insertFreeList(allocator, freeList);
+    allocator->statistics.pagesMapped++;
 }
 
 k_FreeList_t* findChunk(k_Allocator_t* allocator, size_t size) {
@@ -173,26 +330,21 @@ size_t divide(size_t a, size_t b) {
 #define OBJECT_HEADER_SIZE sizeof (size_t)
 
 void* allocateLarge(k_Allocator_t* allocator, size_t size) {
-    int pageCount = divide(size, K_PAGE_SIZE);
+    size_t pageCount = divide(size, K_PAGE_SIZE);
 
     /* Map enough pages for the large allocation. */
-    uint8_t* address = (uint8_t*)mmap(NULL, pageCount * K_PAGE_SIZE,
-        PROT_READ | PROT_WRITE | PROT_EXEC, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-
-    uint8_t* result = NULL;
-    if ((intptr_t)address == -1) {
-        printf("[internal error] Failed to map a large page.\n");
+    uint8_t* address = (uint8_t*)mapPages(pageCount * K_PAGE_SIZE);
+    if (address == MAP_FAILED) {
+        reportOutOfMemory(size);
     }
-    else {
-        k_FreeList_t* newChunk = (k_FreeList_t*)address;
-        newChunk->size = pageCount * K_PAGE_SIZE;
-        newChunk->next = NULL;
 
-        allocator->statistics.pagesMapped += pageCount;
+    k_FreeList_t* newChunk = (k_FreeList_t*)address;
+    newChunk->size = pageCount * K_PAGE_SIZE;
+    newChunk->next = NULL;
 
-        result = address + OBJECT_HEADER_SIZE;
-    }
-    return result;
+    allocator->statistics.pagesMapped += pageCount;
+
+    return address;
 }
 
 void k_Allocator_initialize(k_Allocator_t* allocator) {
@@ -208,30 +360,42 @@ void k_Allocator_initialize(k_Allocator_t* allocator) {
 void k_Allocator_destroy(k_Allocator_t* allocator) {
 }
 
-void* k_Allocator_allocate(k_Allocator_t* allocator, size_t size) {
+K_FAST_PATH void* k_Allocator_allocate(k_Allocator_t* allocator, size_t size) {
     void* result = NULL;
     if (size > 0) {
+        /* The rounded size below must not wrap around. */
+        if (size > SIZE_MAX - OBJECT_HEADER_SIZE - 7) {
+            reportOutOfMemory(size);
+        }
+
         /* The chunk size requested does not include the header. Therefore,
          * we add the header size to the requested size to evaluate the
          * true size.
          */
         size += OBJECT_HEADER_SIZE;
+        /* Every chunk starts at a multiple of 8 bytes. Compressed references
+         * rely on this alignment.
+         */
+        size = (size + 7) & ~(size_t)7;
 
-        // TODO: Check for integer overflows!
-
+        uint8_t* address = NULL;
         if (size > K_PAGE_SIZE) {
-            result = allocateLarge(allocator, size);
-            printf("TODO: Came here!\n");
+            /* Strings with a few thousand bytes are common. Therefore, large
+             * objects are tracked just like the others, so that the collector
+             * can reclaim them.
+             */
+            address = (uint8_t*)allocateLarge(allocator, size);
         }
         else {
-            uint8_t* address = (uint8_t*)findChunk(allocator, size);
-
+            address = (uint8_t*)findChunk(allocator, size);
             allocator->statistics.chunksAllocated++;
+        }
 
+        if (address != NULL) {
             result = address + OBJECT_HEADER_SIZE;
 
             k_Object_t* object = (k_Object_t*)result;
-            object->header.marked = false;
+            object->header.marked = !sense;
             object->header.next = allocator->firstObject;
             allocator->firstObject = object;
         }
@@ -248,8 +412,8 @@ void k_Allocator_deallocate(k_Allocator_t* allocator, void* object) {
 
         chunk->next = NULL;
         if (chunk->size > K_PAGE_SIZE) {
-            int32_t pages = divide(chunk->size, K_PAGE_SIZE);
-            int result = munmap(chunk, chunk->size);
+            size_t pages = divide(chunk->size, K_PAGE_SIZE);
+            int result = unmapPages(chunk, chunk->size);
             if (result == -1) {
                 printf("[internal error] Failed to unmap large page.\n");
                 perror("system");
@@ -279,13 +443,14 @@ void k_Allocator_deallocate(k_Allocator_t* allocator, void* object) {
 
 
 
-void kush_main();
+void kush_main(k_Runtime_t* runtime);
 
 void printStats(k_Runtime_t* runtime) {
 	k_AllocatorStatistics_t* statistics = &runtime->allocator->statistics;
+    k_Output_flush();
     printf("[Allocator Statistics]\n");
-    printf("Pages Mapped -> %d\n", statistics->pagesMapped);
-    printf("Pages Unmapped -> %d\n", statistics->pagesUnmapped);
+    printf("Pages Mapped -> %zu\n", statistics->pagesMapped);
+    printf("Pages Unmapped -> %zu\n", statistics->pagesUnmapped);
     printf("Chunks Allocated -> %d\n", statistics->chunksAllocated);
     printf("Chunks Freed -> %d\n", statistics->chunksFreed);
     printf("Free Lists Count -> %d\n", statistics->freeLength);
@@ -299,25 +464,10 @@ void kush_GC_printStats(k_Runtime_t* runtime) {
     k_Runtime_popStackFrame(runtime);
 }
 
-void kush_print_i(k_Runtime_t* runtime, int32_t i) {
-    k_Runtime_pushStackFrame(runtime, "print_i", 7, 0);
-
-    printf("%d", (int32_t)i);
-
-    k_Runtime_popStackFrame(runtime);
-}
-
-void kush_print_s(k_Runtime_t* runtime, k_String_t* s) {
-    k_Runtime_pushStackFrame(runtime, "print_s", 7, 0);
-
-    printf("%.*s", s->value->size, s->value->value);
-
-    k_Runtime_popStackFrame(runtime);
-}
-
 void kush_printStackTrace(k_Runtime_t* runtime) {
     k_Runtime_pushStackFrame(runtime, "printStackTrace", 15, 0);
 
+    k_Output_flush();
     printf("[Stack Trace]\n");
     k_StackFrame_t* current = runtime->stackFrames;
     while (current != NULL) {
@@ -352,10 +502,11 @@ void k_Runtime_initialize(k_Runtime_t* runtime, k_Allocator_t* allocator) {
 }
 
 // TODO: Does the allocate function return NULL when the size is 0?
-k_StackFrame_t* k_Runtime_pushStackFrame(k_Runtime_t* runtime, const uint8_t* name,
-    int32_t nameSize, int32_t pointerCount) {
+K_FAST_PATH k_StackFrame_t* k_Runtime_pushStackFrame(k_Runtime_t* runtime,
+    const uint8_t* name, int32_t nameSize, int32_t pointerCount) {
     k_StackFrame_t* stackFrame = malloc(sizeof (k_StackFrame_t));
-    stackFrame->pointers = malloc(sizeof (void*) * pointerCount);
+    /* The collector may scan a frame before all its references are assigned. */
+    stackFrame->pointers = calloc(pointerCount, sizeof (void*));
     stackFrame->pointerCount = pointerCount;
     stackFrame->functionName = strdup(name);
     stackFrame->next = runtime->stackFrames;
@@ -366,7 +517,7 @@ k_StackFrame_t* k_Runtime_pushStackFrame(k_Runtime_t* runtime, const uint8_t* na
     return stackFrame;
 }
 
-void k_Runtime_popStackFrame(k_Runtime_t* runtime) {
+K_FAST_PATH void k_Runtime_popStackFrame(k_Runtime_t* runtime) {
     if (runtime->stackFrames != NULL) {
         k_StackFrame_t* temporary = runtime->stackFrames;
         runtime->stackFrames = runtime->stackFrames->next;
@@ -378,9 +529,34 @@ void k_Runtime_popStackFrame(k_Runtime_t* runtime) {
     }
 }
 
+static void printErrorStackTrace(k_Runtime_t* runtime) {
+    fprintf(stderr, "[Stack Trace]\n");
+    k_StackFrame_t* current = runtime->stackFrames;
+    while (current != NULL) {
+        fprintf(stderr, "    %s()\n", current->functionName);
+        current = current->next;
+    }
+}
+
+void k_Runtime_throwIndexOutOfBounds(k_Runtime_t* runtime, int64_t index, int64_t size) {
+    k_Output_flush();
+    fprintf(stderr, "[error] Index %" PRId64 " is out of bounds for size %" PRId64 ".\n",
+        index, size);
+    printErrorStackTrace(runtime);
+    exit(1);
+}
+
+void k_Runtime_throwStringTooLarge(k_Runtime_t* runtime, int64_t size) {
+    k_Output_flush();
+    fprintf(stderr, "[error] The string size %" PRId64 " exceeds the maximum of %d bytes.\n",
+        size, K_STRING_MAX_SIZE);
+    printErrorStackTrace(runtime);
+    exit(1);
+}
+
 // TODO: Make sure we either mark array->value or allocate it with the "manual"
 // flag.
-k_Array_t* newPrimitiveArray(k_Runtime_t* runtime, int32_t width, int32_t size) {
+k_Array_t* newPrimitiveArray(k_Runtime_t* runtime, int32_t width, int64_t size) {
     // k_Object_t* internal = (k_Object_t*)k_Allocator_allocate(runtime->allocator,
     //     (sizeof (uint8_t) * size * width) + sizeof (k_ObjectHeader_t));
     // internal->header.type = K_OBJECT_RUNTIME;
@@ -388,32 +564,37 @@ k_Array_t* newPrimitiveArray(k_Runtime_t* runtime, int32_t width, int32_t size)
     k_Array_t* array = k_Allocator_allocate(runtime->allocator, sizeof (k_Array_t));
     array->header.type = K_OBJECT_PRIMITIVE_ARRAY;
     array->size = size;
-    array->value = malloc(sizeof (uint8_t) * width * size); //(void**)(((uint8_t*)internal) + sizeof (k_ObjectHeader_t));
+    array->value = malloc((size_t)width * size); //(void**)(((uint8_t*)internal) + sizeof (k_ObjectHeader_t));
+    if ((array->value == NULL) && (size > 0)) {
+        reportOutOfMemory((size_t)width * size);
+    }
     return array;
 }
 
 // TODO: Move k_ObjectHeader_t to the allocator instead of "user space".
-k_Array_t* newReferenceArray(k_Runtime_t* runtime, int32_t size) {
+k_Array_t* newReferenceArray(k_Runtime_t* runtime, int64_t size) {
     k_Object_t* internal = (k_Object_t*)k_Allocator_allocate(runtime->allocator,
-        (sizeof (void*) * size) + sizeof (k_ObjectHeader_t));
+        (sizeof (k_Reference_t) * size) + sizeof (k_ObjectHeader_t));
     internal->header.type = K_OBJECT_RUNTIME;
 
     k_Array_t* array = k_Allocator_allocate(runtime->allocator, sizeof (k_Array_t));
     array->header.type = K_OBJECT_REFERENCE_ARRAY;
     array->size = size;
-    array->value = (void**)(((uint8_t*)internal) + sizeof (k_ObjectHeader_t));
+    array->value = (k_Reference_t*)(((uint8_t*)internal) + sizeof (k_ObjectHeader_t));
+    /* The collector traces every element, so they must be valid references. */
+    memset(array->value, 0, sizeof (k_Reference_t) * size);
     return array;
 }
 
 // TODO: Should we allow `new i32[5, 5](10)`, where (10) is the default value?
-k_Array_t* makeArray_i32(k_Runtime_t* runtime, int32_t dimensions, ...) {
+void* makeArray_i32(k_Runtime_t* runtime, int32_t dimensions, ...) {
     va_list list;
     va_start(list, dimensions);
 
-    int32_t sizes[dimensions];
+    int64_t sizes[dimensions];
     int32_t i;
     for (i = 0; i < dimensions; i++) {
-        sizes[i] = va_arg(list, int32_t);
+        sizes[i] = va_arg(list, int64_t);
     }
 
     va_end(list);
@@ -421,31 +602,30 @@ k_Array_t* makeArray_i32(k_Runtime_t* runtime, int32_t dimensions, ...) {
     return makeArrayEx_i32(runtime, dimensions, sizes, 1, 0);
 }
 
-k_Array_t* makeArrayEx_i32(k_Runtime_t* runtime, int32_t dimensions, int32_t* sizes,
+k_Array_t* makeArrayEx_i32(k_Runtime_t* runtime, int32_t dimensions, int64_t* sizes,
     int32_t current, int32_t defaultValue) {
     k_Array_t* result = NULL;
-    int32_t currentSize = sizes[current - 1];
+    int64_t currentSize = sizes[current - 1];
     if (current == dimensions) {
         result = newPrimitiveArray(runtime, sizeof (int32_t), currentSize);
         int32_t* value = (int32_t*)result->value;
-        int32_t i;
+        int64_t i;
         for (i = 0; i < currentSize; i++) {
             value[i] = defaultValue;
         }
     }
     else {
         result = newReferenceArray(runtime, currentSize);
-        void** value = (void**)result->value;
-        int32_t i;
+        int64_t i;
         for (i = 0; i < currentSize; i++) {
-            value[i] = makeArrayEx_i32(runtime, dimensions, sizes, current + 1,
-                defaultValue);
+            result->value[i] = K_ENCODE(makeArrayEx_i32(runtime, dimensions, sizes,
+                current + 1, defaultValue));
         }
     }
     return result;
 }
 
-k_Array_t* makeArrayEx_ref(k_Runtime_t* runtime, int32_t dimensions, int32_t* sizes,
+k_Array_t* makeArrayEx_ref(k_Runtime_t* runtime, int32_t dimensions, int64_t* sizes,
     int32_t current, int32_t defaultValue);
 
 // TODO: Should we allow `new i32[5, 5](10)`, where (10) is the default value?
@@ -453,10 +633,10 @@ k_Array_t* makeArray_ref(k_Runtime_t* runtime, int32_t dimensions, ...) {
     va_list list;
     va_start(list, dimensions);
 
-    int32_t sizes[dimensions];
+    int64_t sizes[dimensions];
     int32_t i;
     for (i = 0; i < dimensions; i++) {
-        sizes[i] = va_arg(list, int32_t);
+        sizes[i] = va_arg(list, int64_t);
     }
 
     va_end(list);
@@ -464,25 +644,20 @@ k_Array_t* makeArray_ref(k_Runtime_t* runtime, int32_t dimensions, ...) {
     return makeArrayEx_ref(runtime, dimensions, sizes, 1, 0);
 }
 
-k_Array_t* makeArrayEx_ref(k_Runtime_t* runtime, int32_t dimensions, int32_t* sizes,
+k_Array_t* makeArrayEx_ref(k_Runtime_t* runtime, int32_t dimensions, int64_t* sizes,
     int32_t current, int32_t defaultValue) {
     k_Array_t* result = NULL;
-    int32_t currentSize = sizes[current - 1];
+    int64_t currentSize = sizes[current - 1];
     if (current == dimensions) {
+        /* The elements are initialized to `null`. */
         result = newReferenceArray(runtime, currentSize);
-        int32_t* value = (int32_t*)result->value;
-        int32_t i;
-        for (i = 0; i < currentSize; i++) {
-            value[i] = defaultValue;
-        }
     }
     else {
         result = newReferenceArray(runtime, currentSize);
-        void** value = (void**)result->value;
-        int32_t i;
+        int64_t i;
         for (i = 0; i < currentSize; i++) {
-            value[i] = makeArrayEx_i32(runtime, dimensions, sizes, current + 1,
-                defaultValue);
+            result->value[i] = K_ENCODE(makeArrayEx_ref(runtime, dimensions, sizes,
+                current + 1, defaultValue));
         }
     }
     return result;
@@ -513,10 +688,9 @@ k_Array_t* arrayLiteral_ref(k_Runtime_t* runtime, int32_t size, ...) {
     va_start(list, size);
 
     k_Array_t* result = newReferenceArray(runtime, size);
-    void** value = (void**)result->value;
     int32_t i;
     for (i = 0; i < size; i++) {
-        value[i] = va_arg(list, void*);
+        result->value[i] = K_ENCODE(va_arg(list, void*));
     }
 
     va_end(list);
@@ -524,67 +698,1846 @@ k_Array_t* arrayLiteral_ref(k_Runtime_t* runtime, int32_t size, ...) {
     return result;
 }
 
-k_String_t* makeString(k_Runtime_t* runtime, const char* sequence) {
-    k_String_t* self = k_Allocator_allocate(runtime->allocator,
-        sizeof (k_String_t));
-    self->header.type = K_OBJECT_STRING;
-    int32_t size = strlen(sequence);
-    k_ArrayUi8_t* value = malloc(sizeof(k_ArrayUi8_t));
-    value->value = malloc(sizeof (uint8_t) * (size + 1));
-    value->size = size;
+/* Creates a boolean array whose elements are `false`. */
+k_ArrayBoolean_t* newBitArray(k_Runtime_t* runtime, int64_t size) {
+    int64_t words = (size + 63) >> 6;
+    k_ArrayBoolean_t* array = (k_ArrayBoolean_t*)newPrimitiveArray(runtime,
+        sizeof (uint64_t), words);
+    array->size = size;
+    memset(array->value, 0, sizeof (uint64_t) * words);
+    return array;
+}
+
+/* Creates the arrays of the specified dimensions, where the innermost arrays
+ * store primitive elements of the specified width. The elements are
+ * initialized to zero. A width of zero creates bit-packed boolean arrays.
+ */
+static k_Array_t* makePrimitiveArray(k_Runtime_t* runtime, int32_t width,
+    int32_t dimensions, int64_t* sizes, int32_t current) {
+    k_Array_t* result = NULL;
+    int64_t currentSize = sizes[current - 1];
+    if (current == dimensions) {
+        if (width == 0) {
+            result = (k_Array_t*)newBitArray(runtime, currentSize);
+        }
+        else {
+            result = newPrimitiveArray(runtime, width, currentSize);
+            memset(result->value, 0, (size_t)width * currentSize);
+        }
+    }
+    else {
+        result = newReferenceArray(runtime, currentSize);
+        int64_t i;
+        for (i = 0; i < currentSize; i++) {
+            result->value[i] = K_ENCODE(makePrimitiveArray(runtime, width, dimensions,
+                sizes, current + 1));
+        }
+    }
+    return result;
+}
+
+/* The variable arguments of the array literals undergo the default argument
+ * promotions. Therefore, each element type specifies the type it is read as.
+ */
+#define K_DEFINE_ARRAY_FACTORIES(suffix, Array, Element, Promoted) \
+    void* makeArray_##suffix(k_Runtime_t* runtime, int32_t dimensions, ...) { \
+        va_list list; \
+        va_start(list, dimensions); \
+        \
+        int64_t sizes[dimensions]; \
+        int32_t i; \
+        for (i = 0; i < dimensions; i++) { \
+            sizes[i] = va_arg(list, int64_t); \
+        } \
+        \
+        va_end(list); \
+        \
+        return makePrimitiveArray(runtime, sizeof (Element), dimensions, sizes, 1); \
+    } \
+    \
+    Array* arrayLiteral_##suffix(k_Runtime_t* runtime, int32_t size, ...) { \
+        va_list list; \
+        va_start(list, size); \
+        \
+        Array* array = (Array*)newPrimitiveArray(runtime, sizeof (Element), size); \
+        int32_t i; \
+        for (i = 0; i < size; i++) { \
+            array->value[i] = (Element)va_arg(list, Promoted); \
+        } \
+        \
+        va_end(list); \
+        \
+        return array; \
+    }
+
+void* makeArray_boolean(k_Runtime_t* runtime, int32_t dimensions, ...) {
+    va_list list;
+    va_start(list, dimensions);
+
+    int64_t sizes[dimensions];
+    int32_t i;
+    for (i = 0; i < dimensions; i++) {
+        sizes[i] = va_arg(list, int64_t);
+    }
 
-    self->value = value;
+    va_end(list);
+
+    return makePrimitiveArray(runtime, 0, dimensions, sizes, 1);
+}
+
+k_ArrayBoolean_t* arrayLiteral_boolean(k_Runtime_t* runtime, int32_t size, ...) {
+    va_list list;
+    va_start(list, size);
 
+    k_ArrayBoolean_t* array = newBitArray(runtime, size);
     int32_t i;
     for (i = 0; i < size; i++) {
-        value->value[i] = sequence[i];
+        k_BitArray_set(array, i, (bool)va_arg(list, int));
     }
-    value->value[i] = '\0';
+
+    va_end(list);
+
+    return array;
+}
+
+K_DEFINE_ARRAY_FACTORIES(i8, k_ArrayI8_t, int8_t, int)
+K_DEFINE_ARRAY_FACTORIES(i16, k_ArrayI16_t, int16_t, int)
+K_DEFINE_ARRAY_FACTORIES(i64, k_ArrayI64_t, int64_t, int64_t)
+K_DEFINE_ARRAY_FACTORIES(ui8, k_ArrayUi8_t, uint8_t, int)
+K_DEFINE_ARRAY_FACTORIES(ui16, k_ArrayUi16_t, uint16_t, int)
+K_DEFINE_ARRAY_FACTORIES(ui32, k_ArrayUi32_t, uint32_t, uint32_t)
+K_DEFINE_ARRAY_FACTORIES(ui64, k_ArrayUi64_t, uint64_t, uint64_t)
+K_DEFINE_ARRAY_FACTORIES(f32, k_ArrayF32_t, float, double)
+K_DEFINE_ARRAY_FACTORIES(f64, k_ArrayF64_t, double, double)
+
+/* Allocates a string whose bytes are yet to be initialized. The caller is
+ * responsible for filling all the `size` bytes.
+ */
+static k_String_t* allocateString(k_Runtime_t* runtime, int32_t size) {
+    /* The header, the bytes, and the null terminator are allocated as a single
+     * chunk.
+     */
+    k_String_t* self = k_Allocator_allocate(runtime->allocator,
+        sizeof (k_String_t) + (sizeof (uint8_t) * ((size_t)size + 1)));
+    self->header.type = K_OBJECT_STRING;
+    self->size = size;
+    self->hash = 0;
+    self->value[size] = '\0';
     return self;
 }
 
-bool sense = true;
+k_String_t* newString(k_Runtime_t* runtime, const uint8_t* value, int32_t size) {
+    k_String_t* self = allocateString(runtime, size);
+    memcpy(self->value, value, size);
+    return self;
+}
 
-// BUG: The internal buffer used by the array is not marked.
-void markObject(k_Runtime_t* runtime, k_Object_t* object) {
-    object->header.marked = sense;
-    switch (object->header.type) {
-        case K_OBJECT_PRIMITIVE_ARRAY: {
-            k_Array_t* array = (k_Array_t*)array;
-            int32_t i;
-            for (i = 0; i < array->size; i++) {
-                k_Object_t* element = (k_Object_t*)array->value[i];
-                markObject(runtime, element);
+k_String_t* makeString(k_Runtime_t* runtime, const char* sequence) {
+    return newString(runtime, (const uint8_t*)sequence, strlen(sequence));
+}
+
+/* The hash is evaluated with the 32-bit FNV-1a function the first time it is
+ * requested. Strings are immutable, so the result is cached in the header.
+ */
+uint32_t k_String_hash(k_String_t* string) {
+    uint32_t result = string->hash;
+    if (result == 0) {
+        result = 2166136261U;
+        int32_t i;
+        for (i = 0; i < string->size; i++) {
+            result ^= string->value[i];
+            result *= 16777619U;
+        }
+
+        /* Zero is reserved to indicate that the hash was not computed. */
+        if (result == 0) {
+            result = 1;
+        }
+        string->hash = result;
+    }
+    return result;
+}
+
+/*******************************************************************************
+ * Array Intrinsics                                                            *
+ *******************************************************************************/
+
+/* Arrays smaller than this are sorted by insertion, which beats the fixed cost
+ * of the radix passes.
+ */
+#define K_INSERTION_SORT_THRESHOLD 48
+
+/* The maximum number of bytes copied at once when filling an array. The block
+ * that is copied from stays in the cache.
+ */
+#define K_FILL_BLOCK_SIZE 16384
+
+static void checkRange(k_Runtime_t* runtime, int64_t index, int64_t size,
+    int64_t arraySize) {
+    if ((index < 0) || (size < 0) || (index > arraySize - size)) {
+        /* Report the first index that is out of bounds. */
+        int64_t invalid = ((index < 0) || (size < 0))? index : arraySize;
+        k_Runtime_throwIndexOutOfBounds(runtime, invalid, arraySize);
+    }
+}
+
+/* Repeats the first element across the array by doubling the filled region.
+ * The copies are delegated to `memcpy`, which is vectorized by the C library.
+ */
+static void fillBytes(uint8_t* destination, const void* value, int32_t width,
+    int64_t count) {
+    if (count > 0) {
+        if (width == 1) {
+            memset(destination, *(const uint8_t*)value, count);
+        }
+        else {
+            size_t total = (size_t)width * count;
+            size_t filled = width;
+            memcpy(destination, value, width);
+            while (filled < total) {
+                size_t chunk = filled;
+                if (chunk > K_FILL_BLOCK_SIZE) {
+                    chunk = K_FILL_BLOCK_SIZE - (K_FILL_BLOCK_SIZE % width);
+                }
+                if (chunk > total - filled) {
+                    chunk = total - filled;
+                }
+                memcpy(destination + filled, destination, chunk);
+                filled += chunk;
+            }
+        }
+    }
+}
+
+/* Sorts unsigned keys with a least significant digit radix sort, one byte per
+ * pass. The histograms for every pass are built in a single scan, and a pass
+ * is skipped when all the keys share the same digit, which is common for small
+ * values stored in wide types.
+ */
+#define K_DEFINE_RADIX_SORT(name, Key) \
+    static void name(Key* keys, int64_t size) { \
+        int64_t i; \
+        if (size < K_INSERTION_SORT_THRESHOLD) { \
+            for (i = 1; i < size; i++) { \
+                Key key = keys[i]; \
+                int64_t j = i - 1; \
+                while ((j >= 0) && (keys[j] > key)) { \
+                    keys[j + 1] = keys[j]; \
+                    j--; \
+                } \
+                keys[j + 1] = key; \
+            } \
+            return; \
+        } \
+        \
+        int64_t counts[sizeof (Key)][256]; \
+        memset(counts, 0, sizeof (counts)); \
+        for (i = 0; i < size; i++) { \
+            Key key = keys[i]; \
+            int32_t digit; \
+            for (digit = 0; digit < (int32_t)sizeof (Key); digit++) { \
+                counts[digit][(key >> (digit * 8)) & 0xFF]++; \
+            } \
+        } \
+        \
+        Key* buffer = (Key*)malloc(sizeof (Key) * size); \
+        Key* source = keys; \
+        Key* destination = buffer; \
+        int32_t digit; \
+        for (digit = 0; digit < (int32_t)sizeof (Key); digit++) { \
+            int64_t* count = counts[digit]; \
+            int32_t shift = digit * 8; \
+            if (count[(source[0] >> shift) & 0xFF] != size) { \
+                int64_t offset = 0; \
+                int64_t j; \
+                for (j = 0; j < 256; j++) { \
+                    int64_t current = count[j]; \
+                    count[j] = offset; \
+                    offset += current; \
+                } \
+                \
+                for (i = 0; i < size; i++) { \
+                    Key key = source[i]; \
+                    destination[count[(key >> shift) & 0xFF]++] = key; \
+                } \
+                \
+                Key* temporary = source; \
+                source = destination; \
+                destination = temporary; \
+            } \
+        } \
+        \
+        if (source != keys) { \
+            memcpy(keys, source, sizeof (Key) * size); \
+        } \
+        free(buffer); \
+    }
+
+K_DEFINE_RADIX_SORT(radixSort8, uint8_t)
+K_DEFINE_RADIX_SORT(radixSort16, uint16_t)
+K_DEFINE_RADIX_SORT(radixSort32, uint32_t)
+K_DEFINE_RADIX_SORT(radixSort64, uint64_t)
+
+/* The elements are mapped to unsigned keys which preserve their order. Signed
+ * integers have their sign bit flipped. Floating point values have all their
+ * bits flipped when negative, and only the sign bit flipped otherwise.
+ */
+#define K_SIGN_BIT(Key) ((Key)((Key)1 << (sizeof (Key) * 8 - 1)))
+#define K_ENCODE_UNSIGNED(key, Key) (key)
+#define K_DECODE_UNSIGNED(key, Key) (key)
+#define K_ENCODE_SIGNED(key, Key) ((Key)((key) ^ K_SIGN_BIT(Key)))
+#define K_DECODE_SIGNED(key, Key) ((Key)((key) ^ K_SIGN_BIT(Key)))
+#define K_ENCODE_FLOAT(key, Key) \
+    ((Key)(((key) & K_SIGN_BIT(Key))? ~(key) : ((key) | K_SIGN_BIT(Key))))
+#define K_DECODE_FLOAT(key, Key) \
+    ((Key)(((key) & K_SIGN_BIT(Key))? ((key) ^ K_SIGN_BIT(Key)) : ~(key)))
+
+#define K_DEFINE_ARRAY_INTRINSICS(suffix, Array, Element) \
+    void kush_Array_copy_##suffix(k_Runtime_t* runtime, Array* source, \
+        int64_t sourceIndex, Array* destination, int64_t destinationIndex, \
+        int64_t size) { \
+        checkRange(runtime, sourceIndex, size, source->size); \
+        checkRange(runtime, destinationIndex, size, destination->size); \
+        memmove(destination->value + destinationIndex, source->value + sourceIndex, \
+            sizeof (Element) * size); \
+    } \
+    \
+    void kush_Array_fill_##suffix(k_Runtime_t* runtime, Array* array, \
+        Element value) { \
+        fillBytes((uint8_t*)array->value, &value, sizeof (Element), array->size); \
+    }
+
+/* The keys are written over the elements, which are accessed through `memcpy`
+ * to avoid breaking the aliasing rules for floating point values.
+ */
+#define K_DEFINE_ORDERED_ARRAY_INTRINSICS(suffix, Array, Element, Key, radixSort, \
+    encode, decode) \
+    K_DEFINE_ARRAY_INTRINSICS(suffix, Array, Element) \
+    \
+    void kush_Array_sort_##suffix(k_Runtime_t* runtime, Array* array) { \
+        int64_t size = array->size; \
+        Key* keys = (Key*)array->value; \
+        int64_t i; \
+        for (i = 0; i < size; i++) { \
+            Key key; \
+            memcpy(&key, &array->value[i], sizeof (Key)); \
+            keys[i] = encode(key, Key); \
+        } \
+        \
+        radixSort(keys, size); \
+        \
+        for (i = 0; i < size; i++) { \
+            Key key = decode(keys[i], Key); \
+            memcpy(&array->value[i], &key, sizeof (Key)); \
+        } \
+    } \
+    \
+    int64_t kush_Array_binarySearch_##suffix(k_Runtime_t* runtime, Array* array, \
+        Element key) { \
+        const Element* values = array->value; \
+        int64_t first = 0; \
+        int64_t length = array->size; \
+        /* The loop finds the lower bound. The comparison is used to select \
+         * the next range, without a branch. \
+         */ \
+        while (length > 0) { \
+            int64_t half = length >> 1; \
+            bool less = values[first + half] < key; \
+            first = less? first + half + 1 : first; \
+            length = less? length - half - 1 : half; \
+        } \
+        \
+        return ((first < array->size) && (values[first] == key))? first : -(first + 1); \
+    }
+
+/* Reads the 64 bits that start at the specified index. The bits past the last
+ * word are read as zero.
+ */
+static uint64_t readBits(const uint64_t* words, int64_t wordCount, int64_t index) {
+    int64_t word = K_BIT_WORD(index);
+    int32_t shift = index & 63;
+    uint64_t result = words[word] >> shift;
+    if ((shift != 0) && (word + 1 < wordCount)) {
+        result |= words[word + 1] << (64 - shift);
+    }
+    return result;
+}
+
+/* Writes the lower `count` bits of the value, starting at the specified index.
+ * The count ranges from 1 to 64.
+ */
+static void writeBits(uint64_t* words, int64_t index, uint64_t value, int32_t count) {
+    int64_t word = K_BIT_WORD(index);
+    int32_t shift = index & 63;
+    uint64_t mask = (count == 64)? ~(uint64_t)0 : (K_BIT_MASK(count) - 1);
+    value &= mask;
+    words[word] = (words[word] & ~(mask << shift)) | (value << shift);
+    if (shift + count > 64) {
+        uint64_t spill = K_BIT_MASK(shift + count - 64) - 1;
+        words[word + 1] = (words[word + 1] & ~spill) | (value >> (64 - shift));
+    }
+}
+
+/* Clears the unused bits of the last word. */
+static void clearTail(k_ArrayBoolean_t* array) {
+    int32_t used = array->size & 63;
+    if (used != 0) {
+        array->value[K_BIT_WORD(array->size)] &= K_BIT_MASK(used) - 1;
+    }
+}
+
+/* The bits are copied 64 at a time. When the ranges overlap and the
+ * destination follows the source, the chunks are copied from the end.
+ */
+void kush_Array_copy_boolean(k_Runtime_t* runtime, k_ArrayBoolean_t* source,
+    int64_t sourceIndex, k_ArrayBoolean_t* destination, int64_t destinationIndex,
+    int64_t size) {
+    checkRange(runtime, sourceIndex, size, source->size);
+    checkRange(runtime, destinationIndex, size, destination->size);
+
+    int64_t wordCount = (source->size + 63) >> 6;
+    if ((source == destination) && (destinationIndex > sourceIndex)) {
+        int64_t remaining = size;
+        while (remaining > 0) {
+            int32_t count = (remaining < 64)? remaining : 64;
+            remaining -= count;
+            uint64_t bits = readBits(source->value, wordCount, sourceIndex + remaining);
+            writeBits(destination->value, destinationIndex + remaining, bits, count);
+        }
+    }
+    else {
+        int64_t copied = 0;
+        while (copied < size) {
+            int32_t count = (size - copied < 64)? (size - copied) : 64;
+            uint64_t bits = readBits(source->value, wordCount, sourceIndex + copied);
+            writeBits(destination->value, destinationIndex + copied, bits, count);
+            copied += count;
+        }
+    }
+}
+
+void kush_Array_fill_boolean(k_Runtime_t* runtime, k_ArrayBoolean_t* array,
+    bool value) {
+    memset(array->value, value? 0xFF : 0, sizeof (uint64_t) * ((array->size + 63) >> 6));
+    clearTail(array);
+}
+
+/* The words are counted with four accumulators, which hides the latency of the
+ * population count instruction.
+ */
+int64_t kush_BitArray_count(k_Runtime_t* runtime, k_ArrayBoolean_t* array) {
+    const uint64_t* words = array->value;
+    int64_t wordCount = (array->size + 63) >> 6;
+    int64_t counts[4] = { 0, 0, 0, 0 };
+    int64_t i;
+    for (i = 0; i + 4 <= wordCount; i += 4) {
+        counts[0] += __builtin_popcountll(words[i]);
+        counts[1] += __builtin_popcountll(words[i + 1]);
+        counts[2] += __builtin_popcountll(words[i + 2]);
+        counts[3] += __builtin_popcountll(words[i + 3]);
+    }
+    for (; i < wordCount; i++) {
+        counts[0] += __builtin_popcountll(words[i]);
+    }
+    return counts[0] + counts[1] + counts[2] + counts[3];
+}
+
+int64_t kush_BitArray_findFirst(k_Runtime_t* runtime, k_ArrayBoolean_t* array,
+    int64_t fromIndex) {
+    if ((fromIndex < 0) || (fromIndex > array->size)) {
+        k_Runtime_throwIndexOutOfBounds(runtime, fromIndex, array->size);
+    }
+
+    int64_t result = -1;
+    int64_t wordCount = (array->size + 63) >> 6;
+    int64_t i = K_BIT_WORD(fromIndex);
+    if (i < wordCount) {
+        /* The bits before the starting index are ignored. */
+        uint64_t word = array->value[i] & ~(K_BIT_MASK(fromIndex) - 1);
+        while (true) {
+            if (word != 0) {
+                result = (i << 6) + __builtin_ctzll(word);
+                break;
+            }
+            if (++i == wordCount) {
+                break;
+            }
+            word = array->value[i];
+        }
+    }
+    return result;
+}
+
+/* The loops over the words are simple enough to be vectorized by the C
+ * compiler.
+ */
+#define K_DEFINE_BIT_OPERATION(name, operator) \
+    void kush_BitArray_##name(k_Runtime_t* runtime, k_ArrayBoolean_t* destination, \
+        k_ArrayBoolean_t* source) { \
+        checkRange(runtime, 0, destination->size, source->size); \
+        uint64_t* target = destination->value; \
+        const uint64_t* words = source->value; \
+        int64_t wordCount = (destination->size + 63) >> 6; \
+        int64_t i; \
+        for (i = 0; i < wordCount; i++) { \
+            target[i] = target[i] operator words[i]; \
+        } \
+        clearTail(destination); \
+    }
+
+K_DEFINE_BIT_OPERATION(and, &)
+K_DEFINE_BIT_OPERATION(or, |)
+K_DEFINE_BIT_OPERATION(xor, ^)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(i8, k_ArrayI8_t, int8_t, uint8_t, radixSort8,
+    K_ENCODE_SIGNED, K_DECODE_SIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(i16, k_ArrayI16_t, int16_t, uint16_t, radixSort16,
+    K_ENCODE_SIGNED, K_DECODE_SIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(i32, k_IntegerArray_t, int32_t, uint32_t, radixSort32,
+    K_ENCODE_SIGNED, K_DECODE_SIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(i64, k_ArrayI64_t, int64_t, uint64_t, radixSort64,
+    K_ENCODE_SIGNED, K_DECODE_SIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(ui8, k_ArrayUi8_t, uint8_t, uint8_t, radixSort8,
+    K_ENCODE_UNSIGNED, K_DECODE_UNSIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(ui16, k_ArrayUi16_t, uint16_t, uint16_t, radixSort16,
+    K_ENCODE_UNSIGNED, K_DECODE_UNSIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(ui32, k_ArrayUi32_t, uint32_t, uint32_t, radixSort32,
+    K_ENCODE_UNSIGNED, K_DECODE_UNSIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(ui64, k_ArrayUi64_t, uint64_t, uint64_t, radixSort64,
+    K_ENCODE_UNSIGNED, K_DECODE_UNSIGNED)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(f32, k_ArrayF32_t, float, uint32_t, radixSort32,
+    K_ENCODE_FLOAT, K_DECODE_FLOAT)
+K_DEFINE_ORDERED_ARRAY_INTRINSICS(f64, k_ArrayF64_t, double, uint64_t, radixSort64,
+    K_ENCODE_FLOAT, K_DECODE_FLOAT)
+
+/*******************************************************************************
+ * Math Intrinsics                                                             *
+ *******************************************************************************/
+
+/* Each kernel is compiled once for the baseline of the target and, on x86,
+ * once more for AVX2 with FMA. On the baseline, GCC splits every 256-bit
+ * vector into two SSE registers. The reductions keep four accumulators to
+ * hide the latency of the additions.
+ */
+#define K_DEFINE_MATH_KERNELS(suffix, variant, attributes, Element, Vector, lanes) \
+    attributes static Element sum_##suffix##_##variant(const Element* values, \
+        int64_t size) { \
+        Vector accumulators[4] = { { 0 }, { 0 }, { 0 }, { 0 } }; \
+        int64_t i = 0; \
+        for (; i + 4 * (lanes) <= size; i += 4 * (lanes)) { \
+            int32_t j; \
+            for (j = 0; j < 4; j++) { \
+                Vector block; \
+                memcpy(&block, values + i + j * (lanes), sizeof (block)); \
+                accumulators[j] += block; \
+            } \
+        } \
+        Vector total = (accumulators[0] + accumulators[1]) + \
+            (accumulators[2] + accumulators[3]); \
+        Element result = 0; \
+        int32_t j; \
+        for (j = 0; j < (lanes); j++) { \
+            result += total[j]; \
+        } \
+        for (; i < size; i++) { \
+            result += values[i]; \
+        } \
+        return result; \
+    } \
+    \
+    attributes static Element dot_##suffix##_##variant(const Element* x, \
+        const Element* y, int64_t size) { \
+        Vector accumulators[4] = { { 0 }, { 0 }, { 0 }, { 0 } }; \
+        int64_t i = 0; \
+        for (; i + 4 * (lanes) <= size; i += 4 * (lanes)) { \
+            int32_t j; \
+            for (j = 0; j < 4; j++) { \
+                Vector first; \
+                Vector second; \
+                memcpy(&first, x + i + j * (lanes), sizeof (first)); \
+                memcpy(&second, y + i + j * (lanes), sizeof (second)); \
+                accumulators[j] += first * second; \
+            } \
+        } \
+        Vector total = (accumulators[0] + accumulators[1]) + \
+            (accumulators[2] + accumulators[3]); \
+        Element result = 0; \
+        int32_t j; \
+        for (j = 0; j < (lanes); j++) { \
+            result += total[j]; \
+        } \
+        for (; i < size; i++) { \
+            result += x[i] * y[i]; \
+        } \
+        return result; \
+    } \
+    \
+    attributes static void axpy_##suffix##_##variant(Element a, const Element* x, \
+        Element* y, int64_t size) { \
+        int64_t i = 0; \
+        for (; i + (lanes) <= size; i += (lanes)) { \
+            Vector first; \
+            Vector second; \
+            memcpy(&first, x + i, sizeof (first)); \
+            memcpy(&second, y + i, sizeof (second)); \
+            second += a * first; \
+            memcpy(y + i, &second, sizeof (second)); \
+        } \
+        for (; i < size; i++) { \
+            y[i] += a * x[i]; \
+        } \
+    } \
+    \
+    attributes static void scale_##suffix##_##variant(Element* values, int64_t size, \
+        Element factor) { \
+        int64_t i = 0; \
+        for (; i + (lanes) <= size; i += (lanes)) { \
+            Vector block; \
+            memcpy(&block, values + i, sizeof (block)); \
+            block *= factor; \
+            memcpy(values + i, &block, sizeof (block)); \
+        } \
+        for (; i < size; i++) { \
+            values[i] *= factor; \
+        } \
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/* The processor is queried once, the first time a kernel is invoked. */
+static bool hasAvx2() {
+    static int32_t result = -1;
+    if (result < 0) {
+        __builtin_cpu_init();
+        result = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    }
+    return result;
+}
+
+#define K_SELECT_KERNEL(name) (hasAvx2()? name##_avx2 : name##_baseline)
+
+#define K_DEFINE_MATH_VARIANTS(suffix, Element, Vector, lanes) \
+    K_DEFINE_MATH_KERNELS(suffix, baseline, , Element, Vector, lanes) \
+    K_DEFINE_MATH_KERNELS(suffix, avx2, __attribute__((target("avx2,fma"))), \
+        Element, Vector, lanes)
+
+#else
+
+#define K_SELECT_KERNEL(name) name##_baseline
+
+#define K_DEFINE_MATH_VARIANTS(suffix, Element, Vector, lanes) \
+    K_DEFINE_MATH_KERNELS(suffix, baseline, , Element, Vector, lanes)
+
+#endif
+
+#define K_DEFINE_MATH_INTRINSICS(suffix, Array, Element, Vector, lanes) \
+    K_DEFINE_MATH_VARIANTS(suffix, Element, Vector, lanes) \
+    \
+    Element kush_Array_sum_##suffix(k_Runtime_t* runtime, Array* array) { \
+        return K_SELECT_KERNEL(sum_##suffix)(array->value, array->size); \
+    } \
+    \
+    Element kush_Array_dot_##suffix(k_Runtime_t* runtime, Array* x, Array* y) { \
+        checkRange(runtime, 0, x->size, y->size); \
+        return K_SELECT_KERNEL(dot_##suffix)(x->value, y->value, x->size); \
+    } \
+    \
+    void kush_Array_axpy_##suffix(k_Runtime_t* runtime, Element a, Array* x, \
+        Array* y) { \
+        checkRange(runtime, 0, y->size, x->size); \
+        K_SELECT_KERNEL(axpy_##suffix)(a, x->value, y->value, y->size); \
+    } \
+    \
+    void kush_Array_scale_##suffix(k_Runtime_t* runtime, Array* array, \
+        Element factor) { \
+        K_SELECT_KERNEL(scale_##suffix)(array->value, array->size, factor); \
+    }
+
+K_DEFINE_MATH_INTRINSICS(f32, k_ArrayF32_t, float, k_f32x8_t, 8)
+K_DEFINE_MATH_INTRINSICS(f64, k_ArrayF64_t, double, k_f64x4_t, 4)
+
+/*******************************************************************************
+ * String Intrinsics                                                           *
+ *******************************************************************************/
+
+/* The substring search compares the first and the last bytes of the pattern
+ * against a whole block of candidate positions at once. Only the positions
+ * where both the bytes match are verified with `memcmp`. The block is 32 bytes
+ * wide when the runtime is built with AVX2 enabled, and 16 bytes wide with
+ * SSE2, which is available on every x86-64 processor. On other targets, the
+ * search falls back to `memchr`.
+ */
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define K_STRING_BLOCK_SIZE 32
+#elif defined(__SSE2__)
+    #include <emmintrin.h>
+    #define K_STRING_BLOCK_SIZE 16
+#endif
+
+static int32_t findBytes(const uint8_t* text, int32_t textSize,
+    const uint8_t* pattern, int32_t patternSize) {
+    int32_t result = -1;
+    int32_t i = 0;
+
+    if (patternSize == 1) {
+        const uint8_t* position = memchr(text, pattern[0], textSize);
+        return (position == NULL)? -1 : (int32_t)(position - text);
+    }
+
+#if defined(K_STRING_BLOCK_SIZE)
+    #if defined(__AVX2__)
+        __m256i first = _mm256_set1_epi8((char)pattern[0]);
+        __m256i last = _mm256_set1_epi8((char)pattern[patternSize - 1]);
+    #else
+        __m128i first = _mm_set1_epi8((char)pattern[0]);
+        __m128i last = _mm_set1_epi8((char)pattern[patternSize - 1]);
+    #endif
+
+    /* Every candidate position in the block is followed by enough bytes for
+     * the whole pattern, so the blocks never read past the end of the text.
+     */
+    for (; i + patternSize + K_STRING_BLOCK_SIZE - 1 <= textSize;
+        i += K_STRING_BLOCK_SIZE) {
+    #if defined(__AVX2__)
+        __m256i blockFirst = _mm256_loadu_si256((const __m256i*)(text + i));
+        __m256i blockLast = _mm256_loadu_si256(
+            (const __m256i*)(text + i + patternSize - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(first, blockFirst),
+            _mm256_cmpeq_epi8(last, blockLast)));
+    #else
+        __m128i blockFirst = _mm_loadu_si128((const __m128i*)(text + i));
+        __m128i blockLast = _mm_loadu_si128(
+            (const __m128i*)(text + i + patternSize - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(
+            _mm_cmpeq_epi8(first, blockFirst),
+            _mm_cmpeq_epi8(last, blockLast)));
+    #endif
+
+        while (mask != 0) {
+            int32_t offset = __builtin_ctz(mask);
+            if (memcmp(text + i + offset + 1, pattern + 1, patternSize - 2) == 0) {
+                return i + offset;
             }
+            /* Clear the lowest bit. */
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    /* Search the remaining bytes, jumping from one occurrence of the first
+     * byte to the next.
+     */
+    while (i + patternSize <= textSize) {
+        const uint8_t* position = memchr(text + i, pattern[0],
+            textSize - patternSize - i + 1);
+        if (position == NULL) {
             break;
         }
+
+        i = (int32_t)(position - text);
+        if (memcmp(text + i, pattern, patternSize) == 0) {
+            result = i;
+            break;
+        }
+        i++;
     }
+
+    return result;
 }
 
-void markCallStack(k_Runtime_t* runtime) {
-    int32_t count = 0;
-    k_StackFrame_t* current = runtime->stackFrames;
-    while (current != NULL) {
-        int32_t i;
-        for (i = 0; i < current->pointerCount; i++) {
-            k_Object_t* object = (k_Object_t*)current->pointers[i];
-            markObject(runtime, object);
-            count++;
+bool kush_String_equals(k_Runtime_t* runtime, k_String_t* string1, k_String_t* string2) {
+    bool result = (string1 == string2);
+    if (!result && (string1->size == string2->size)) {
+        /* When both the hashes are available, they reject most of the unequal
+         * strings without touching the bytes.
+         */
+        bool hashed = (string1->hash != 0) && (string2->hash != 0);
+        if (!hashed || (string1->hash == string2->hash)) {
+            result = memcmp(string1->value, string2->value, string1->size) == 0;
         }
-        current = current->next;
     }
-    printf("Roots: %d\n", count);
+    return result;
 }
 
-int32_t countObjects(k_Runtime_t* runtime) {
-    k_Object_t* object = runtime->allocator->firstObject;
-    int32_t count = 0;
-    while (object != NULL) {
-        object = object->header.next;
-        count++;
+int32_t kush_String_compare(k_Runtime_t* runtime, k_String_t* string1, k_String_t* string2) {
+    int32_t result = 0;
+    if (string1 != string2) {
+        int32_t size = (string1->size < string2->size)? string1->size : string2->size;
+        result = memcmp(string1->value, string2->value, size);
+        if (result == 0) {
+            result = string1->size - string2->size;
+        }
+        result = (result > 0) - (result < 0);
+    }
+    return result;
+}
+
+int32_t kush_String_hash(k_Runtime_t* runtime, k_String_t* string) {
+    return (int32_t)k_String_hash(string);
+}
+
+int32_t kush_String_indexOf(k_Runtime_t* runtime, k_String_t* string,
+    k_String_t* pattern, int32_t startIndex) {
+    int32_t result = -1;
+    if (startIndex < 0) {
+        startIndex = 0;
+    }
+
+    /* The difference cannot overflow, unlike the sum of the start index and
+     * the size of the pattern.
+     */
+    if (startIndex <= string->size - pattern->size) {
+        if (pattern->size == 0) {
+            result = startIndex;
+        }
+        else {
+            result = findBytes(string->value + startIndex, string->size - startIndex,
+                pattern->value, pattern->size);
+            if (result != -1) {
+                result += startIndex;
+            }
+        }
+    }
+    return result;
+}
+
+k_String_t* kush_String_concat(k_Runtime_t* runtime, k_String_t* string1,
+    k_String_t* string2) {
+    int64_t size = (int64_t)string1->size + string2->size;
+    if (size > K_STRING_MAX_SIZE) {
+        k_Runtime_throwStringTooLarge(runtime, size);
+    }
+    k_String_t* result = allocateString(runtime, (int32_t)size);
+    memcpy(result->value, string1->value, string1->size);
+    memcpy(result->value + string1->size, string2->value, string2->size);
+    return result;
+}
+
+/* The indexes are clamped to the bounds of the string. The result is empty when
+ * the start index is not less than the stop index.
+ */
+k_String_t* kush_String_slice(k_Runtime_t* runtime, k_String_t* string,
+    int32_t startIndex, int32_t stopIndex) {
+    if (startIndex < 0) {
+        startIndex = 0;
+    }
+    if (stopIndex > string->size) {
+        stopIndex = string->size;
+    }
+    int32_t size = (stopIndex > startIndex)? stopIndex - startIndex : 0;
+
+    return newString(runtime, string->value + startIndex, size);
+}
+
+/*******************************************************************************
+ * StringBuilder                                                               *
+ *******************************************************************************/
+
+static const char digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Writes the decimal digits of the specified value, two at a time, and returns
+ * the number of bytes written. The buffer should have room for 20 bytes.
+ */
+static int32_t formatUnsigned(uint8_t* buffer, uint64_t value) {
+    uint8_t digits[20];
+    int32_t index = 20;
+    while (value >= 100) {
+        int32_t pair = (int32_t)(value % 100) * 2;
+        value /= 100;
+        digits[--index] = digitPairs[pair + 1];
+        digits[--index] = digitPairs[pair];
+    }
+    if (value >= 10) {
+        int32_t pair = (int32_t)value * 2;
+        digits[--index] = digitPairs[pair + 1];
+        digits[--index] = digitPairs[pair];
+    }
+    else {
+        digits[--index] = (uint8_t)('0' + value);
+    }
+
+    int32_t size = 20 - index;
+    memcpy(buffer, digits + index, size);
+    return size;
+}
+
+/* The buffer should have room for 20 bytes. */
+static int32_t formatInteger(uint8_t* buffer, int64_t value) {
+    int32_t size = 0;
+    uint64_t magnitude = (uint64_t)value;
+    if (value < 0) {
+        buffer[size++] = '-';
+        magnitude = 0 - magnitude;
+    }
+    return size + formatUnsigned(buffer + size, magnitude);
+}
+
+/* Writes the specified value with up to six fractional digits, trimming the
+ * trailing zeros. Values that are too large or too small for the fixed
+ * notation are written in the scientific notation, for example, `1.5e-07`.
+ * The buffer should have room for 32 bytes.
+ */
+static int32_t formatDecimal(uint8_t* buffer, double value) {
+    int32_t size = 0;
+    if (value != value) {
+        memcpy(buffer, "nan", 3);
+        return 3;
+    }
+
+    if ((value < 0.0) || ((value == 0.0) && (1.0 / value < 0.0))) {
+        buffer[size++] = '-';
+        value = -value;
+    }
+
+    if (value > 1.7976931348623157e308) {
+        memcpy(buffer + size, "inf", 3);
+        return size + 3;
+    }
+
+    int32_t exponent = 0;
+    if ((value >= 1e12) || ((value != 0.0) && (value < 1e-4))) {
+        while (value >= 10.0) {
+            value /= 10.0;
+            exponent++;
+        }
+        while (value < 1.0) {
+            value *= 10.0;
+            exponent--;
+        }
+    }
+
+    /* Both the parts fit in 64 bits because the value is less than 10^12. */
+    uint64_t scaled = (uint64_t)(value * 1e6 + 0.5);
+    uint64_t integer = scaled / 1000000;
+    uint32_t fraction = (uint32_t)(scaled % 1000000);
+    if ((exponent != 0) && (integer == 10)) {
+        /* Rounding carried the mantissa over to the next power of ten. */
+        integer = 1;
+        exponent++;
+    }
+    size += formatUnsigned(buffer + size, integer);
+
+    if (fraction != 0) {
+        buffer[size++] = '.';
+        int32_t i;
+        for (i = 5; i >= 0; i--) {
+            buffer[size + i] = (uint8_t)('0' + (fraction % 10));
+            fraction /= 10;
+        }
+        size += 6;
+        while (buffer[size - 1] == '0') {
+            size--;
+        }
+    }
+
+    if (exponent != 0) {
+        buffer[size++] = 'e';
+        buffer[size++] = (exponent < 0)? '-' : '+';
+        uint32_t magnitude = (exponent < 0)? -exponent : exponent;
+        if (magnitude < 10) {
+            buffer[size++] = '0';
+        }
+        size += formatUnsigned(buffer + size, magnitude);
+    }
+    return size;
+}
+
+/* Ensures that the builder can accommodate the specified number of bytes. The
+ * capacity is at least doubled every time the buffer is reallocated, so that
+ * repeated appends take amortized constant time. The growth stops at the
+ * maximum size of a string.
+ */
+static void ensureCapacity(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    int32_t extra) {
+    int64_t required = (int64_t)builder->size + extra;
+    if (required > builder->capacity) {
+        if (required > K_STRING_MAX_SIZE) {
+            k_Runtime_throwStringTooLarge(runtime, required);
+        }
+
+        int64_t capacity = (int64_t)builder->capacity * 2;
+        if (capacity < 16) {
+            capacity = 16;
+        }
+        if (capacity < required) {
+            capacity = required;
+        }
+        if (capacity > K_STRING_MAX_SIZE) {
+            capacity = K_STRING_MAX_SIZE;
+        }
+
+        k_String_t* buffer = allocateString(runtime, (int32_t)capacity);
+        if (builder->buffer != NULL) {
+            memcpy(buffer->value, builder->buffer->value, builder->size);
+        }
+        /* The previous buffer is left to the collector. */
+        builder->buffer = buffer;
+        builder->capacity = (int32_t)capacity;
+    }
+}
+
+k_StringBuilder_t* kush_StringBuilder_new(k_Runtime_t* runtime) {
+    k_StringBuilder_t* builder = k_Allocator_allocate(runtime->allocator,
+        sizeof (k_StringBuilder_t));
+    builder->header.type = K_OBJECT_STRING_BUILDER;
+    builder->size = 0;
+    builder->capacity = 0;
+    builder->buffer = NULL;
+    return builder;
+}
+
+void kush_StringBuilder_append_s(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    k_String_t* string) {
+    ensureCapacity(runtime, builder, string->size);
+    memcpy(builder->buffer->value + builder->size, string->value, string->size);
+    builder->size += string->size;
+}
+
+void kush_StringBuilder_append_i(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    int32_t value) {
+    ensureCapacity(runtime, builder, 20);
+    builder->size += formatInteger(builder->buffer->value + builder->size, value);
+}
+
+void kush_StringBuilder_append_l(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    int64_t value) {
+    ensureCapacity(runtime, builder, 20);
+    builder->size += formatInteger(builder->buffer->value + builder->size, value);
+}
+
+void kush_StringBuilder_append_f(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    double value) {
+    ensureCapacity(runtime, builder, 32);
+    builder->size += formatDecimal(builder->buffer->value + builder->size, value);
+}
+
+k_String_t* kush_StringBuilder_toString(k_Runtime_t* runtime, k_StringBuilder_t* builder) {
+    k_String_t* result = builder->buffer;
+    if (result == NULL) {
+        result = allocateString(runtime, 0);
+    }
+    else {
+        /* The buffer is handed over without copying. The unused capacity
+         * remains a part of the string object until it is collected.
+         */
+        result->size = builder->size;
+        result->value[builder->size] = '\0';
+
+        builder->buffer = NULL;
+        builder->size = 0;
+        builder->capacity = 0;
+    }
+    return result;
+}
+
+/*******************************************************************************
+ * File                                                                        *
+ *******************************************************************************/
+
+#define K_FILE_READER_BUFFER_SIZE 65536
+
+k_ArrayUi8_t* kush_File_map(k_Runtime_t* runtime, k_String_t* path) {
+    k_ArrayUi8_t* result = NULL;
+    int32_t descriptor = open((const char*)path->value, O_RDONLY);
+    if (descriptor >= 0) {
+        struct stat status;
+        if (fstat(descriptor, &status) == 0) {
+            void* address = NULL;
+            /* Empty files cannot be mapped. They result in an empty array.
+             * The array is mutable, so the pages are mapped copy-on-write.
+             * Stores modify the private copy, never the file.
+             */
+            if (status.st_size > 0) {
+                address = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE, descriptor, 0);
+                if (address != MAP_FAILED) {
+                    madvise(address, status.st_size, MADV_SEQUENTIAL);
+                }
+            }
+
+            if (address != MAP_FAILED) {
+                result = k_Allocator_allocate(runtime->allocator, sizeof (k_ArrayUi8_t));
+                result->header.type = K_OBJECT_MAPPED_ARRAY;
+                result->size = status.st_size;
+                result->value = (uint8_t*)address;
+            }
+        }
+        /* The mapping remains valid after the file is closed. */
+        close(descriptor);
+    }
+    return result;
+}
+
+k_FileReader_t* kush_FileReader_open(k_Runtime_t* runtime, k_String_t* path) {
+    k_FileReader_t* reader = NULL;
+    int32_t descriptor = open((const char*)path->value, O_RDONLY);
+    if (descriptor >= 0) {
+        reader = k_Allocator_allocate(runtime->allocator, sizeof (k_FileReader_t));
+        reader->header.type = K_OBJECT_FILE_READER;
+        reader->descriptor = descriptor;
+        reader->buffer = malloc(K_FILE_READER_BUFFER_SIZE);
+        reader->capacity = K_FILE_READER_BUFFER_SIZE;
+        reader->position = 0;
+        reader->limit = 0;
+        reader->endOfFile = false;
+    }
+    return reader;
+}
+
+/* Moves the unread bytes to the beginning of the buffer and reads more bytes
+ * after them. The buffer is doubled when it is full, which happens only when a
+ * line is longer than the buffer. Returns false at the end of the file.
+ */
+static bool fillReader(k_FileReader_t* reader) {
+    if (reader->endOfFile) {
+        return false;
+    }
+
+    int32_t remaining = reader->limit - reader->position;
+    if (reader->position > 0) {
+        memmove(reader->buffer, reader->buffer + reader->position, remaining);
+        reader->position = 0;
+        reader->limit = remaining;
+    }
+
+    if (reader->limit == reader->capacity) {
+        reader->capacity *= 2;
+        reader->buffer = realloc(reader->buffer, reader->capacity);
+    }
+
+    ssize_t count;
+    do {
+        count = read(reader->descriptor, reader->buffer + reader->limit,
+            reader->capacity - reader->limit);
+    }
+    while ((count < 0) && (errno == EINTR));
+
+    if (count <= 0) {
+        reader->endOfFile = true;
+        return false;
+    }
+
+    reader->limit += count;
+    return true;
+}
+
+k_String_t* kush_FileReader_readLine(k_Runtime_t* runtime, k_FileReader_t* reader) {
+    if (reader->descriptor < 0) {
+        return NULL;
+    }
+
+    /* The search resumes where the previous attempt stopped, so that the bytes
+     * of a long line are scanned only once.
+     */
+    int32_t scanned = 0;
+    uint8_t* newLine = NULL;
+    while (true) {
+        uint8_t* start = reader->buffer + reader->position;
+        int32_t available = reader->limit - reader->position;
+        newLine = memchr(start + scanned, '\n', available - scanned);
+        if (newLine != NULL) {
+            break;
+        }
+        scanned = available;
+        if (!fillReader(reader)) {
+            break;
+        }
+    }
+
+    uint8_t* start = reader->buffer + reader->position;
+    int32_t size = 0;
+    if (newLine != NULL) {
+        size = newLine - start;
+        reader->position += size + 1;
+    }
+    else {
+        /* The last line may not be terminated. */
+        size = reader->limit - reader->position;
+        if (size == 0) {
+            return NULL;
+        }
+        reader->position = reader->limit;
+    }
+
+    if ((size > 0) && (start[size - 1] == '\r')) {
+        size--;
+    }
+    return newString(runtime, start, size);
+}
+
+int32_t kush_FileReader_read(k_Runtime_t* runtime, k_FileReader_t* reader,
+    k_ArrayUi8_t* buffer) {
+    if (reader->descriptor < 0) {
+        return 0;
+    }
+
+    int32_t result = 0;
+    int32_t available = reader->limit - reader->position;
+    if (available > 0) {
+        /* The bytes buffered by `readLine` are returned first. */
+        result = (available < buffer->size)? available : buffer->size;
+        memcpy(buffer->value, reader->buffer + reader->position, result);
+        reader->position += result;
+    }
+    else if (!reader->endOfFile) {
+        /* Chunks are read straight into the array, bypassing the buffer. The
+         * size of a chunk is limited so that the count fits the result.
+         */
+        size_t size = (buffer->size < INT32_MAX)? buffer->size : INT32_MAX;
+        ssize_t count;
+        do {
+            count = read(reader->descriptor, buffer->value, size);
+        }
+        while ((count < 0) && (errno == EINTR));
+
+        if (count <= 0) {
+            reader->endOfFile = true;
+        }
+        else {
+            result = count;
+        }
+    }
+    return result;
+}
+
+void k_FileReader_finalize(k_FileReader_t* reader) {
+    if (reader->descriptor >= 0) {
+        close(reader->descriptor);
+        reader->descriptor = -1;
+    }
+    free(reader->buffer);
+    reader->buffer = NULL;
+    reader->position = 0;
+    reader->limit = 0;
+}
+
+void kush_FileReader_close(k_Runtime_t* runtime, k_FileReader_t* reader) {
+    k_FileReader_finalize(reader);
+}
+
+/*******************************************************************************
+ * Map                                                                         *
+ *******************************************************************************/
+
+#define K_MAP_GROUP_SIZE 16
+#define K_MAP_EMPTY ((int8_t)-128)
+#define K_MAP_DELETED ((int8_t)-2)
+
+/* The following functions return a mask with a bit set for every control byte
+ * in the group that matches. The groups are aligned to 16 bytes.
+ */
+#if defined(__SSE2__)
+
+static inline uint32_t matchByte(const int8_t* group, int8_t byte) {
+    __m128i control = _mm_load_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(byte)));
+}
+
+/* The empty and deleted control bytes are the only ones with the sign bit
+ * set.
+ */
+static inline uint32_t matchFree(const int8_t* group) {
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)group));
+}
+
+#else
+
+static inline uint32_t matchByte(const int8_t* group, int8_t byte) {
+    uint32_t result = 0;
+    int32_t i;
+    for (i = 0; i < K_MAP_GROUP_SIZE; i++) {
+        result |= (uint32_t)(group[i] == byte) << i;
+    }
+    return result;
+}
+
+static inline uint32_t matchFree(const int8_t* group) {
+    uint32_t result = 0;
+    int32_t i;
+    for (i = 0; i < K_MAP_GROUP_SIZE; i++) {
+        result |= (uint32_t)(group[i] < 0) << i;
+    }
+    return result;
+}
+
+#endif
+
+/* The hashes of strings are cached in the strings themselves. Every hash is
+ * scrambled with the finalizer of SplitMix64, so that both the group index and
+ * the 7 bits in the control byte are well distributed.
+ */
+static uint64_t hashKey(k_Map_t* map, k_Value_t key) {
+    uint64_t hash;
+    switch (map->keyKind) {
+        case K_MAP_KEY_STRING: {
+            hash = (key.reference == NULL)? 0 : k_String_hash((k_String_t*)key.reference);
+            break;
+        }
+
+        case K_MAP_KEY_INTEGER: {
+            hash = (uint64_t)key.integer;
+            break;
+        }
+
+        default: {
+            hash = (uint64_t)(uintptr_t)key.reference;
+            break;
+        }
+    }
+
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+static bool equalKeys(k_Map_t* map, k_Value_t key1, k_Value_t key2) {
+    bool result;
+    if (map->keyKind == K_MAP_KEY_STRING) {
+        k_String_t* string1 = (k_String_t*)key1.reference;
+        k_String_t* string2 = (k_String_t*)key2.reference;
+        result = (string1 == string2) || ((string1 != NULL) && (string2 != NULL) &&
+            (string1->size == string2->size) &&
+            (k_String_hash(string1) == k_String_hash(string2)) &&
+            (memcmp(string1->value, string2->value, string1->size) == 0));
+    }
+    else if (map->keyKind == K_MAP_KEY_INTEGER) {
+        result = key1.integer == key2.integer;
+    }
+    else {
+        result = key1.reference == key2.reference;
+    }
+    return result;
+}
+
+/* The groups are probed triangularly, which visits every group when the number
+ * of groups is a power of two. A lookup stops at the first group with an empty
+ * slot, because an insertion would have used that slot.
+ */
+static int64_t findSlot(k_Map_t* map, k_Value_t key, uint64_t hash) {
+    int64_t result = -1;
+    if (map->capacity > 0) {
+        int8_t tag = (int8_t)(hash & 0x7F);
+        int64_t groupMask = (map->capacity / K_MAP_GROUP_SIZE) - 1;
+        int64_t group = (int64_t)(hash >> 7) & groupMask;
+        int64_t step = 0;
+        bool done = false;
+        while (!done) {
+            const int8_t* control = map->control + (group * K_MAP_GROUP_SIZE);
+            uint32_t matches = matchByte(control, tag);
+            while (matches != 0) {
+                int64_t slot = (group * K_MAP_GROUP_SIZE) + __builtin_ctz(matches);
+                if (equalKeys(map, map->entries[slot].key, key)) {
+                    result = slot;
+                    done = true;
+                    break;
+                }
+                matches &= matches - 1;
+            }
+
+            if (!done) {
+                done = matchByte(control, K_MAP_EMPTY) != 0;
+                step++;
+                group = (group + step) & groupMask;
+            }
+        }
+    }
+    return result;
+}
+
+/* Returns the first empty or deleted slot in the probe sequence of the hash.
+ * The growth limit guarantees that there is one.
+ */
+static int64_t findFreeSlot(k_Map_t* map, uint64_t hash) {
+    int64_t groupMask = (map->capacity / K_MAP_GROUP_SIZE) - 1;
+    int64_t group = (int64_t)(hash >> 7) & groupMask;
+    int64_t step = 0;
+    uint32_t matches;
+    while ((matches = matchFree(map->control + (group * K_MAP_GROUP_SIZE))) == 0) {
+        step++;
+        group = (group + step) & groupMask;
+    }
+    return (group * K_MAP_GROUP_SIZE) + __builtin_ctz(matches);
+}
+
+static void resize(k_Map_t* map, int64_t capacity) {
+    int8_t* oldControl = map->control;
+    k_MapEntry_t* oldEntries = map->entries;
+    int64_t oldCapacity = map->capacity;
+
+    map->control = aligned_alloc(K_MAP_GROUP_SIZE, capacity);
+    memset(map->control, K_MAP_EMPTY, capacity);
+    map->entries = malloc(sizeof (k_MapEntry_t) * capacity);
+    map->capacity = capacity;
+    map->growthLeft = capacity - (capacity / 8) - map->size;
+
+    /* The tombstones are dropped along the way. */
+    int64_t i;
+    for (i = 0; i < oldCapacity; i++) {
+        if (oldControl[i] >= 0) {
+            uint64_t hash = hashKey(map, oldEntries[i].key);
+            int64_t slot = findFreeSlot(map, hash);
+            map->control[slot] = (int8_t)(hash & 0x7F);
+            map->entries[slot] = oldEntries[i];
+        }
+    }
+
+    free(oldControl);
+    free(oldEntries);
+}
+
+k_Map_t* kush_Map_new(k_Runtime_t* runtime, uint8_t keyKind, bool referenceValues) {
+    k_Map_t* map = k_Allocator_allocate(runtime->allocator, sizeof (k_Map_t));
+    map->header.type = K_OBJECT_MAP;
+    map->keyKind = keyKind;
+    map->referenceValues = referenceValues;
+    map->size = 0;
+    map->capacity = 0;
+    map->growthLeft = 0;
+    map->control = NULL;
+    map->entries = NULL;
+    return map;
+}
+
+void kush_Map_put(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key, k_Value_t value) {
+    uint64_t hash = hashKey(map, key);
+    int64_t slot = findSlot(map, key, hash);
+    if (slot >= 0) {
+        map->entries[slot].value = value;
+    }
+    else {
+        if (map->growthLeft == 0) {
+            /* When the table is full of tombstones rather than entries, it is
+             * rehashed in place.
+             */
+            int64_t capacity = map->capacity;
+            if (capacity == 0) {
+                capacity = K_MAP_GROUP_SIZE;
+            }
+            else if (map->size * 16 > capacity * 7) {
+                capacity *= 2;
+            }
+            resize(map, capacity);
+        }
+
+        slot = findFreeSlot(map, hash);
+        if (map->control[slot] == K_MAP_EMPTY) {
+            map->growthLeft--;
+        }
+        map->control[slot] = (int8_t)(hash & 0x7F);
+        map->entries[slot].key = key;
+        map->entries[slot].value = value;
+        map->size++;
+    }
+}
+
+k_Value_t kush_Map_get(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key) {
+    int64_t slot = findSlot(map, key, hashKey(map, key));
+    k_Value_t result = { .integer = 0 };
+    if (slot >= 0) {
+        result = map->entries[slot].value;
+    }
+    return result;
+}
+
+bool kush_Map_contains(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key) {
+    return findSlot(map, key, hashKey(map, key)) >= 0;
+}
+
+bool kush_Map_remove(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key) {
+    int64_t slot = findSlot(map, key, hashKey(map, key));
+    if (slot >= 0) {
+        /* No lookup probes past a group with an empty slot. In that case, the
+         * slot is emptied instead of being marked as deleted.
+         */
+        const int8_t* group = map->control + (slot & ~(int64_t)(K_MAP_GROUP_SIZE - 1));
+        if (matchByte(group, K_MAP_EMPTY) != 0) {
+            map->control[slot] = K_MAP_EMPTY;
+            map->growthLeft++;
+        }
+        else {
+            map->control[slot] = K_MAP_DELETED;
+        }
+        map->size--;
+    }
+    return slot >= 0;
+}
+
+int64_t kush_Map_size(k_Runtime_t* runtime, k_Map_t* map) {
+    return map->size;
+}
+
+void kush_Map_clear(k_Runtime_t* runtime, k_Map_t* map) {
+    if (map->capacity > 0) {
+        memset(map->control, K_MAP_EMPTY, map->capacity);
+    }
+    map->size = 0;
+    map->growthLeft = map->capacity - (map->capacity / 8);
+}
+
+int64_t kush_Map_next(k_Runtime_t* runtime, k_Map_t* map, int64_t slot) {
+    int64_t result = -1;
+    int64_t i;
+    for (i = (slot < 0)? 0 : (slot + 1); i < map->capacity; i++) {
+        if (map->control[i] >= 0) {
+            result = i;
+            break;
+        }
+    }
+    return result;
+}
+
+static inline bool isOccupied(k_Map_t* map, int64_t slot) {
+    return (slot >= 0) && (slot < map->capacity) && (map->control[slot] >= 0);
+}
+
+k_Value_t kush_Map_keyAt(k_Runtime_t* runtime, k_Map_t* map, int64_t slot) {
+    k_Value_t result = { .integer = 0 };
+    if (isOccupied(map, slot)) {
+        result = map->entries[slot].key;
+    }
+    return result;
+}
+
+k_Value_t kush_Map_valueAt(k_Runtime_t* runtime, k_Map_t* map, int64_t slot) {
+    k_Value_t result = { .integer = 0 };
+    if (isOccupied(map, slot)) {
+        result = map->entries[slot].value;
+    }
+    return result;
+}
+
+void k_Map_finalize(k_Map_t* map) {
+    free(map->control);
+    free(map->entries);
+    map->control = NULL;
+    map->entries = NULL;
+    map->capacity = 0;
+    map->size = 0;
+}
+
+/*******************************************************************************
+ * List                                                                        *
+ *******************************************************************************/
+
+/* The capacity that the storage of an empty list starts with. */
+#define K_LIST_MINIMUM_CAPACITY 8
+
+k_List_t* kush_List_new(k_Runtime_t* runtime, int32_t elementSize,
+    bool referenceElements) {
+    k_List_t* list = k_Allocator_allocate(runtime->allocator, sizeof (k_List_t));
+    list->header.type = K_OBJECT_LIST;
+    list->referenceElements = referenceElements;
+    list->elementSize = elementSize;
+    list->size = 0;
+    list->capacity = 0;
+    list->value = NULL;
+    return list;
+}
+
+static void resizeList(k_List_t* list, int64_t capacity) {
+    if (capacity == 0) {
+        free(list->value);
+        list->value = NULL;
+    }
+    else {
+        list->value = realloc(list->value, (size_t)capacity * list->elementSize);
+    }
+    list->capacity = capacity;
+}
+
+/* The capacity is doubled, which makes appending amortized constant time. */
+void k_List_grow(k_List_t* list, int64_t capacity) {
+    int64_t newCapacity = list->capacity * 2;
+    if (newCapacity < K_LIST_MINIMUM_CAPACITY) {
+        newCapacity = K_LIST_MINIMUM_CAPACITY;
+    }
+    if (newCapacity < capacity) {
+        newCapacity = capacity;
+    }
+    resizeList(list, newCapacity);
+}
+
+void k_List_reserve(k_List_t* list, int64_t capacity) {
+    if (capacity > list->capacity) {
+        resizeList(list, capacity);
+    }
+}
+
+void k_List_shrinkToFit(k_List_t* list) {
+    if (list->size < list->capacity) {
+        resizeList(list, list->size);
+    }
+}
+
+void k_List_finalize(k_List_t* list) {
+    free(list->value);
+    list->value = NULL;
+    list->size = 0;
+    list->capacity = 0;
+}
+
+/*******************************************************************************
+ * Output                                                                      *
+ *******************************************************************************/
+
+/* The standard output is buffered by the runtime, instead of the C library.
+ * The print builtins format their arguments directly into the buffer, which is
+ * written out when it is full, when `flush` is called, and when the program
+ * exits. The diagnostics printed by the runtime flush the buffer first, so that
+ * the output appears in order.
+ */
+#define K_OUTPUT_BUFFER_SIZE 65536
+
+static uint8_t outputBuffer[K_OUTPUT_BUFFER_SIZE];
+static int32_t outputSize = 0;
+
+static void writeAll(const uint8_t* bytes, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(STDOUT_FILENO, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* The output is discarded when the standard output is closed. */
+            break;
+        }
+        bytes += written;
+        size -= written;
+    }
+}
+
+void k_Output_flush() {
+    /* Anything printed through the C library precedes the buffered output. */
+    fflush(stdout);
+    if (outputSize > 0) {
+        writeAll(outputBuffer, outputSize);
+        outputSize = 0;
+    }
+}
+
+/* Returns a pointer to at least `size` bytes at the end of the buffer. The
+ * caller advances `outputSize` by the number of bytes it writes.
+ */
+static inline uint8_t* reserveOutput(int32_t size) {
+    if (outputSize + size > K_OUTPUT_BUFFER_SIZE) {
+        k_Output_flush();
+    }
+    return outputBuffer + outputSize;
+}
+
+static void writeOutput(const uint8_t* bytes, int32_t size) {
+    if (size >= K_OUTPUT_BUFFER_SIZE) {
+        /* Large writes skip the buffer. */
+        k_Output_flush();
+        writeAll(bytes, size);
+    }
+    else {
+        uint8_t* destination = reserveOutput(size);
+        memcpy(destination, bytes, size);
+        outputSize += size;
+    }
+}
+
+void kush_print_i(k_Runtime_t* runtime, int32_t value) {
+    outputSize += formatInteger(reserveOutput(20), value);
+}
+
+void kush_print_l(k_Runtime_t* runtime, int64_t value) {
+    outputSize += formatInteger(reserveOutput(20), value);
+}
+
+void kush_print_f(k_Runtime_t* runtime, double value) {
+    outputSize += formatDecimal(reserveOutput(32), value);
+}
+
+void kush_print_s(k_Runtime_t* runtime, k_String_t* string) {
+    writeOutput(string->value, string->size);
+}
+
+void kush_flush(k_Runtime_t* runtime) {
+    k_Output_flush();
+}
+
+/*******************************************************************************
+ * Collector                                                                   *
+ *******************************************************************************/
+
+/* The objects that were marked, but whose references are yet to be scanned.
+ * The stack grows on the heap, so that long chains of objects, such as linked
+ * lists, do not overflow the native stack. It is retained across collections.
+ */
+static k_Object_t** markStack = NULL;
+static size_t markStackSize = 0;
+static size_t markStackCapacity = 0;
+
+void markObject(k_Runtime_t* runtime, k_Object_t* object) {
+    /* Objects that were already marked are skipped. This way, cycles are
+     * scanned only once.
+     */
+    if ((object == NULL) || (object->header.marked == sense)) {
+        return;
+    }
+
+    object->header.marked = sense;
+    if (markStackSize == markStackCapacity) {
+        size_t capacity = (markStackCapacity == 0)? 1024 : markStackCapacity * 2;
+        k_Object_t** stack = realloc(markStack, capacity * sizeof (k_Object_t*));
+        if (stack == NULL) {
+            reportOutOfMemory(capacity * sizeof (k_Object_t*));
+        }
+        markStack = stack;
+        markStackCapacity = capacity;
+    }
+    markStack[markStackSize++] = object;
+}
+
+/* Marks the objects that the specified object refers to. */
+void scanObject(k_Runtime_t* runtime, k_Object_t* object) {
+    switch (object->header.type) {
+        case K_OBJECT_REFERENCE_ARRAY: {
+            k_Array_t* array = (k_Array_t*)object;
+            /* The elements are stored in a separate object that immediately
+             * precedes them.
+             */
+            k_Object_t* internal = (k_Object_t*)((uint8_t*)array->value -
+                sizeof (k_ObjectHeader_t));
+            internal->header.marked = sense;
+
+            int64_t i;
+            for (i = 0; i < array->size; i++) {
+                k_Object_t* element = K_DECODE(k_Object_t*, array->value[i]);
+                markObject(runtime, element);
+            }
+            break;
+        }
+
+        case K_OBJECT_STRUCTURE_INSTANCE: {
+            /* The generator lays out the reference fields first. */
+            k_Reference_t* fields = (k_Reference_t*)(object + 1);
+            int32_t i;
+            for (i = 0; i < object->header.references; i++) {
+                markObject(runtime, K_DECODE(k_Object_t*, fields[i]));
+            }
+            break;
+        }
+
+        case K_OBJECT_STRING_BUILDER: {
+            k_StringBuilder_t* builder = (k_StringBuilder_t*)object;
+            markObject(runtime, (k_Object_t*)builder->buffer);
+            break;
+        }
+
+        case K_OBJECT_MAP: {
+            k_Map_t* map = (k_Map_t*)object;
+            bool referenceKeys = map->keyKind != K_MAP_KEY_INTEGER;
+            if (referenceKeys || map->referenceValues) {
+                int64_t i;
+                for (i = 0; i < map->capacity; i++) {
+                    if (map->control[i] >= 0) {
+                        if (referenceKeys) {
+                            markObject(runtime, (k_Object_t*)map->entries[i].key.reference);
+                        }
+                        if (map->referenceValues) {
+                            markObject(runtime, (k_Object_t*)map->entries[i].value.reference);
+                        }
+                    }
+                }
+            }
+            break;
+        }
+
+        case K_OBJECT_LIST: {
+            k_List_t* list = (k_List_t*)object;
+            if (list->referenceElements) {
+                k_Object_t** elements = (k_Object_t**)list->value;
+                int64_t i;
+                for (i = 0; i < list->size; i++) {
+                    markObject(runtime, elements[i]);
+                }
+            }
+            break;
+        }
+    }
+}
+
+void markCallStack(k_Runtime_t* runtime) {
+    int32_t count = 0;
+    k_StackFrame_t* current = runtime->stackFrames;
+    while (current != NULL) {
+        int32_t i;
+        for (i = 0; i < current->pointerCount; i++) {
+            k_Object_t* object = (k_Object_t*)current->pointers[i];
+            markObject(runtime, object);
+            count++;
+        }
+        current = current->next;
+    }
+
+    while (markStackSize > 0) {
+        scanObject(runtime, markStack[--markStackSize]);
+    }
+    printf("Roots: %d\n", count);
+}
+
+int32_t countObjects(k_Runtime_t* runtime) {
+    k_Object_t* object = runtime->allocator->firstObject;
+    int32_t count = 0;
+    while (object != NULL) {
+        object = object->header.next;
+        count++;
+    }
+    printf("Object count: %d\n", count);
+    return count;
+}
+
+/* Releases the resources that an unreachable object holds outside the
+ * heap.
+ */
+void finalizeObject(k_Object_t* object) {
+    switch (object->header.type) {
+        case K_OBJECT_PRIMITIVE_ARRAY: {
+            /* The elements of primitive arrays are allocated separately. */
+            free(((k_Array_t*)object)->value);
+            break;
+        }
+
+        case K_OBJECT_MAPPED_ARRAY: {
+            k_ArrayUi8_t* array = (k_ArrayUi8_t*)object;
+            if (array->size > 0) {
+                munmap(array->value, array->size);
+            }
+            break;
+        }
+
+        case K_OBJECT_FILE_READER: {
+            k_FileReader_finalize((k_FileReader_t*)object);
+            break;
+        }
+
+        case K_OBJECT_MAP: {
+            k_Map_finalize((k_Map_t*)object);
+            break;
+        }
+
+        case K_OBJECT_LIST: {
+            k_List_finalize((k_List_t*)object);
+            break;
+        }
     }
-    printf("Object count: %d\n", count);
-    return count;
 }
 
 void sweep(k_Runtime_t* runtime) {
@@ -602,6 +2555,7 @@ void sweep(k_Runtime_t* runtime) {
                 previous->header.next = next;
             }
 
+            finalizeObject(object);
             k_Allocator_deallocate(runtime->allocator, object);
             count++;
         }
@@ -616,6 +2570,7 @@ void sweep(k_Runtime_t* runtime) {
 }
 
 void collect(k_Runtime_t* runtime) {
+    k_Output_flush();
     printf("\n[Collector Statistics]\n");
     markCallStack(runtime);
     sweep(runtime);
@@ -629,8 +2584,10 @@ int main() {
     k_Allocator_t allocator;
     k_Allocator_initialize(&allocator);
     k_Runtime_initialize(&runtime, &allocator);
+    /* The buffered output is written even when the program calls `exit()`. */
+    atexit(k_Output_flush);
 
-    kush_main();
+    kush_main(&runtime);
 
     collect(&runtime);
     puts("\n");
@@ -1,14 +1,23 @@
 // Saturday, June 20 2020
 
+#ifndef KUSH_RUNTIME_H
+#define KUSH_RUNTIME_H
+
 #include <stdint.h>
 
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
 
+/* The expression is evaluated before the stack frame is popped, since it may
+ * read the references stored in the frame.
+ */
 #define kush_return(expression) \
-    k_Runtime_popStackFrame(runtime); \
-    return expression;
+    do { \
+        __typeof__(expression) $result = (expression); \
+        k_Runtime_popStackFrame(runtime); \
+        return $result; \
+    } while (false)
 
 
 
@@ -54,6 +63,16 @@ struct k_StackFrame_t {
 
 typedef struct k_Allocator_t k_Allocator_t;
 
+/* A unity build compiles the runtime and the generated code as a single
+ * translation unit, where the functions called by every generated function
+ * are defined inline.
+ */
+#ifdef KUSH_UNITY
+    #define K_FAST_PATH static inline
+#else
+    #define K_FAST_PATH
+#endif
+
 struct k_Runtime_t {
     k_Allocator_t* allocator;
     k_StackFrame_t* stackFrames;
@@ -67,9 +86,44 @@ typedef struct k_Runtime_t k_Runtime_t;
 
 void k_Runtime_initialize(k_Runtime_t* runtime, k_Allocator_t* allocator);
 void k_Runtime_destroy(k_Runtime_t* runtime);
-k_StackFrame_t* k_Runtime_pushStackFrame(k_Runtime_t* runtime, const uint8_t* name,
-    int32_t nameSize, int32_t pointerCount);
-void k_Runtime_popStackFrame(k_Runtime_t* runtime);
+K_FAST_PATH k_StackFrame_t* k_Runtime_pushStackFrame(k_Runtime_t* runtime,
+    const uint8_t* name, int32_t nameSize, int32_t pointerCount);
+K_FAST_PATH void k_Runtime_popStackFrame(k_Runtime_t* runtime);
+
+/* Reports an invalid index along with the stack trace, and terminates the
+ * program. The compiler generates the checks inline, while the failure path is
+ * kept out of the way.
+ */
+__attribute__((noreturn, cold))
+void k_Runtime_throwIndexOutOfBounds(k_Runtime_t* runtime, int64_t index, int64_t size);
+
+/* Reports a string whose size would exceed `K_STRING_MAX_SIZE` along with the
+ * stack trace, and terminates the program.
+ */
+__attribute__((noreturn, cold))
+void k_Runtime_throwStringTooLarge(k_Runtime_t* runtime, int64_t size);
+
+static inline void k_Runtime_checkIndex(k_Runtime_t* runtime, int64_t index,
+    int64_t size) {
+    /* A negative index wraps around to a large unsigned value, which folds
+     * both the bounds into a single comparison.
+     */
+    if (__builtin_expect((uint64_t)index >= (uint64_t)size, 0)) {
+        k_Runtime_throwIndexOutOfBounds(runtime, index, size);
+    }
+}
+
+/* Evaluates to the element of an array at the specified index, after checking
+ * the index. The result can be assigned to. Arrays and strings are both
+ * supported, since they share the `size` and `value` fields.
+ */
+#define K_CHECKED_ELEMENT(runtime, array, index) \
+    (*({ \
+        __typeof__(array) $array = (array); \
+        int64_t $index = (index); \
+        k_Runtime_checkIndex(runtime, $index, $array->size); \
+        &$array->value[$index]; \
+    }))
 
 typedef struct k_Object_t k_Object_t;
 
@@ -80,10 +134,19 @@ typedef struct k_ObjectHeader_t k_ObjectHeader_t;
 #define K_OBJECT_STRUCTURE_INSTANCE 3
 #define K_OBJECT_STRING 4
 #define K_OBJECT_RUNTIME 5
+#define K_OBJECT_STRING_BUILDER 6
+#define K_OBJECT_MAPPED_ARRAY 7
+#define K_OBJECT_FILE_READER 8
+#define K_OBJECT_MAP 9
+#define K_OBJECT_LIST 10
 
 struct k_ObjectHeader_t {
     bool marked;
     uint8_t type;
+    /* The number of reference fields in a structure instance. They are laid out
+     * immediately after the header.
+     */
+    uint16_t references;
     k_Object_t* next;
 };
 
@@ -91,76 +154,783 @@ struct k_Object_t {
     k_ObjectHeader_t header;
 };
 
+/*******************************************************************************
+ * Reference                                                                   *
+ *******************************************************************************/
+
+/* The references stored inside objects, that is, the reference fields of
+ * structures and the elements of reference arrays, are of type k_Reference_t.
+ * The generated code reads them with K_DECODE() and writes them with
+ * K_ENCODE(). References on the stack are always native pointers.
+ *
+ * When the runtime and the generated code are compiled with
+ * `KUSH_COMPRESSED_REFERENCES`, the heap is reserved at a fixed base and a
+ * reference is a 32-bit offset from the base, shifted by the object alignment.
+ * This way, a heap of 32 GiB can be addressed with half the memory per
+ * reference. The offset zero represents `null`, since no object starts at the
+ * base.
+ */
+#ifdef KUSH_COMPRESSED_REFERENCES
+
+#define K_OBJECT_ALIGNMENT_SHIFT 3
+#define K_HEAP_CAPACITY ((size_t)1 << (32 + K_OBJECT_ALIGNMENT_SHIFT))
+
+typedef uint32_t k_Reference_t;
+
+extern uint8_t* k_heapBase;
+
+static inline void* k_Reference_decode(k_Reference_t reference) {
+    return (reference == 0)? NULL :
+        (void*)(k_heapBase + ((uintptr_t)reference << K_OBJECT_ALIGNMENT_SHIFT));
+}
+
+static inline k_Reference_t k_Reference_encode(const void* object) {
+    return (object == NULL)? 0 :
+        (k_Reference_t)(((const uint8_t*)object - k_heapBase) >> K_OBJECT_ALIGNMENT_SHIFT);
+}
+
+#else
+
+typedef void* k_Reference_t;
+
+#define k_Reference_decode(reference) ((void*)(reference))
+#define k_Reference_encode(object) ((void*)(object))
+
+#endif
+
+#define K_DECODE(Type, reference) ((Type)k_Reference_decode(reference))
+#define K_ENCODE(object) k_Reference_encode(object)
+
 #define K_TYPE_I8
 
+/* The sizes and indices of arrays are 64-bit. Strings are limited to 2^31
+ * bytes.
+ */
 struct k_Array_t {
     k_ObjectHeader_t header;
-    int32_t size;
-    void** value;
+    int64_t size;
+    k_Reference_t* value;
 };
 
 typedef struct k_Array_t k_Array_t;
 
-struct k_IntegerArray_t {
-    k_ObjectHeader_t header;
-    int32_t size;
-    int32_t* value;
-};
-
-typedef struct k_IntegerArray_t k_IntegerArray_t;
-
-k_Array_t* newPrimitiveArray(k_Runtime_t* runtime, int32_t width, int32_t size);
-k_Array_t* newArray_boolean(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newArray_i8(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newArray_i16(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newArray_i32(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newArray_i64(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newArray_f32(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newArray_f64(k_Runtime_t* runtime, int32_t size);
-k_Array_t* newReferenceArray(k_Runtime_t* runtime, int32_t size);
-
-k_Array_t* makeArray_boolean(k_Runtime_t* runtime, int32_t dimensions, ...);
-k_Array_t* makeArray_i8(k_Runtime_t* runtime, int32_t dimensions, ...);
-k_Array_t* makeArray_i16(k_Runtime_t* runtime, int32_t dimensions, ...);
-k_Array_t* makeArray_i32(k_Runtime_t* runtime, int32_t dimensions, ...);
-k_Array_t* makeArray_i64(k_Runtime_t* runtime, int32_t dimensions, ...);
-k_Array_t* makeArray_f32(k_Runtime_t* runtime, int32_t dimensions, ...);
-k_Array_t* makeArray_f64(k_Runtime_t* runtime, int32_t dimensions, ...);
+/* The arrays of primitive values share the layout of k_Array_t. However, each
+ * element type has its own structure so that the generated code can access the
+ * elements without casts.
+ */
+#define K_PRIMITIVE_ARRAY(Name, Element) \
+    struct Name { \
+        k_ObjectHeader_t header; \
+        int64_t size; \
+        Element* value; \
+    }; \
+    typedef struct Name Name;
+
+/* Boolean arrays are bit-packed into 64-bit words. The size is the number of
+ * bits. The unused bits of the last word are always zero, which allows the
+ * intrinsics to operate on whole words.
+ */
+K_PRIMITIVE_ARRAY(k_ArrayBoolean_t, uint64_t)
+K_PRIMITIVE_ARRAY(k_ArrayI8_t, int8_t)
+K_PRIMITIVE_ARRAY(k_ArrayI16_t, int16_t)
+K_PRIMITIVE_ARRAY(k_IntegerArray_t, int32_t)
+K_PRIMITIVE_ARRAY(k_ArrayI64_t, int64_t)
+K_PRIMITIVE_ARRAY(k_ArrayUi8_t, uint8_t)
+K_PRIMITIVE_ARRAY(k_ArrayUi16_t, uint16_t)
+K_PRIMITIVE_ARRAY(k_ArrayUi32_t, uint32_t)
+K_PRIMITIVE_ARRAY(k_ArrayUi64_t, uint64_t)
+K_PRIMITIVE_ARRAY(k_ArrayF32_t, float)
+K_PRIMITIVE_ARRAY(k_ArrayF64_t, double)
+
+k_Array_t* newPrimitiveArray(k_Runtime_t* runtime, int32_t width, int64_t size);
+k_Array_t* newArray_boolean(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newArray_i8(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newArray_i16(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newArray_i32(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newArray_i64(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newArray_f32(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newArray_f64(k_Runtime_t* runtime, int64_t size);
+k_Array_t* newReferenceArray(k_Runtime_t* runtime, int64_t size);
+k_ArrayBoolean_t* newBitArray(k_Runtime_t* runtime, int64_t size);
+
+/* The result is a primitive array when there is a single dimension, and a
+ * reference array otherwise. The sizes of the dimensions are passed as
+ * `int64_t`.
+ */
+void* makeArray_boolean(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_i8(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_i16(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_i32(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_i64(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_ui8(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_ui16(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_ui32(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_ui64(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_f32(k_Runtime_t* runtime, int32_t dimensions, ...);
+void* makeArray_f64(k_Runtime_t* runtime, int32_t dimensions, ...);
 k_Array_t* makeArray_ref(k_Runtime_t* runtime, int32_t dimensions, ...);
 
-k_Array_t* makeArrayEx_i32(k_Runtime_t* runtime, int32_t dimensions, int32_t* sizes,
+k_Array_t* makeArrayEx_i32(k_Runtime_t* runtime, int32_t dimensions, int64_t* sizes,
     int32_t current, int32_t defaultValue);
 
+k_ArrayBoolean_t* arrayLiteral_boolean(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayI8_t* arrayLiteral_i8(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayI16_t* arrayLiteral_i16(k_Runtime_t* runtime, int32_t size, ...);
 k_IntegerArray_t* arrayLiteral_i32(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayI64_t* arrayLiteral_i64(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayUi8_t* arrayLiteral_ui8(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayUi16_t* arrayLiteral_ui16(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayUi32_t* arrayLiteral_ui32(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayUi64_t* arrayLiteral_ui64(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayF32_t* arrayLiteral_f32(k_Runtime_t* runtime, int32_t size, ...);
+k_ArrayF64_t* arrayLiteral_f64(k_Runtime_t* runtime, int32_t size, ...);
 k_Array_t* arrayLiteral_ref(k_Runtime_t* runtime, int32_t size, ...);
 
+/*******************************************************************************
+ * Bit Array                                                                   *
+ *******************************************************************************/
+
+#define K_BIT_WORD(index) ((index) >> 6)
+#define K_BIT_MASK(index) ((uint64_t)1 << ((index) & 63))
+
+static inline bool k_BitArray_get(k_ArrayBoolean_t* array, int64_t index) {
+    return (array->value[K_BIT_WORD(index)] & K_BIT_MASK(index)) != 0;
+}
+
+static inline bool k_BitArray_set(k_ArrayBoolean_t* array, int64_t index, bool value) {
+    uint64_t* word = &array->value[K_BIT_WORD(index)];
+    /* The bit is cleared and then replaced, without a branch. */
+    *word = (*word & ~K_BIT_MASK(index)) | ((uint64_t)value << (index & 63));
+    return value;
+}
+
+/* The elements of boolean arrays cannot be addressed. Therefore, the generated
+ * code loads them with K_LOAD_BIT(), stores them with K_STORE_BIT(), and
+ * applies compound assignments with K_UPDATE_BIT(). The index is checked when
+ * `checked` is nonzero. Each macro evaluates its arguments exactly once.
+ */
+#define K_LOAD_BIT(runtime, checked, array, index) \
+    ({ \
+        k_ArrayBoolean_t* $array = (array); \
+        int64_t $index = (index); \
+        if (checked) { \
+            k_Runtime_checkIndex(runtime, $index, $array->size); \
+        } \
+        k_BitArray_get($array, $index); \
+    })
+
+#define K_STORE_BIT(runtime, checked, array, index, value) \
+    ({ \
+        k_ArrayBoolean_t* $array = (array); \
+        int64_t $index = (index); \
+        if (checked) { \
+            k_Runtime_checkIndex(runtime, $index, $array->size); \
+        } \
+        k_BitArray_set($array, $index, (value)); \
+    })
+
+#define K_UPDATE_BIT(runtime, checked, array, index, operator, value) \
+    ({ \
+        k_ArrayBoolean_t* $array = (array); \
+        int64_t $index = (index); \
+        if (checked) { \
+            k_Runtime_checkIndex(runtime, $index, $array->size); \
+        } \
+        k_BitArray_set($array, $index, k_BitArray_get($array, $index) operator (value)); \
+    })
+
+/*******************************************************************************
+ * Array Intrinsics                                                            *
+ *******************************************************************************/
+
+/* Each primitive element type has its own set of intrinsics, named after the
+ * suffix of the type. For example, `Array_sort_i64` sorts an `i64[]`.
+ *
+ * Array_copy(source, sourceIndex, destination, destinationIndex, size)
+ *     Copies the elements, even when the ranges overlap.
+ * Array_fill(array, value)
+ *     Assigns the value to every element.
+ * Array_sort(array)
+ *     Sorts the elements in ascending order. Floating point values are ordered
+ *     by their bits, that is, -0.0 precedes 0.0, and NaN values are placed at
+ *     the ends.
+ * Array_binarySearch(array, key)
+ *     Returns the index of the key in a sorted array. Otherwise, returns
+ *     `-(insertionPoint + 1)`.
+ */
+#define K_DECLARE_ARRAY_INTRINSICS(suffix, Array, Element) \
+    void kush_Array_copy_##suffix(k_Runtime_t* runtime, Array* source, \
+        int64_t sourceIndex, Array* destination, int64_t destinationIndex, \
+        int64_t size); \
+    void kush_Array_fill_##suffix(k_Runtime_t* runtime, Array* array, Element value);
+
+#define K_DECLARE_ORDERED_ARRAY_INTRINSICS(suffix, Array, Element) \
+    K_DECLARE_ARRAY_INTRINSICS(suffix, Array, Element) \
+    void kush_Array_sort_##suffix(k_Runtime_t* runtime, Array* array); \
+    int64_t kush_Array_binarySearch_##suffix(k_Runtime_t* runtime, Array* array, \
+        Element key);
+
+K_DECLARE_ARRAY_INTRINSICS(boolean, k_ArrayBoolean_t, bool)
+
+/* The following intrinsics operate on boolean arrays, a word at a time.
+ *
+ * BitArray_count(array)
+ *     Returns the number of elements that are `true`.
+ * BitArray_findFirst(array, fromIndex)
+ *     Returns the index of the first `true` element at or after `fromIndex`.
+ *     Otherwise, returns -1.
+ * BitArray_and(destination, source)
+ * BitArray_or(destination, source)
+ * BitArray_xor(destination, source)
+ *     Combines each element of the destination with the element of the source
+ *     at the same index. The source must be at least as large as the
+ *     destination.
+ */
+int64_t kush_BitArray_count(k_Runtime_t* runtime, k_ArrayBoolean_t* array);
+int64_t kush_BitArray_findFirst(k_Runtime_t* runtime, k_ArrayBoolean_t* array,
+    int64_t fromIndex);
+void kush_BitArray_and(k_Runtime_t* runtime, k_ArrayBoolean_t* destination,
+    k_ArrayBoolean_t* source);
+void kush_BitArray_or(k_Runtime_t* runtime, k_ArrayBoolean_t* destination,
+    k_ArrayBoolean_t* source);
+void kush_BitArray_xor(k_Runtime_t* runtime, k_ArrayBoolean_t* destination,
+    k_ArrayBoolean_t* source);
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(i8, k_ArrayI8_t, int8_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(i16, k_ArrayI16_t, int16_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(i32, k_IntegerArray_t, int32_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(i64, k_ArrayI64_t, int64_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(ui8, k_ArrayUi8_t, uint8_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(ui16, k_ArrayUi16_t, uint16_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(ui32, k_ArrayUi32_t, uint32_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(ui64, k_ArrayUi64_t, uint64_t)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(f32, k_ArrayF32_t, float)
+K_DECLARE_ORDERED_ARRAY_INTRINSICS(f64, k_ArrayF64_t, double)
+
+/*******************************************************************************
+ * Vector                                                                      *
+ *******************************************************************************/
+
+/* The vector types are mapped to the vector extensions of GCC. The arithmetic
+ * operators work lane by lane, and vectors wider than the registers of the
+ * target are split by GCC. The alignment is reduced to that of a lane, so that
+ * vectors can be stored in objects and lists without padding.
+ *
+ * Vector_splat_*(value)
+ *     Returns a vector with every lane set to the value.
+ * Vector_load_*(array, index)
+ * Vector_store_*(vector, array, index)
+ *     Reads or writes the lanes from consecutive elements of the array,
+ *     starting at the index. Every element must be within the bounds.
+ * Vector_get_*(vector, lane)
+ *     Returns the value of the lane.
+ * Vector_sum_*(vector)
+ *     Returns the sum of the lanes, added from the first to the last.
+ * Vector_min_*(first, second), Vector_max_*(first, second)
+ *     Returns the smaller or larger value of each pair of lanes.
+ */
+
+/* The runtime and the generated code are always compiled with the same flags.
+ * Therefore, the ABI of 256-bit vectors cannot differ between them.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+#define K_DECLARE_VECTOR(name, Element, lanes, Array) \
+    typedef Element k_##name##_t __attribute__((vector_size(sizeof (Element) * (lanes)), \
+        aligned(sizeof (Element)))); \
+    \
+    static inline k_##name##_t kush_Vector_splat_##name(k_Runtime_t* runtime, \
+        Element value) { \
+        k_##name##_t result; \
+        int32_t i; \
+        for (i = 0; i < (lanes); i++) { \
+            result[i] = value; \
+        } \
+        return result; \
+    } \
+    \
+    static inline k_##name##_t kush_Vector_load_##name(k_Runtime_t* runtime, \
+        Array* array, int64_t index) { \
+        k_Runtime_checkIndex(runtime, index, array->size); \
+        k_Runtime_checkIndex(runtime, index + (lanes) - 1, array->size); \
+        k_##name##_t result; \
+        __builtin_memcpy(&result, array->value + index, sizeof (result)); \
+        return result; \
+    } \
+    \
+    static inline void kush_Vector_store_##name(k_Runtime_t* runtime, \
+        k_##name##_t vector, Array* array, int64_t index) { \
+        k_Runtime_checkIndex(runtime, index, array->size); \
+        k_Runtime_checkIndex(runtime, index + (lanes) - 1, array->size); \
+        __builtin_memcpy(array->value + index, &vector, sizeof (vector)); \
+    } \
+    \
+    static inline Element kush_Vector_get_##name(k_Runtime_t* runtime, \
+        k_##name##_t vector, int32_t lane) { \
+        k_Runtime_checkIndex(runtime, lane, (lanes)); \
+        return vector[lane]; \
+    } \
+    \
+    static inline Element kush_Vector_sum_##name(k_Runtime_t* runtime, \
+        k_##name##_t vector) { \
+        Element result = vector[0]; \
+        int32_t i; \
+        for (i = 1; i < (lanes); i++) { \
+            result += vector[i]; \
+        } \
+        return result; \
+    } \
+    \
+    static inline k_##name##_t kush_Vector_min_##name(k_Runtime_t* runtime, \
+        k_##name##_t first, k_##name##_t second) { \
+        k_##name##_t result; \
+        int32_t i; \
+        for (i = 0; i < (lanes); i++) { \
+            result[i] = (first[i] < second[i])? first[i] : second[i]; \
+        } \
+        return result; \
+    } \
+    \
+    static inline k_##name##_t kush_Vector_max_##name(k_Runtime_t* runtime, \
+        k_##name##_t first, k_##name##_t second) { \
+        k_##name##_t result; \
+        int32_t i; \
+        for (i = 0; i < (lanes); i++) { \
+            result[i] = (first[i] > second[i])? first[i] : second[i]; \
+        } \
+        return result; \
+    }
+
+K_DECLARE_VECTOR(i32x4, int32_t, 4, k_IntegerArray_t)
+K_DECLARE_VECTOR(i32x8, int32_t, 8, k_IntegerArray_t)
+K_DECLARE_VECTOR(i64x2, int64_t, 2, k_ArrayI64_t)
+K_DECLARE_VECTOR(i64x4, int64_t, 4, k_ArrayI64_t)
+K_DECLARE_VECTOR(f32x4, float, 4, k_ArrayF32_t)
+K_DECLARE_VECTOR(f32x8, float, 8, k_ArrayF32_t)
+K_DECLARE_VECTOR(f64x2, double, 2, k_ArrayF64_t)
+K_DECLARE_VECTOR(f64x4, double, 4, k_ArrayF64_t)
+
+/*******************************************************************************
+ * Math                                                                        *
+ *******************************************************************************/
+
+/* The scalar functions are delegated to the C math library, which is linked
+ * with every program. `Math_min_*` and `Math_max_*` ignore a NaN operand, like
+ * `fmin` and `fmax`.
+ *
+ * The following kernels operate on whole decimal arrays. They are vectorized
+ * for AVX2 with FMA and for the baseline of the target, and the variant is
+ * selected at run time, depending on the processor.
+ *
+ * Array_sum_*(array)
+ *     Returns the sum of the elements.
+ * Array_dot_*(x, y)
+ *     Returns the sum of the products of the elements of x and y at the same
+ *     index. y must be at least as large as x.
+ * Array_axpy_*(a, x, y)
+ *     Adds a * x[i] to y[i] for each element of y. x must be at least as
+ *     large as y.
+ * Array_scale_*(array, factor)
+ *     Multiplies each element by the factor.
+ *
+ * The reductions add the elements in an unspecified order, which may differ
+ * between processors. Therefore, the last bits of the result may differ.
+ */
+#define K_DECLARE_MATH(suffix, Element, Array, f) \
+    static inline Element kush_Math_sqrt_##suffix(k_Runtime_t* runtime, Element value) { \
+        return __builtin_sqrt##f(value); \
+    } \
+    \
+    static inline Element kush_Math_exp_##suffix(k_Runtime_t* runtime, Element value) { \
+        return __builtin_exp##f(value); \
+    } \
+    \
+    static inline Element kush_Math_log_##suffix(k_Runtime_t* runtime, Element value) { \
+        return __builtin_log##f(value); \
+    } \
+    \
+    static inline Element kush_Math_fma_##suffix(k_Runtime_t* runtime, Element a, \
+        Element b, Element c) { \
+        return __builtin_fma##f(a, b, c); \
+    } \
+    \
+    static inline Element kush_Math_min_##suffix(k_Runtime_t* runtime, Element a, \
+        Element b) { \
+        return __builtin_fmin##f(a, b); \
+    } \
+    \
+    static inline Element kush_Math_max_##suffix(k_Runtime_t* runtime, Element a, \
+        Element b) { \
+        return __builtin_fmax##f(a, b); \
+    } \
+    \
+    Element kush_Array_sum_##suffix(k_Runtime_t* runtime, Array* array); \
+    Element kush_Array_dot_##suffix(k_Runtime_t* runtime, Array* x, Array* y); \
+    void kush_Array_axpy_##suffix(k_Runtime_t* runtime, Element a, Array* x, Array* y); \
+    void kush_Array_scale_##suffix(k_Runtime_t* runtime, Array* array, Element factor);
+
+K_DECLARE_MATH(f32, float, k_ArrayF32_t, f)
+K_DECLARE_MATH(f64, double, k_ArrayF64_t, )
+
 /*******************************************************************************
  * String                                                                      *
  *******************************************************************************/
 
-struct k_ArrayUi8_t {
+/* A string is a single object. The size and the hash live in the header, and
+ * the bytes are stored inline right after it. The bytes are always followed by
+ * a null terminator, which is not included in the size.
+ *
+ * The layout doubles as the view returned by `$String.value`, that is,
+ * `s.value.size` and `s.value[i]` read `size` and `value` directly from the
+ * string object.
+ */
+struct k_String_t {
+    k_ObjectHeader_t header;
     int32_t size;
-    uint8_t* value;
+    /* The hash is computed lazily. Zero indicates that it has not been computed
+     * yet.
+     */
+    uint32_t hash;
+    uint8_t value[];
 };
 
-typedef struct k_ArrayUi8_t k_ArrayUi8_t;
+/* The size of a string is a signed 32-bit integer. */
+#define K_STRING_MAX_SIZE INT32_MAX
 
-struct k_String_t {
+typedef struct k_String_t k_String_t;
+
+k_String_t* newString(k_Runtime_t* runtime, const uint8_t* value, int32_t size);
+/*******************************************************************************
+ * StringBuilder                                                               *
+ *******************************************************************************/
+
+/* The bytes are accumulated in a string object whose size is the capacity of
+ * the builder. When the builder is converted to a string, the buffer itself is
+ * handed over to the caller and the builder starts over with an empty buffer.
+ */
+struct k_StringBuilder_t {
     k_ObjectHeader_t header;
-    k_ArrayUi8_t* value;
+    int32_t size;
+    int32_t capacity;
+    k_String_t* buffer;
 };
 
-typedef struct k_String_t k_String_t;
+typedef struct k_StringBuilder_t k_StringBuilder_t;
+
+/* The analyzer exposes the builder as the synthetic structure `StringBuilder`.
+ * The alias allows the generator to name it like any other structure.
+ */
+typedef k_StringBuilder_t kush_StringBuilder;
+
+k_StringBuilder_t* kush_StringBuilder_new(k_Runtime_t* runtime);
+void kush_StringBuilder_append_s(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    k_String_t* string);
+void kush_StringBuilder_append_i(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    int32_t value);
+void kush_StringBuilder_append_l(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    int64_t value);
+void kush_StringBuilder_append_f(k_Runtime_t* runtime, k_StringBuilder_t* builder,
+    double value);
+k_String_t* kush_StringBuilder_toString(k_Runtime_t* runtime, k_StringBuilder_t* builder);
+
+/*******************************************************************************
+ * File                                                                        *
+ *******************************************************************************/
+
+/* File_map(path)
+ *     Maps the file read-only and returns its contents as a `ui8[]`, without
+ *     copying. The mapping is released when the array is collected. Returns
+ *     null when the file cannot be mapped.
+ *
+ * The mapped array has the layout of the other primitive arrays, but the
+ * collector treats the elements as external memory.
+ */
+k_ArrayUi8_t* kush_File_map(k_Runtime_t* runtime, k_String_t* path);
+
+/* The reader streams a file through a buffer owned by the runtime, so that
+ * files larger than the memory can be processed. The file is closed by
+ * `FileReader_close`, or when the reader is collected.
+ */
+struct k_FileReader_t {
+    k_ObjectHeader_t header;
+    int32_t descriptor;
+    uint8_t* buffer;
+    int32_t capacity;
+    int32_t position;
+    int32_t limit;
+    bool endOfFile;
+};
+
+typedef struct k_FileReader_t k_FileReader_t;
+
+typedef k_FileReader_t kush_FileReader;
+
+/* FileReader_open(path)
+ *     Returns null when the file cannot be opened.
+ * FileReader_readLine(reader)
+ *     Returns the next line without the line terminator, either "\n" or
+ *     "\r\n". Returns null at the end of the file.
+ * FileReader_read(reader, buffer)
+ *     Reads up to `buffer.size` bytes into the array, and returns the number
+ *     of bytes read. Returns 0 at the end of the file.
+ */
+k_FileReader_t* kush_FileReader_open(k_Runtime_t* runtime, k_String_t* path);
+k_String_t* kush_FileReader_readLine(k_Runtime_t* runtime, k_FileReader_t* reader);
+int32_t kush_FileReader_read(k_Runtime_t* runtime, k_FileReader_t* reader,
+    k_ArrayUi8_t* buffer);
+void kush_FileReader_close(k_Runtime_t* runtime, k_FileReader_t* reader);
+
+void k_FileReader_finalize(k_FileReader_t* reader);
+
+/*******************************************************************************
+ * Map                                                                         *
+ *******************************************************************************/
+
+/* The generic builtins store their keys and values as k_Value_t. Integers of
+ * every size and booleans are widened to 64 bits, and decimals are stored as
+ * `double`. The generator wraps the arguments and unwraps the results.
+ */
+union k_Value_t {
+    int64_t integer;
+    double decimal;
+    void* reference;
+};
+
+typedef union k_Value_t k_Value_t;
+
+/* The key kind determines how keys are hashed and compared. Strings are
+ * compared by their contents and references by identity.
+ */
+#define K_MAP_KEY_INTEGER 0
+#define K_MAP_KEY_STRING 1
+#define K_MAP_KEY_REFERENCE 2
+
+struct k_MapEntry_t {
+    k_Value_t key;
+    k_Value_t value;
+};
+
+typedef struct k_MapEntry_t k_MapEntry_t;
+
+/* The map is an open addressing hash table in the style of Swiss tables. Every
+ * slot has a control byte, which marks the slot as empty or deleted, or holds
+ * the low 7 bits of the hash of the key in the slot. The slots are probed in
+ * groups of 16, whose control bytes are compared against the hash in a single
+ * SIMD instruction. The entries are touched only for the matching bytes.
+ *
+ * The control bytes and the entries are allocated outside the heap, and
+ * released when the map is collected.
+ */
+struct k_Map_t {
+    k_ObjectHeader_t header;
+    uint8_t keyKind;
+    bool referenceValues;
+    int64_t size;
+    /* The number of slots, a power of two and a multiple of the group size. */
+    int64_t capacity;
+    /* The number of empty slots that can be filled before the table is
+     * resized, which keeps the load factor at 7/8 or below.
+     */
+    int64_t growthLeft;
+    int8_t* control;
+    k_MapEntry_t* entries;
+};
+
+typedef struct k_Map_t k_Map_t;
+
+typedef k_Map_t kush_Map;
+
+/* Map_get(map, key)
+ *     Returns zero, false, or null when the map does not contain the key.
+ * Map_remove(map, key)
+ *     Returns whether the map contained the key.
+ * Map_next(map, slot)
+ *     Returns the first occupied slot after the specified slot, or -1 when
+ *     there are no more entries. The entries are iterated starting with
+ *     `Map_next(map, -1)`. The slots are invalidated when the map is
+ *     modified.
+ * Map_keyAt(map, slot), Map_valueAt(map, slot)
+ *     Return the key and the value in an occupied slot.
+ */
+k_Map_t* kush_Map_new(k_Runtime_t* runtime, uint8_t keyKind, bool referenceValues);
+void kush_Map_put(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key, k_Value_t value);
+k_Value_t kush_Map_get(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key);
+bool kush_Map_contains(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key);
+bool kush_Map_remove(k_Runtime_t* runtime, k_Map_t* map, k_Value_t key);
+int64_t kush_Map_size(k_Runtime_t* runtime, k_Map_t* map);
+void kush_Map_clear(k_Runtime_t* runtime, k_Map_t* map);
+int64_t kush_Map_next(k_Runtime_t* runtime, k_Map_t* map, int64_t slot);
+k_Value_t kush_Map_keyAt(k_Runtime_t* runtime, k_Map_t* map, int64_t slot);
+k_Value_t kush_Map_valueAt(k_Runtime_t* runtime, k_Map_t* map, int64_t slot);
+
+void k_Map_finalize(k_Map_t* map);
+
+/*******************************************************************************
+ * List                                                                        *
+ *******************************************************************************/
+
+/* The list stores its elements unboxed, in storage allocated outside the
+ * heap, which grows geometrically. The generator passes the C type of the
+ * elements to the builtins, which are macros over the functions below.
+ */
+struct k_List_t {
+    k_ObjectHeader_t header;
+    bool referenceElements;
+    int32_t elementSize;
+    int64_t size;
+    int64_t capacity;
+    void* value;
+};
+
+typedef struct k_List_t k_List_t;
+
+typedef k_List_t kush_List;
+
+k_List_t* kush_List_new(k_Runtime_t* runtime, int32_t elementSize,
+    bool referenceElements);
+void k_List_grow(k_List_t* list, int64_t capacity);
+void k_List_reserve(k_List_t* list, int64_t capacity);
+void k_List_shrinkToFit(k_List_t* list);
+void k_List_finalize(k_List_t* list);
+
+/* Returns the address of the element at the specified index, after checking
+ * the index.
+ */
+static inline void* k_List_at(k_Runtime_t* runtime, k_List_t* list,
+    int64_t index, size_t elementSize) {
+    k_Runtime_checkIndex(runtime, index, list->size);
+    return (uint8_t*)list->value + (index * elementSize);
+}
+
+/* Returns the address of a new element at the end of the list. */
+static inline void* k_List_append(k_List_t* list, size_t elementSize) {
+    if (__builtin_expect(list->size == list->capacity, 0)) {
+        k_List_grow(list, list->size + 1);
+    }
+    return (uint8_t*)list->value + (list->size++ * elementSize);
+}
+
+/* Returns the address of the last element, which is removed from the list. The
+ * storage is not shrunk, so the element remains valid.
+ */
+static inline void* k_List_removeLast(k_Runtime_t* runtime, k_List_t* list,
+    size_t elementSize) {
+    k_Runtime_checkIndex(runtime, list->size - 1, list->size);
+    list->size--;
+    return (uint8_t*)list->value + (list->size * elementSize);
+}
+
+/* The value is evaluated before the element is appended, in case it modifies
+ * the same list.
+ */
+#define kush_List_add(runtime, Element, list, value) \
+    ({ \
+        Element $value = (value); \
+        *(Element*)k_List_append((list), sizeof (Element)) = $value; \
+    })
+
+#define kush_List_get(runtime, Element, list, index) \
+    (*(Element*)k_List_at((runtime), (list), (index), sizeof (Element)))
+
+#define kush_List_set(runtime, Element, list, index, value) \
+    ({ \
+        Element $value = (value); \
+        *(Element*)k_List_at((runtime), (list), (index), sizeof (Element)) = $value; \
+    })
+
+#define kush_List_pop(runtime, Element, list) \
+    (*(Element*)k_List_removeLast((runtime), (list), sizeof (Element)))
+
+#define kush_List_size(runtime, Element, list) ((int64_t)(list)->size)
+
+#define kush_List_capacity(runtime, Element, list) ((int64_t)(list)->capacity)
+
+#define kush_List_reserve(runtime, Element, list, capacity) \
+    k_List_reserve((list), (capacity))
+
+#define kush_List_shrinkToFit(runtime, Element, list) k_List_shrinkToFit(list)
+
+#define kush_List_clear(runtime, Element, list) ((void)((list)->size = 0))
 
 k_String_t* makeString(k_Runtime_t* runtime, const char* sequence);
+uint32_t k_String_hash(k_String_t* string);
+
+/* The following intrinsics are called directly by the generated code. Unlike
+ * the other builtins, they do not push stack frames.
+ */
+bool kush_String_equals(k_Runtime_t* runtime, k_String_t* string1, k_String_t* string2);
+int32_t kush_String_compare(k_Runtime_t* runtime, k_String_t* string1, k_String_t* string2);
+int32_t kush_String_hash(k_Runtime_t* runtime, k_String_t* string);
+int32_t kush_String_indexOf(k_Runtime_t* runtime, k_String_t* string,
+    k_String_t* pattern, int32_t startIndex);
+k_String_t* kush_String_concat(k_Runtime_t* runtime, k_String_t* string1,
+    k_String_t* string2);
+k_String_t* kush_String_slice(k_Runtime_t* runtime, k_String_t* string,
+    int32_t startIndex, int32_t stopIndex);
 void collect(k_Runtime_t* runtime);
 
 void kush_GC_printStats(k_Runtime_t* runtime);
 void kush_printStackTrace(k_Runtime_t* runtime);
-void kush_print_i(k_Runtime_t* runtime, int32_t n);
-void kush_print_s(k_Runtime_t* runtime, k_String_t* s);
 void kush_collect(k_Runtime_t* runtime);
 
+/*******************************************************************************
+ * Output                                                                      *
+ *******************************************************************************/
+
+void k_Output_flush();
+
+/* The print builtins write to the output buffer without pushing stack
+ * frames.
+ */
+void kush_print_i(k_Runtime_t* runtime, int32_t value);
+void kush_print_l(k_Runtime_t* runtime, int64_t value);
+void kush_print_f(k_Runtime_t* runtime, double value);
+void kush_print_s(k_Runtime_t* runtime, k_String_t* string);
+void kush_flush(k_Runtime_t* runtime);
+
+/* Narrows a 64-bit integer, discarding the high bits. */
+static inline int32_t kush_Integer_toI32(k_Runtime_t* runtime, int64_t value) {
+    return (int32_t)value;
+}
+
+/*******************************************************************************
+ * Native                                                                      *
+ *******************************************************************************/
+
+/* The generated code declares a native function as `kush_<name>` and binds it
+ * to the C symbol `<name>` with an assembler label.
+ */
+#define K_STRINGIFY_(value) #value
+#define K_STRINGIFY(value) K_STRINGIFY_(value)
+#define K_NATIVE_SYMBOL(name) K_STRINGIFY(__USER_LABEL_PREFIX__) name
+
+/* Arrays and strings are passed to native functions as pointers to their
+ * elements, without copying. A null reference is passed as a null pointer.
+ * The collector never runs during a native call and objects are never moved,
+ * so the pointers remain valid until the native function returns.
+ */
+#define K_NATIVE_ARRAY(Array, array) \
+    ({ \
+        Array $array = (array); \
+        ($array == NULL)? NULL : $array->value; \
+    })
+
+#define K_NATIVE_STRING(string) \
+    ({ \
+        k_String_t* $string = (string); \
+        ($string == NULL)? NULL : (const char*)$string->value; \
+    })
+
+/* The value of a string is passed to a `ui8[]` parameter as the inline bytes of
+ * the string.
+ */
+#define K_NATIVE_BYTES(string) \
+    ({ \
+        k_String_t* $string = (string); \
+        ($string == NULL)? NULL : $string->value; \
+    })
+
 #define K_PAGE_SIZE 4096
 
 /******************************************************************************
@@ -168,8 +938,8 @@ void kush_collect(k_Runtime_t* runtime);
  ******************************************************************************/
 
 struct k_AllocatorStatistics_t {
-	int32_t pagesMapped;
-	int32_t pagesUnmapped;
+	size_t pagesMapped;
+	size_t pagesUnmapped;
 	int32_t chunksAllocated;
 	int32_t chunksFreed;
 	int32_t freeLength;
@@ -202,8 +972,7 @@ typedef struct k_Allocator_t k_Allocator_t;
 
 void k_Allocator_initialize(k_Allocator_t* allocator);
 void k_Allocator_destroy(k_Allocator_t* allocator);
-void* k_Allocator_allocate(k_Allocator_t* allocator, size_t size);
+K_FAST_PATH void* k_Allocator_allocate(k_Allocator_t* allocator, size_t size);
 void k_Allocator_deallocate(k_Allocator_t* allocator, void* object);
 
-
-
+#endif /* KUSH_RUNTIME_H */
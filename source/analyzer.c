@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <pthread.h>
+
 #include <jtk/collection/Pair.h>
 #include <jtk/core/StringBuilder.h>
 #include <jtk/core/CString.h>
@@ -102,6 +104,7 @@
 
 Type* getArrayType(Analyzer* analyzer, Type* base, int32_t dimensions) ;
 Type* inferArrayType(Analyzer* analyzer, Type* component);
+Type* getGenericType(Analyzer* analyzer, Type* generic, jtk_ArrayList_t* arguments);
 
 static bool import(Analyzer* analyzer, const char* name, int32_t size,
     bool wildcard);
@@ -109,16 +112,25 @@ static void importDefaults(Analyzer* analyzer);
 static void defineStructure(Analyzer* analyzer, Structure* structure);
 static void defineFunction(Analyzer* analyzer, Function* function);
 static Scope* defineLocals(Analyzer* analyzer, Block* block);
+static Type* getVectorType(const uint8_t* name, int32_t size);
 static Type* resolveVariableType(Analyzer* analyzer, VariableType* variableType);
+static Type* resolveTypeArguments(Analyzer* analyzer, Structure* structure,
+    VariableType* variableType);
+static bool isGenericType(Type* type);
+static Type* bindType(Type* type, Type* instance);
 static uint8_t* getModuleName(jtk_ArrayList_t* identifiers, int32_t* size);
 static void resolveVariable(Analyzer* analyzer, Variable* variable);
 static void resolveStructure(Analyzer* analyzer, Structure* structure);
 static void resolveFunction(Analyzer* analyzer, Function* function);
+static bool isNativeType(Type* type, bool parameter);
+static void checkNativeFunction(Analyzer* analyzer, Function* function);
 static void resolveIterativeStatement(Analyzer* analyzer, IterativeStatement* statement);
 static void resolveIfStatement(Analyzer* analyzer, IfStatement* statement);
 static void resolveTryStatement(Analyzer* analyzer, TryStatement* statement);
 static void resolveVariableDeclaration(Analyzer* analyzer, VariableDeclaration* declaration);
 static void resolveLocals(Analyzer* analyzer, Block* block);
+static bool isAssignable(Type* target, Type* source);
+static bool isStringValue(Analyzer* analyzer, Type* type);
 static Type* resolveAssignment(Analyzer* analyzer, BinaryExpression* expression);
 static Type* resolveConditional(Analyzer* analyzer, ConditionalExpression* expression);
 static Type* resolveLogical(Analyzer* analyzer, BinaryExpression* expression);
@@ -134,6 +146,26 @@ static Type* resolveNew(Analyzer* analyzer, NewExpression* expression);
 static Type* resolveArray(Analyzer* analyzer, ArrayExpression* expression);
 static Type* resolveExpression(Analyzer* analyzer, Context* context);
 
+static Context* unwrapExpression(Context* context);
+static Variable* resolveIdentifier(Analyzer* analyzer, Token* token);
+static Variable* getVariable(Analyzer* analyzer, Context* context);
+static Variable* getIndexedVariable(Analyzer* analyzer, PostfixExpression* expression,
+    int32_t count);
+static Variable* getSizedVariable(Analyzer* analyzer, Context* context);
+static bool isNonNegative(Analyzer* analyzer, Context* context, jtk_ArrayList_t* nonNegative,
+    jtk_ArrayList_t* increments);
+static jtk_ArrayList_t* findNonNegativeVariables(Analyzer* analyzer,
+    jtk_ArrayList_t* assignments, jtk_ArrayList_t* increments);
+static void addBoundedIncrement(Analyzer* analyzer, Context* statement,
+    jtk_ArrayList_t* facts);
+static void addIndexFacts(Analyzer* analyzer, Context* condition,
+    jtk_ArrayList_t* nonNegative, jtk_ArrayList_t* facts);
+static jtk_ArrayList_t* filterIndexFacts(Analyzer* analyzer, jtk_ArrayList_t* facts,
+    Context* statement);
+static void eliminateInExpression(Analyzer* analyzer, Context* context,
+    jtk_ArrayList_t* facts);
+static void eliminateBoundsChecks(Analyzer* analyzer, Function* function);
+
 #define invalidate(analyzer) analyzer->scope = analyzer->scope->parent
 
 #define isUndefined(scope, identifier) (resolveSymbol(scope, identifier) == NULL)
@@ -146,10 +178,17 @@ static Type* resolveExpression(Analyzer* analyzer, Context* context);
 
 // Array Type
 
+/* The modules are resolved in parallel. The array types of the primitives
+ * and the instances of the generic types are created on demand, so they are
+ * guarded by a lock.
+ */
+static pthread_mutex_t typeLock = PTHREAD_MUTEX_INITIALIZER;
+
 Type* getArrayType(Analyzer* analyzer, Type* base, int32_t dimensions) {
     Type* result = base;
 
     if (dimensions > 0) {
+        pthread_mutex_lock(&typeLock);
         int32_t maxDimensions = jtk_ArrayList_getSize(base->arrayTypes);
         if (dimensions > maxDimensions) {
             Type* previous = (maxDimensions == 0)? base :
@@ -168,6 +207,7 @@ Type* getArrayType(Analyzer* analyzer, Type* base, int32_t dimensions) {
         }
 
         result = (Type*)jtk_ArrayList_getValue(base->arrayTypes, dimensions - 1);
+        pthread_mutex_unlock(&typeLock);
     }
     return result;
 }
@@ -184,6 +224,72 @@ Type* inferArrayType(Analyzer* analyzer, Type* component) {
     return getArrayType(analyzer, base, dimensions);
 }
 
+// Generic Type
+
+/* Returns the instance of the generic type for the specified type arguments.
+ * The list of arguments is owned by the instance, or deleted if the instance
+ * already exists.
+ */
+Type* getGenericType(Analyzer* analyzer, Type* generic, jtk_ArrayList_t* arguments) {
+    Type* result = NULL;
+    pthread_mutex_lock(&typeLock);
+    if (generic->instances == NULL) {
+        generic->instances = jtk_ArrayList_new();
+    }
+
+    int32_t argumentCount = jtk_ArrayList_getSize(arguments);
+    int32_t count = jtk_ArrayList_getSize(generic->instances);
+    int32_t i;
+    for (i = 0; (i < count) && (result == NULL); i++) {
+        Type* instance = (Type*)jtk_ArrayList_getValue(generic->instances, i);
+        bool equal = true;
+        int32_t j;
+        for (j = 0; (j < argumentCount) && equal; j++) {
+            equal = jtk_ArrayList_getValue(instance->arguments, j) ==
+                jtk_ArrayList_getValue(arguments, j);
+        }
+        if (equal) {
+            result = instance;
+        }
+    }
+
+    if (result == NULL) {
+        result = newType(TYPE_STRUCTURE, false, true, false, true, NULL);
+        result->structure = generic->structure;
+        result->arguments = arguments;
+        jtk_ArrayList_add(generic->instances, result);
+    }
+    else {
+        jtk_ArrayList_delete(arguments);
+    }
+    pthread_mutex_unlock(&typeLock);
+    return result;
+}
+
+/* Determines whether the specified type is a generic type without type
+ * arguments. Such types appear only in the parameters of generic functions.
+ */
+bool isGenericType(Type* type) {
+    return (type->tag == TYPE_STRUCTURE) &&
+        (type->structure->typeParameters != NULL) && (type->arguments == NULL);
+}
+
+/* Substitutes the type arguments of the instance for a type parameter, and
+ * the instance for the generic type itself. Other types are returned as is.
+ * The result is `NULL` if the instance is unknown.
+ */
+Type* bindType(Type* type, Type* instance) {
+    Type* result = type;
+    if (type->tag == TYPE_PARAMETER) {
+        result = (instance == NULL)? NULL :
+            (Type*)jtk_ArrayList_getValue(instance->arguments, type->parameter.index);
+    }
+    else if (isGenericType(type)) {
+        result = instance;
+    }
+    return result;
+}
+
 // Import
 
 bool import(Analyzer* analyzer, const char* name, int32_t size,
@@ -200,7 +306,7 @@ void importDefaults(Analyzer* analyzer) {
 // Define
 
 void defineStructure(Analyzer* analyzer, Structure* structure) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
 
     if (isUndefined(analyzer->scope, structure->name)) {
         defineSymbol(analyzer->scope, (Symbol*)structure);
@@ -234,7 +340,7 @@ void defineStructure(Analyzer* analyzer, Structure* structure) {
 }
 
 void defineFunction(Analyzer* analyzer, Function* function) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
 
     function->scope = scopeForFunction(analyzer->scope, function);
     analyzer->scope = function->scope;
@@ -263,7 +369,10 @@ void defineFunction(Analyzer* analyzer, Function* function) {
         }
     }
 
-    defineLocals(analyzer, function->body);
+    /* Native functions are implemented in C and do not have a body. */
+    if (!hasNative(function->modifiers)) {
+        defineLocals(analyzer, function->body);
+    }
 
     invalidate(analyzer);
 }
@@ -271,7 +380,7 @@ void defineFunction(Analyzer* analyzer, Function* function) {
 // TODO: Why are we returning from defineLocals()?
 // TODO: Should we assign variables their parent scopes?
 Scope* defineLocals(Analyzer* analyzer, Block* block) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
 
     block->scope = scopeForLocal(analyzer->scope, block);
     analyzer->scope = block->scope;
@@ -375,8 +484,33 @@ Scope* defineLocals(Analyzer* analyzer, Block* block) {
 
 // Resolve
 
+/* The vector types are named like structures, rather than keywords. */
+static Type* vectorTypes[] = {
+    &primitives.i32x4,
+    &primitives.i32x8,
+    &primitives.i64x2,
+    &primitives.i64x4,
+    &primitives.f32x4,
+    &primitives.f32x8,
+    &primitives.f64x2,
+    &primitives.f64x4
+};
+
+#define VECTOR_TYPE_COUNT (sizeof (vectorTypes) / sizeof (Type*))
+
+Type* getVectorType(const uint8_t* name, int32_t size) {
+    int32_t i;
+    for (i = 0; i < VECTOR_TYPE_COUNT; i++) {
+        const uint8_t* vectorName = vectorTypes[i]->vector.name;
+        if (jtk_CString_equals(name, size, vectorName, jtk_CString_getSize(vectorName))) {
+            return vectorTypes[i];
+        }
+    }
+    return NULL;
+}
+
 Type* resolveVariableType(Analyzer* analyzer, VariableType* variableType) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Token* token = variableType->token;
     Type* type = NULL;
     bool error = false;
@@ -442,8 +576,19 @@ Type* resolveVariableType(Analyzer* analyzer, VariableType* variableType) {
         }
 
         case TOKEN_IDENTIFIER: {
-            Context* context = (Context*)resolveSymbol(analyzer->scope, token->text);
-            if (context == NULL) {
+            Type* vector = getVectorType(token->text, token->length);
+            Context* context = (vector != NULL)? NULL :
+                (Context*)resolveSymbol(analyzer->scope, token->text);
+            if (vector != NULL) {
+                /* The elements of an array are references or primitives. */
+                if (variableType->dimensions > 0) {
+                    handleSemanticError(handler, analyzer, ERROR_INVALID_TYPE,
+                        token);
+                    error = true;
+                }
+                type = vector;
+            }
+            else if (context == NULL) {
                 handleSemanticError(handler, analyzer, ERROR_UNDECLARED_TYPE,
                     token);
                 error = true;
@@ -454,7 +599,8 @@ Type* resolveVariableType(Analyzer* analyzer, VariableType* variableType) {
                 error = true;
             }
             else {
-                type = ((Structure*)context)->type;
+                type = resolveTypeArguments(analyzer, (Structure*)context, variableType);
+                error = (type == NULL);
             }
             break;
         }
@@ -477,20 +623,84 @@ Type* resolveVariableType(Analyzer* analyzer, VariableType* variableType) {
     return type;
 }
 
+/* Returns the instance of the generic structure for the type arguments of the
+ * variable type. A structure that is not generic is returned as is, provided
+ * that there are no type arguments.
+ */
+Type* resolveTypeArguments(Analyzer* analyzer, Structure* structure,
+    VariableType* variableType) {
+    ErrorHandler* handler = analyzer->errorHandler;
+    Type* result = NULL;
+    int32_t parameterCount = (structure->typeParameters == NULL)? 0 :
+        jtk_ArrayList_getSize(structure->typeParameters);
+    int32_t argumentCount = (variableType->arguments == NULL)? 0 :
+        jtk_ArrayList_getSize(variableType->arguments);
+
+    if (parameterCount != argumentCount) {
+        handleSemanticError(handler, analyzer, ERROR_INVALID_TYPE_ARGUMENT_COUNT,
+            variableType->token);
+    }
+    else if (argumentCount == 0) {
+        result = structure->type;
+    }
+    else {
+        jtk_ArrayList_t* arguments = jtk_ArrayList_new();
+        bool error = false;
+        int32_t i;
+        for (i = 0; i < argumentCount; i++) {
+            VariableType* argumentType = (VariableType*)jtk_ArrayList_getValue(
+                variableType->arguments, i);
+            Type* parameter = (Type*)jtk_ArrayList_getValue(structure->typeParameters, i);
+            Type* argument = resolveVariableType(analyzer, argumentType);
+            if (argument == NULL) {
+                error = true;
+            }
+            else if (parameter->parameter.hashable && (argument->tag != TYPE_INTEGER) &&
+                !argument->reference) {
+                handleSemanticError(handler, analyzer, ERROR_INVALID_KEY_TYPE,
+                    argumentType->token);
+                error = true;
+            }
+            else if (!parameter->parameter.unboxed && (argument->tag == TYPE_VECTOR)) {
+                /* A vector does not fit in k_Value_t. */
+                handleSemanticError(handler, analyzer, ERROR_INVALID_TYPE,
+                    argumentType->token);
+                error = true;
+            }
+            jtk_ArrayList_add(arguments, argument);
+        }
+
+        if (error) {
+            jtk_ArrayList_delete(arguments);
+        }
+        else {
+            result = getGenericType(analyzer, structure->type, arguments);
+        }
+    }
+    return result;
+}
+
 // TODO: Disallow var and let keywords in structures!
 void resolveVariable(Analyzer* analyzer, Variable* variable) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* initializerType = NULL;
     if (variable->expression != NULL) {
         initializerType = resolveExpression(analyzer, (Context*)variable->expression);
     }
 
     if (variable->infer || variable->constant) {
+        if (isStringValue(analyzer, initializerType)) {
+            handleSemanticError(handler, analyzer, ERROR_ESCAPING_STRING_VALUE,
+                variable->identifier);
+            initializerType = NULL;
+        }
         variable->type = initializerType;
     }
     else {
         variable->type = resolveVariableType(analyzer, variable->variableType);
-        if ((variable->expression != NULL) && (variable->type != initializerType)) {
+        if ((variable->expression != NULL) && (variable->type != initializerType) &&
+            ((variable->type == NULL) || (initializerType == NULL) ||
+             !isAssignable(variable->type, initializerType))) {
             handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_VARIABLE_INITIALIZER,
                 variable->identifier);
         }
@@ -535,11 +745,77 @@ void resolveFunction(Analyzer* analyzer, Function* function) {
         resolveVariable(analyzer, function->variableParameter);
     }
 
+    if (hasNative(function->modifiers)) {
+        checkNativeFunction(analyzer, function);
+        return;
+    }
+
     analyzer->scope = function->scope;
     resolveLocals(analyzer, function->body);
     invalidate(analyzer);
 
     function->totalReferences = analyzer->index;
+
+    eliminateBoundsChecks(analyzer, function);
+}
+
+/* The arguments of a native function are passed to C without copying. A
+ * primitive is passed by value, whereas a one-dimensional array of primitives
+ * is passed as a pointer to its elements and a string as a pointer to its
+ * null-terminated bytes. A native function can only return primitives.
+ */
+bool isNativeType(Type* type, bool parameter) {
+    if (type == NULL) {
+        // The error was reported while resolving the type.
+        return true;
+    }
+
+    switch (type->tag) {
+        case TYPE_INTEGER:
+        case TYPE_DECIMAL:
+        case TYPE_BOOLEAN: {
+            return true;
+        }
+
+        case TYPE_VOID: {
+            return !parameter;
+        }
+
+        case TYPE_STRING: {
+            return parameter;
+        }
+
+        case TYPE_ARRAY: {
+            uint8_t tag = type->array.component->tag;
+            return parameter && (type->array.dimensions == 1) &&
+                ((tag == TYPE_INTEGER) || (tag == TYPE_DECIMAL) || (tag == TYPE_BOOLEAN));
+        }
+    }
+    return false;
+}
+
+void checkNativeFunction(Analyzer* analyzer, Function* function) {
+    ErrorHandler* handler = analyzer->errorHandler;
+
+    if (!isNativeType(function->returnType, false)) {
+        handleSemanticError(handler, analyzer, ERROR_INVALID_NATIVE_TYPE,
+            function->returnVariableType->token);
+    }
+
+    int32_t count = jtk_ArrayList_getSize(function->parameters);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        Variable* parameter = (Variable*)jtk_ArrayList_getValue(function->parameters, i);
+        if (!isNativeType(parameter->type, true)) {
+            handleSemanticError(handler, analyzer, ERROR_INVALID_NATIVE_TYPE,
+                parameter->identifier);
+        }
+    }
+
+    if (function->variableParameter != NULL) {
+        handleSemanticError(handler, analyzer, ERROR_INVALID_NATIVE_TYPE,
+            function->variableParameter->identifier);
+    }
 }
 
 uint8_t* getModuleName(jtk_ArrayList_t* identifiers, int32_t* size) {
@@ -561,10 +837,10 @@ uint8_t* getModuleName(jtk_ArrayList_t* identifiers, int32_t* size) {
 }
 
 void resolveIterativeStatement(Analyzer* analyzer, IterativeStatement* statement) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     if (statement->keyword->type == TOKEN_KEYWORD_WHILE) {
         Type* conditionType = resolveExpression(analyzer, (Context*)statement->expression);
-        if (conditionType->tag != TYPE_BOOLEAN) {
+        if ((conditionType != NULL) && (conditionType->tag != TYPE_BOOLEAN)) {
             handleSemanticError(handler, analyzer, ERROR_EXPECTED_BOOLEAN_EXPRESSION,
                 statement->keyword);
         }
@@ -577,7 +853,7 @@ void resolveIterativeStatement(Analyzer* analyzer, IterativeStatement* statement
 }
 
 void resolveIfStatement(Analyzer* analyzer, IfStatement* statement) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* conditionType = resolveExpression(analyzer, (Context*)statement->ifClause->expression);
     if (conditionType != NULL) {
         if (conditionType->tag != TYPE_BOOLEAN) {
@@ -634,7 +910,7 @@ void resolveVariableDeclaration(Analyzer* analyzer, VariableDeclaration* declara
 }
 
 void resolveBreakStatement(Analyzer* analyzer, BreakStatement* statement) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Token* identifier = statement->identifier;
     if (identifier != NULL) {
         Symbol* symbol = resolveSymbol(analyzer->scope, identifier->text);
@@ -650,21 +926,23 @@ void resolveBreakStatement(Analyzer* analyzer, BreakStatement* statement) {
 }
 
 void resolveReturnStatement(Analyzer* analyzer, ReturnStatement* statement) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* type = resolveExpression(analyzer, (Context*)statement->expression);
-    if (analyzer->function->returnType != type) {
+    Type* returnType = analyzer->function->returnType;
+    if ((returnType != type) && ((returnType == NULL) || (type == NULL) ||
+        !isAssignable(returnType, type))) {
         handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_RETURN_VALUE,
             statement->keyword);
     }
 }
 
 void resolveThrowStatement(Analyzer* analyzer, ThrowStatement* statement) {
-    /* ErrorHandler* handler = analyzer->compiler->errorHandler;
+    /* ErrorHandler* handler = analyzer->errorHandler;
     Type* type = */ resolveExpression(analyzer, (Context*)statement->expression);
 }
 
 void resolveLocals(Analyzer* analyzer, Block* block) {
-    // ErrorHandler* handler = analyzer->compiler->errorHandler;
+    // ErrorHandler* handler = analyzer->errorHandler;
     analyzer->scope = block->scope;
 
     int32_t limit = jtk_ArrayList_getSize(block->statements);
@@ -723,12 +1001,36 @@ void resolveLocals(Analyzer* analyzer, Block* block) {
     invalidate(analyzer);
 }
 
+/* Determines whether the type is the view returned by `$String.value`. Since
+ * the view has its own type, it is never assignable to another type. However,
+ * the type of an inferred variable or an array literal is derived from its
+ * initializer, so those are checked explicitly.
+ */
+bool isStringValue(Analyzer* analyzer, Type* type) {
+    Structure* string = (Structure*)resolveSymbol(analyzer->scope, "$String");
+    Variable* value = (Variable*)resolveMember(string->scope, "value");
+    return (type != NULL) && (type == value->type);
+}
+
 // TODO: Ensure that conditional expression does not evaluate to void.
 /* Return the type of the first expression, even if there are errors in the
  * right hand side.
  */
+/* The `null` literal can be assigned to any reference type. An integer can be
+ * widened implicitly, as long as every value of the source type can be
+ * represented by the target type. For example, an `i32` index can be compared
+ * with the `i64` size of an array.
+ */
+bool isAssignable(Type* target, Type* source) {
+    bool widening = (target->tag == TYPE_INTEGER) && (source->tag == TYPE_INTEGER) &&
+        (target->integer.size > source->integer.size) &&
+        (!target->integer.fullWidth || source->integer.fullWidth);
+    return (target == source) || widening ||
+        ((source == &primitives.null) && target->reference);
+}
+
 Type* resolveAssignment(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
@@ -738,7 +1040,7 @@ Type* resolveAssignment(Analyzer* analyzer, BinaryExpression* expression) {
             jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, i);
             Type* rightType = resolveExpression(analyzer, (Context*)pair->m_right);
 
-            if ((rightType != NULL) && (result != rightType)) {
+            if ((rightType != NULL) && !isAssignable(result, rightType)) {
                 handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_OPERAND_TYPES,
                     (Token*)pair->m_left);
             }
@@ -750,7 +1052,7 @@ Type* resolveAssignment(Analyzer* analyzer, BinaryExpression* expression) {
 
 // TODO: `condition? object : null` should work
 Type* resolveConditional(Analyzer* analyzer, ConditionalExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* conditionType = resolveExpression(analyzer, (Context*)expression->condition);
     Type* result = conditionType;
 
@@ -780,7 +1082,7 @@ Type* resolveConditional(Analyzer* analyzer, ConditionalExpression* expression)
 }
 
 Type* resolveLogical(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
@@ -816,7 +1118,7 @@ Type* resolveLogical(Analyzer* analyzer, BinaryExpression* expression) {
 }
 
 Type* resolveBitwise(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
@@ -860,7 +1162,7 @@ Type* resolveBitwise(Analyzer* analyzer, BinaryExpression* expression) {
  * phase ensures that the equality operators are not combined.
  */
 Type* resolveEquality(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
@@ -869,7 +1171,15 @@ Type* resolveEquality(Analyzer* analyzer, BinaryExpression* expression) {
         Type* rightType = resolveExpression(analyzer, (Context*)pair->m_right);
 
         if (rightType != NULL) {
-            if (result != rightType) {
+            /* Vectors are compared lane by lane, which does not result in a
+             * boolean.
+             */
+            if (result->tag == TYPE_VECTOR) {
+                handleSemanticError(handler, analyzer, ERROR_INVALID_LEFT_OPERAND,
+                    (Token*)pair->m_left);
+                result = NULL;
+            }
+            else if (!isAssignable(result, rightType) && !isAssignable(rightType, result)) {
                 handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_OPERAND_TYPES,
                     (Token*)pair->m_left);
                 result = NULL;
@@ -887,7 +1197,7 @@ Type* resolveEquality(Analyzer* analyzer, BinaryExpression* expression) {
  * phase ensures that the equality operators are not combined.
  */
 Type* resolveRelational(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
@@ -906,7 +1216,7 @@ Type* resolveRelational(Analyzer* analyzer, BinaryExpression* expression) {
                     (Token*)pair->m_left);
                 result = NULL;
             }
-            else if (result != rightType) {
+            else if (!isAssignable(result, rightType) && !isAssignable(rightType, result)) {
                 handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_OPERAND_TYPES,
                     (Token*)pair->m_left);
                 result = NULL;
@@ -921,7 +1231,7 @@ Type* resolveRelational(Analyzer* analyzer, BinaryExpression* expression) {
 }
 
 Type* resolveShift(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
@@ -951,16 +1261,24 @@ Type* resolveShift(Analyzer* analyzer, BinaryExpression* expression) {
     return result;
 }
 
-/* TODO: Overload + and * for strings! */
+#define isNumericType(type) \
+    (((type)->tag == TYPE_INTEGER) || ((type)->tag == TYPE_DECIMAL) || \
+     ((type)->tag == TYPE_VECTOR))
+
+/* TODO: Overload + and * for strings!
+ *
+ * The operations on vectors are performed lane by lane. When the other operand
+ * is a scalar of the lane type, it is broadcast to every lane.
+ */
 Type* resolveArithmetic(Analyzer* analyzer, BinaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->left);
 
     int32_t count = jtk_ArrayList_getSize(expression->others);
     if ((result != NULL) && (count > 0)) {
         jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, 0);
 
-        if ((result->tag != TYPE_INTEGER) && (result->tag != TYPE_DECIMAL)) {
+        if (!isNumericType(result)) {
             handleSemanticError(handler, analyzer, ERROR_INVALID_LEFT_OPERAND,
                 (Token*)pair->m_left);
             result = NULL;
@@ -973,12 +1291,33 @@ Type* resolveArithmetic(Analyzer* analyzer, BinaryExpression* expression) {
                 result = resolveExpression(analyzer, (Context*)pair->m_right);
 
                 if (result != NULL) {
-                    if ((result->tag != TYPE_INTEGER) && (result->tag != TYPE_DECIMAL)) {
+                    if (!isNumericType(result)) {
                         handleSemanticError(handler, analyzer, ERROR_INVALID_RIGHT_OPERAND,
                             (Token*)pair->m_left);
                         result = NULL;
                     }
-                    else if (previousType != result) {
+                    else if ((previousType->tag == TYPE_VECTOR) || (result->tag == TYPE_VECTOR)) {
+                        Type* vector = (previousType->tag == TYPE_VECTOR)? previousType : result;
+                        Type* other = (vector == previousType)? result : previousType;
+                        if ((other == vector) || ((other->tag != TYPE_VECTOR) &&
+                            isAssignable(vector->vector.lane, other))) {
+                            result = vector;
+                            previousType = vector;
+                        }
+                        else {
+                            handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_OPERAND_TYPES,
+                                (Token*)pair->m_left);
+                            result = NULL;
+                        }
+                    }
+                    else if (isAssignable(previousType, result)) {
+                        /* The narrower operand is widened. */
+                        result = previousType;
+                    }
+                    else if (isAssignable(result, previousType)) {
+                        previousType = result;
+                    }
+                    else {
                         handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_OPERAND_TYPES,
                             (Token*)pair->m_left);
                         result = NULL;
@@ -992,14 +1331,14 @@ Type* resolveArithmetic(Analyzer* analyzer, BinaryExpression* expression) {
 }
 
 Type* resolveUnary(Analyzer* analyzer, UnaryExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = resolveExpression(analyzer, (Context*)expression->expression);
 
     Token* operator = expression->operator;
     if ((result != NULL) && (operator != NULL)) {
         TokenType token = operator->type;
         if ((token == TOKEN_PLUS) || (token == TOKEN_DASH)) {
-            if ((result->tag != TYPE_INTEGER) && (result->tag != TYPE_DECIMAL)) {
+            if (!isNumericType(result)) {
                 handleSemanticError(handler, analyzer, ERROR_INVALID_OPERAND, operator);
             }
         }
@@ -1023,20 +1362,22 @@ Type* resolveUnary(Analyzer* analyzer, UnaryExpression* expression) {
 
 // TODO: Prevent subscripting more dimensions than what the type allows.
 Type* resolveSubscript(Analyzer* analyzer, Subscript* subscript, Type* previous) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = NULL;
     if (!previous->indexable) {
         handleSemanticError(handler, analyzer, ERROR_INVALID_LEFT_OPERAND,
             subscript->bracket);
     }
     else {
+        /* The index may be of any integer type. */
         Type* indexType = resolveExpression(analyzer, (Context*)subscript->expression);
-        if (indexType != &primitives.i32) {
+        if ((indexType != NULL) && (indexType->tag != TYPE_INTEGER)) {
             handleSemanticError(handler, analyzer, ERROR_EXPECTED_INTEGER_EXPRESSION,
                 subscript->bracket);
         }
 
         result = getArrayType(analyzer, previous->array.base, previous->array.dimensions - 1);
+        subscript->type = result;
     }
     return result;
 }
@@ -1045,7 +1386,7 @@ Type* resolveSubscript(Analyzer* analyzer, Subscript* subscript, Type* previous)
 // This way we can report better error locations.
 Type* resolveFunctionArguments(Analyzer* analyzer, FunctionArguments* arguments,
     Type* previous) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = NULL;
     if (!previous->callable) {
         handleSemanticError(handler, analyzer, ERROR_NON_CALLABLE_TYPE,
@@ -1054,12 +1395,17 @@ Type* resolveFunctionArguments(Analyzer* analyzer, FunctionArguments* arguments,
     else {
         if (previous->tag == TYPE_FUNCTION) {
             Function* function = previous->function;
+            /* The instance of the generic type that is passed to a generic
+             * function. The type parameters are bound to its type arguments.
+             */
+            Type* instance = NULL;
             int32_t j;
 
             /* The return value of the function is considered even if the arguments
-             * are invalid.
+             * are invalid. However, a type parameter cannot be bound without
+             * the arguments.
              */
-            result = function->returnType;
+            result = bindType(function->returnType, NULL);
 
             // TODO: Variable parameters!
             int32_t argumentCount = jtk_ArrayList_getSize(arguments->expressions);
@@ -1069,12 +1415,38 @@ Type* resolveFunctionArguments(Analyzer* analyzer, FunctionArguments* arguments,
                     arguments->parenthesis);
             }
             else {
+                bool native = hasNative(function->modifiers);
+                if (native) {
+                    if (arguments->types == NULL) {
+                        arguments->types = jtk_ArrayList_new();
+                    }
+                    jtk_ArrayList_clear(arguments->types);
+                }
+
                 for (j = 0; j < argumentCount; j++) {
                     BinaryExpression* argument = (BinaryExpression*)jtk_ArrayList_getValue(
                         arguments->expressions, j);
                     Type* argumentType = resolveExpression(analyzer, (Context*)argument);
                     Variable* parameter = (Variable*)jtk_ArrayList_getValue(function->parameters, j);
-                    if (argumentType != parameter->type) {
+                    if (isGenericType(parameter->type) && (argumentType != NULL) &&
+                        (argumentType->tag == TYPE_STRUCTURE) &&
+                        (argumentType->structure == parameter->type->structure)) {
+                        instance = argumentType;
+                    }
+                    Type* parameterType = bindType(parameter->type, instance);
+                    if (native) {
+                        jtk_ArrayList_add(arguments->types, argumentType);
+                        /* The inline bytes of a string can be passed to a
+                         * `ui8[]` parameter, because only the pointer to the
+                         * elements reaches C.
+                         */
+                        if (isStringValue(analyzer, argumentType) &&
+                            (parameterType == getArrayType(analyzer, &primitives.ui8, 1))) {
+                            continue;
+                        }
+                    }
+                    if ((argumentType != parameterType) && ((argumentType == NULL) ||
+                        (parameterType == NULL) || !isAssignable(parameterType, argumentType))) {
                         handleSemanticError(handler, analyzer, ERROR_INCOMPATIBLE_ARGUMENT_TYPE,
                             arguments->parenthesis);
                         /* Since the error message points to the parenthesis, there is
@@ -1084,6 +1456,12 @@ Type* resolveFunctionArguments(Analyzer* analyzer, FunctionArguments* arguments,
                         break;
                     }
                 }
+
+                arguments->function = function;
+                if (instance != NULL) {
+                    result = bindType(function->returnType, instance);
+                    arguments->instance = instance;
+                }
             }
         }
         else {
@@ -1094,7 +1472,7 @@ Type* resolveFunctionArguments(Analyzer* analyzer, FunctionArguments* arguments,
 }
 
 Type* resolveStructureMember(Analyzer* analyzer, Structure* structure, Token* identifier) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = NULL;
     Variable* variable = (Variable*)resolveMember(structure->scope, identifier->text);
 
@@ -1110,12 +1488,13 @@ Type* resolveStructureMember(Analyzer* analyzer, Structure* structure, Token* id
 
 Type* resolveMemberAccess(Analyzer* analyzer, MemberAccess* access, Type* previous) {
     Type* result = NULL;
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     if (!previous->accessible) {
         handleSemanticError(handler, analyzer, ERROR_NON_ACCESSIBLE_TYPE,
             access->identifier);
     }
     else {
+        access->previous = previous;
         Token* identifier = access->identifier;
         if (previous->tag == TYPE_STRUCTURE) {
             Structure* structure = previous->structure;
@@ -1132,12 +1511,13 @@ Type* resolveMemberAccess(Analyzer* analyzer, MemberAccess* access, Type* previo
         else {
             printf("[internal error] This is a valid condition (for example, `array.length`). However, it is yet to be implemented.\n");
         }
+        access->type = result;
     }
     return result;
 }
 
 Type* resolvePostfix(Analyzer* analyzer, PostfixExpression* expression) {
-    // ErrorHandler* handler = analyzer->compiler->errorHandler;
+    // ErrorHandler* handler = analyzer->errorHandler;
     Type* type = expression->token?
         resolveToken(analyzer, (Token*)expression->primary) :
         resolveExpression(analyzer, (Context*)expression->primary);
@@ -1168,7 +1548,7 @@ Type* resolvePostfix(Analyzer* analyzer, PostfixExpression* expression) {
 }
 
 Type* resolveToken(Analyzer* analyzer, Token* token) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = NULL;
     switch (token->type) {
         case TOKEN_IDENTIFIER: {
@@ -1227,7 +1607,7 @@ Type* resolveToken(Analyzer* analyzer, Token* token) {
 
 // TODO: Report var s = null;
 Type* resolveNew(Analyzer* analyzer, NewExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     Type* result = NULL;
     VariableType* variableType = expression->variableType;
     Token* token = variableType->token;
@@ -1244,8 +1624,8 @@ Type* resolveNew(Analyzer* analyzer, NewExpression* expression) {
         else {
             Structure* structure = (Structure*)symbol;
             /* It does not matter if the object initializer has errors. */
-            result = structure->type;
-            expression->type = structure->type;
+            result = resolveTypeArguments(analyzer, structure, variableType);
+            expression->type = result;
 
             int32_t limit = jtk_ArrayList_getSize(expression->entries);
             int32_t i;
@@ -1292,7 +1672,7 @@ Type* resolveNew(Analyzer* analyzer, NewExpression* expression) {
 }
 
 Type* resolveArray(Analyzer* analyzer, ArrayExpression* expression) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
     bool error = false;
 
     Type* firstType = NULL;
@@ -1320,7 +1700,15 @@ Type* resolveArray(Analyzer* analyzer, ArrayExpression* expression) {
     }
 
     Type* result = NULL;
-    if (!error) {
+    if (!error && (firstType != NULL) && (firstType->tag == TYPE_VECTOR)) {
+        handleSemanticError(handler, analyzer, ERROR_INVALID_TYPE,
+            expression->token);
+    }
+    else if (!error && isStringValue(analyzer, firstType)) {
+        handleSemanticError(handler, analyzer, ERROR_ESCAPING_STRING_VALUE,
+            expression->token);
+    }
+    else if (!error) {
         result = inferArrayType(analyzer, firstType);
         expression->type = result;
     }
@@ -1329,7 +1717,7 @@ Type* resolveArray(Analyzer* analyzer, ArrayExpression* expression) {
 }
 
 Type* resolveExpression(Analyzer* analyzer, Context* context) {
-    // ErrorHandler* handler = analyzer->compiler->errorHandler;
+    // ErrorHandler* handler = analyzer->errorHandler;
 
     Type* result = NULL;
     switch (context->tag) {
@@ -1406,93 +1794,1453 @@ Type* resolveExpression(Analyzer* analyzer, Context* context) {
     return result;
 }
 
-// Constructor
+// Bounds Check Elimination
 
-Analyzer* newAnalyzer(Compiler* compiler) {
-    Analyzer* analyzer = allocate(Analyzer, 1);
-    analyzer->compiler = compiler;
-    analyzer->package = NULL;
-    analyzer->packageSize = -1;
-    analyzer->function = NULL;
-    analyzer->index = 0;
+/* Every subscript is checked against the size of the array at runtime, unless
+ * the analyzer can prove that the index is in range. The analysis recognizes
+ * the most common pattern, where a loop walks over an array with a counter.
+ *
+ *     var i = 0;
+ *     while i < array.size {
+ *         print_i(array[i]);
+ *         i += 1;
+ *     }
+ *
+ * The proof has two parts. First, a local variable is non-negative if it is
+ * initialized and updated only with non-negative values, which is evaluated
+ * for the whole function. Second, a condition of the form `i < array.size` or
+ * `i < array.size - c` guarantees the upper bound inside the body of a while
+ * loop or an if clause, until the statement that assigns `i` or `array`. Both
+ * arrays and the `value` of strings are recognized.
+ */
 
-    return analyzer;
-}
+struct Assignment {
+    Variable* target;
+    /* The token is null for variable initializers. */
+    Token* operator;
+    Context* value;
+    Scope* scope;
+};
 
-// Destructor
+typedef struct Assignment Assignment;
 
-void deleteAnalyzer(Analyzer* analyzer) {
-    jtk_Assert_assertObject(analyzer, "The specified analyzer is null.");
+/* Indicates that `index + margin` does not exceed the size of `array`, where
+ * the margin is at least one. When `array` is null, the bound is an integer
+ * literal, which only serves to bound the increments.
+ *
+ * The index itself may be negative. Therefore, the subscripts covered by the
+ * fact and the increments bounded by it are recorded until the non-negative
+ * variables are known.
+ */
+struct IndexFact {
+    Variable* index;
+    Variable* array;
+    int32_t margin;
+    jtk_ArrayList_t* subscripts;
+    jtk_ArrayList_t* increments;
+};
+
+typedef struct IndexFact IndexFact;
+
+#define isBinaryContext(tag) \
+    (((tag) >= CONTEXT_ASSIGNMENT_EXPRESSION) && \
+     ((tag) <= CONTEXT_MULTIPLICATIVE_EXPRESSION) && \
+     ((tag) != CONTEXT_CONDITIONAL_EXPRESSION))
+
+static bool containsContext(jtk_ArrayList_t* contexts, Context* context) {
+    bool result = false;
+    int32_t count = (contexts == NULL)? 0 : jtk_ArrayList_getSize(contexts);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        if (jtk_ArrayList_getValue(contexts, i) == context) {
+            result = true;
+            break;
+        }
+    }
+    return result;
+}
 
-    deallocate(analyzer);
+static bool containsVariable(jtk_ArrayList_t* variables, Variable* variable) {
+    bool result = false;
+    int32_t count = jtk_ArrayList_getSize(variables);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        if (jtk_ArrayList_getValue(variables, i) == variable) {
+            result = true;
+            break;
+        }
+    }
+    return result;
 }
 
-// Reset
+/* Skips the nodes that merely wrap another expression, for example, a
+ * relational expression without operators.
+ */
+Context* unwrapExpression(Context* context) {
+    while (context != NULL) {
+        Context* next = NULL;
+        if (isBinaryContext(context->tag)) {
+            BinaryExpression* expression = (BinaryExpression*)context;
+            if (jtk_ArrayList_getSize(expression->others) == 0) {
+                next = (Context*)expression->left;
+            }
+        }
+        else if (context->tag == CONTEXT_CONDITIONAL_EXPRESSION) {
+            ConditionalExpression* expression = (ConditionalExpression*)context;
+            if (expression->hook == NULL) {
+                next = (Context*)expression->condition;
+            }
+        }
+        else if (context->tag == CONTEXT_UNARY_EXPRESSION) {
+            UnaryExpression* expression = (UnaryExpression*)context;
+            if (expression->operator == NULL) {
+                next = expression->expression;
+            }
+        }
+        else if (context->tag == CONTEXT_POSTFIX_EXPRESSION) {
+            PostfixExpression* expression = (PostfixExpression*)context;
+            if (!expression->token && (jtk_ArrayList_getSize(expression->postfixParts) == 0)) {
+                next = (Context*)expression->primary;
+            }
+        }
 
-void resetAnalyzer(Analyzer* analyzer) {
-    analyzer->function = NULL;
-    analyzer->index = 0;
+        if (next == NULL) {
+            break;
+        }
+        context = next;
+    }
+    return context;
 }
 
-// Define
+Variable* resolveIdentifier(Analyzer* analyzer, Token* token) {
+    Variable* result = NULL;
+    if (token->type == TOKEN_IDENTIFIER) {
+        Symbol* symbol = resolveSymbol(analyzer->scope, token->text);
+        if ((symbol != NULL) && (symbol->tag == CONTEXT_VARIABLE)) {
+            result = (Variable*)symbol;
+        }
+    }
+    return result;
+}
 
-Structure* addSyntheticStructure(Analyzer* analyzer, const uint8_t* name,
-    int32_t nameSize) {
-    Structure* structure = newStructure(name, nameSize, NULL, NULL);
-    structure->scope = scopeForStructure(NULL, structure);
+/* Returns the variable if the expression is a plain variable reference. */
+Variable* getVariable(Analyzer* analyzer, Context* context) {
+    Variable* result = NULL;
+    context = unwrapExpression(context);
+    if (context->tag == CONTEXT_POSTFIX_EXPRESSION) {
+        PostfixExpression* expression = (PostfixExpression*)context;
+        if (expression->token && (jtk_ArrayList_getSize(expression->postfixParts) == 0)) {
+            result = resolveIdentifier(analyzer, (Token*)expression->primary);
+        }
+    }
+    return result;
+}
 
-    defineSymbol(analyzer->scope, structure);
+/* Returns the variable whose elements are accessed by the first `count`
+ * postfix parts, that is, `array` or `string.value`.
+ */
+Variable* getIndexedVariable(Analyzer* analyzer, PostfixExpression* expression,
+    int32_t count) {
+    Variable* result = NULL;
+    if (expression->token) {
+        Variable* variable = resolveIdentifier(analyzer, (Token*)expression->primary);
+        if ((variable != NULL) && (variable->type != NULL)) {
+            if ((count == 0) && (variable->type->tag == TYPE_ARRAY)) {
+                result = variable;
+            }
+            else if ((count == 1) && (variable->type == &primitives.string)) {
+                Context* part = (Context*)jtk_ArrayList_getValue(expression->postfixParts, 0);
+                if ((part->tag == CONTEXT_MEMBER_ACCESS) &&
+                    jtk_CString_equals(((MemberAccess*)part)->identifier->text,
+                        ((MemberAccess*)part)->identifier->length, "value", 5)) {
+                    result = variable;
+                }
+            }
+        }
+    }
+    return result;
+}
 
-    return structure;
+/* Returns the variable if the expression is of the form `array.size` or
+ * `string.value.size`.
+ */
+Variable* getSizedVariable(Analyzer* analyzer, Context* context) {
+    Variable* result = NULL;
+    context = unwrapExpression(context);
+    if (context->tag == CONTEXT_POSTFIX_EXPRESSION) {
+        PostfixExpression* expression = (PostfixExpression*)context;
+        int32_t count = jtk_ArrayList_getSize(expression->postfixParts);
+        if (count > 0) {
+            Context* last = (Context*)jtk_ArrayList_getValue(expression->postfixParts, count - 1);
+            if ((last->tag == CONTEXT_MEMBER_ACCESS) &&
+                jtk_CString_equals(((MemberAccess*)last)->identifier->text,
+                    ((MemberAccess*)last)->identifier->length, "size", 4)) {
+                result = getIndexedVariable(analyzer, expression, count - 1);
+            }
+        }
+    }
+    return result;
 }
 
-Variable* addSyntheticMember(Analyzer* analyzer, Structure* structure,
-    bool constant, const uint8_t* name, int32_t nameSize, Type* type) {
-    Variable* variable = newVariable(false, constant, NULL, name, nameSize,
-        NULL, NULL, structure->scope);
-    variable->type = type;
-    defineSymbol(structure->scope, variable);
+/* A sum of non-negative values may overflow. Therefore, an addition only
+ * qualifies if it is one of the specified increments, whose result is bounded
+ * by the size of an array.
+ */
+bool isNonNegative(Analyzer* analyzer, Context* context, jtk_ArrayList_t* nonNegative,
+    jtk_ArrayList_t* increments) {
+    bool result = false;
+    context = unwrapExpression(context);
+    switch (context->tag) {
+        case CONTEXT_POSTFIX_EXPRESSION: {
+            PostfixExpression* expression = (PostfixExpression*)context;
+            if (expression->token && (jtk_ArrayList_getSize(expression->postfixParts) == 0)) {
+                Token* token = (Token*)expression->primary;
+                result = (token->type == TOKEN_INTEGER_LITERAL) ||
+                    containsVariable(nonNegative, resolveIdentifier(analyzer, token));
+            }
+            else {
+                result = getSizedVariable(analyzer, context) != NULL;
+            }
+            break;
+        }
 
-    return variable;
-}
+        case CONTEXT_ADDITIVE_EXPRESSION:
+        case CONTEXT_MULTIPLICATIVE_EXPRESSION: {
+            BinaryExpression* expression = (BinaryExpression*)context;
+            result = ((context->tag == CONTEXT_MULTIPLICATIVE_EXPRESSION) ||
+                containsContext(increments, context)) &&
+                isNonNegative(analyzer, (Context*)expression->left, nonNegative, increments);
 
-void addSyntheticFunction(Analyzer* analyzer, const uint8_t* name,
-    int32_t nameSize, jtk_ArrayList_t* parameters, Type* returnType)  {
-    Function* function = newFunction(name, nameSize, NULL,
-        parameters, NULL, NULL, NULL);
-    function->returnType = returnType;
-    defineSymbol(analyzer->scope, function);
+            int32_t count = jtk_ArrayList_getSize(expression->others);
+            int32_t i;
+            for (i = 0; (i < count) && result; i++) {
+                jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, i);
+                TokenType operator = ((Token*)pair->m_left)->type;
+                result = (operator != TOKEN_DASH) && (operator != TOKEN_ASTERISK) &&
+                    isNonNegative(analyzer, (Context*)pair->m_right, nonNegative, increments);
+            }
+            break;
+        }
+    }
+    return result;
 }
 
-Variable* makeParameter(Analyzer* analyzer, const uint8_t* name, int32_t nameSize,
-    Type* type) {
-    Variable* variable = newVariable(false, false, NULL, name,
-        nameSize, NULL, NULL, analyzer->scope);
-    variable->type = type;
-    return variable;
+static void collectAssignments(Analyzer* analyzer, Context* context,
+    jtk_ArrayList_t* assignments);
+
+static void addAssignment(Analyzer* analyzer, Variable* target, Token* operator,
+    Context* value, jtk_ArrayList_t* assignments) {
+    Assignment* assignment = allocate(Assignment, 1);
+    assignment->target = target;
+    assignment->operator = operator;
+    assignment->value = value;
+    assignment->scope = analyzer->scope;
+    jtk_ArrayList_add(assignments, assignment);
 }
 
-void defineBuiltins(Analyzer* analyzer) {
-    // $Array
-    Structure* array = addSyntheticStructure(analyzer, "$Array", 6);
-    addSyntheticMember(analyzer, array, true, "size", 4, &primitives.i32);
+static void collectBlockAssignments(Analyzer* analyzer, Block* block,
+    jtk_ArrayList_t* assignments) {
+    Scope* scope = analyzer->scope;
+    analyzer->scope = block->scope;
 
-    // $String
-    Structure* string = addSyntheticStructure(analyzer, "$String", 7);
-    // addSyntheticMember(analyzer, string, true, "size", 4, &primitives.i32);
-    Type* valueType = getArrayType(analyzer, &primitives.ui8, 1);
-    addSyntheticMember(analyzer, string, true, "value", 5, valueType);
+    int32_t count = jtk_ArrayList_getSize(block->statements);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        Context* statement = (Context*)jtk_ArrayList_getValue(block->statements, i);
+        collectAssignments(analyzer, statement, assignments);
+    }
 
-    // print_i
-    jtk_ArrayList_t* parameters = jtk_ArrayList_new();
-    jtk_ArrayList_add(parameters, makeParameter(analyzer, "n", 1, &primitives.i32));
+    analyzer->scope = scope;
+}
+
+/* Collects the assignments and the variable initializers nested anywhere in
+ * the specified statement or expression.
+ */
+void collectAssignments(Analyzer* analyzer, Context* context,
+    jtk_ArrayList_t* assignments) {
+    if (context == NULL) {
+        return;
+    }
+
+    if (isBinaryContext(context->tag)) {
+        BinaryExpression* expression = (BinaryExpression*)context;
+        collectAssignments(analyzer, (Context*)expression->left, assignments);
+
+        int32_t count = jtk_ArrayList_getSize(expression->others);
+        int32_t i;
+        for (i = 0; i < count; i++) {
+            jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, i);
+            collectAssignments(analyzer, (Context*)pair->m_right, assignments);
+        }
+
+        if ((context->tag == CONTEXT_ASSIGNMENT_EXPRESSION) && (count > 0)) {
+            Variable* target = getVariable(analyzer, (Context*)expression->left);
+            if (target != NULL) {
+                jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, 0);
+                Context* value = (count == 1)? (Context*)pair->m_right : NULL;
+                addAssignment(analyzer, target, (Token*)pair->m_left, value, assignments);
+            }
+        }
+        return;
+    }
+
+    switch (context->tag) {
+        case CONTEXT_CONDITIONAL_EXPRESSION: {
+            ConditionalExpression* expression = (ConditionalExpression*)context;
+            collectAssignments(analyzer, (Context*)expression->condition, assignments);
+            collectAssignments(analyzer, (Context*)expression->then, assignments);
+            collectAssignments(analyzer, (Context*)expression->otherwise, assignments);
+            break;
+        }
+
+        case CONTEXT_UNARY_EXPRESSION: {
+            UnaryExpression* expression = (UnaryExpression*)context;
+            collectAssignments(analyzer, expression->expression, assignments);
+            break;
+        }
+
+        case CONTEXT_POSTFIX_EXPRESSION: {
+            PostfixExpression* expression = (PostfixExpression*)context;
+            if (!expression->token) {
+                collectAssignments(analyzer, (Context*)expression->primary, assignments);
+            }
+
+            int32_t count = jtk_ArrayList_getSize(expression->postfixParts);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                Context* postfix = (Context*)jtk_ArrayList_getValue(expression->postfixParts, i);
+                if (postfix->tag == CONTEXT_SUBSCRIPT) {
+                    collectAssignments(analyzer, (Context*)((Subscript*)postfix)->expression,
+                        assignments);
+                }
+                else if (postfix->tag == CONTEXT_FUNCTION_ARGUMENTS) {
+                    jtk_ArrayList_t* arguments = ((FunctionArguments*)postfix)->expressions;
+                    int32_t limit = jtk_ArrayList_getSize(arguments);
+                    int32_t j;
+                    for (j = 0; j < limit; j++) {
+                        collectAssignments(analyzer,
+                            (Context*)jtk_ArrayList_getValue(arguments, j), assignments);
+                    }
+                }
+            }
+            break;
+        }
+
+        case CONTEXT_NEW_EXPRESSION: {
+            NewExpression* expression = (NewExpression*)context;
+            bool array = (expression->type != NULL) && (expression->type->tag == TYPE_ARRAY);
+            int32_t count = jtk_ArrayList_getSize(expression->expressions);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                void* value = jtk_ArrayList_getValue(expression->expressions, i);
+                collectAssignments(analyzer, array? (Context*)value :
+                    (Context*)((jtk_Pair_t*)value)->m_right, assignments);
+            }
+            break;
+        }
+
+        case CONTEXT_ARRAY_EXPRESSION: {
+            ArrayExpression* expression = (ArrayExpression*)context;
+            int32_t count = jtk_ArrayList_getSize(expression->expressions);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                collectAssignments(analyzer,
+                    (Context*)jtk_ArrayList_getValue(expression->expressions, i), assignments);
+            }
+            break;
+        }
+
+        case CONTEXT_VARIABLE_DECLARATION: {
+            VariableDeclaration* declaration = (VariableDeclaration*)context;
+            int32_t count = jtk_ArrayList_getSize(declaration->variables);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                Variable* variable = (Variable*)jtk_ArrayList_getValue(declaration->variables, i);
+                collectAssignments(analyzer, (Context*)variable->expression, assignments);
+                addAssignment(analyzer, variable, NULL, (Context*)variable->expression,
+                    assignments);
+            }
+            break;
+        }
+
+        case CONTEXT_ITERATIVE_STATEMENT: {
+            IterativeStatement* statement = (IterativeStatement*)context;
+            collectAssignments(analyzer, (Context*)statement->expression, assignments);
+            collectBlockAssignments(analyzer, statement->body, assignments);
+            break;
+        }
+
+        case CONTEXT_IF_STATEMENT: {
+            IfStatement* statement = (IfStatement*)context;
+            collectAssignments(analyzer, (Context*)statement->ifClause->expression, assignments);
+            collectBlockAssignments(analyzer, statement->ifClause->body, assignments);
+
+            int32_t count = jtk_ArrayList_getSize(statement->elseIfClauses);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                IfClause* clause = (IfClause*)jtk_ArrayList_getValue(statement->elseIfClauses, i);
+                collectAssignments(analyzer, (Context*)clause->expression, assignments);
+                collectBlockAssignments(analyzer, clause->body, assignments);
+            }
+
+            if (statement->elseClause != NULL) {
+                collectBlockAssignments(analyzer, statement->elseClause, assignments);
+            }
+            break;
+        }
+
+        case CONTEXT_TRY_STATEMENT: {
+            TryStatement* statement = (TryStatement*)context;
+            collectBlockAssignments(analyzer, statement->tryClause, assignments);
+
+            int32_t count = jtk_ArrayList_getSize(statement->catchClauses);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                CatchClause* clause = (CatchClause*)jtk_ArrayList_getValue(statement->catchClauses, i);
+                collectBlockAssignments(analyzer, clause->body, assignments);
+            }
+
+            if (statement->finallyClause != NULL) {
+                collectBlockAssignments(analyzer, statement->finallyClause, assignments);
+            }
+            break;
+        }
+
+        case CONTEXT_RETURN_STATEMENT: {
+            collectAssignments(analyzer, (Context*)((ReturnStatement*)context)->expression,
+                assignments);
+            break;
+        }
+
+        case CONTEXT_THROW_STATEMENT: {
+            collectAssignments(analyzer, (Context*)((ThrowStatement*)context)->expression,
+                assignments);
+            break;
+        }
+    }
+}
+
+static void deleteAssignments(jtk_ArrayList_t* assignments) {
+    int32_t count = jtk_ArrayList_getSize(assignments);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        deallocate(jtk_ArrayList_getValue(assignments, i));
+    }
+    jtk_ArrayList_delete(assignments);
+}
+
+/* Evaluates the local integer variables that never hold negative values. The
+ * evaluation starts by assuming every initialized local is non-negative, and
+ * drops the variables with a disqualifying assignment until nothing changes.
+ * An addition is disqualifying, unless it is one of the specified increments.
+ */
+jtk_ArrayList_t* findNonNegativeVariables(Analyzer* analyzer,
+    jtk_ArrayList_t* assignments, jtk_ArrayList_t* increments) {
+    jtk_ArrayList_t* result = jtk_ArrayList_new();
+    int32_t count = jtk_ArrayList_getSize(assignments);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        Assignment* assignment = (Assignment*)jtk_ArrayList_getValue(assignments, i);
+        Type* type = assignment->target->type;
+        if ((assignment->operator == NULL) && (assignment->value != NULL) &&
+            ((type == &primitives.i32) || (type == &primitives.i64))) {
+            jtk_ArrayList_add(result, assignment->target);
+        }
+    }
+
+    Scope* scope = analyzer->scope;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (i = 0; i < count; i++) {
+            Assignment* assignment = (Assignment*)jtk_ArrayList_getValue(assignments, i);
+            if (containsVariable(result, assignment->target)) {
+                TokenType operator = (assignment->operator == NULL)? TOKEN_EQUAL :
+                    assignment->operator->type;
+                analyzer->scope = assignment->scope;
+                bool valid = (assignment->value != NULL) &&
+                    (((operator == TOKEN_EQUAL) &&
+                      isNonNegative(analyzer, assignment->value, result, increments)) ||
+                     ((operator == TOKEN_PLUS_EQUAL) &&
+                      containsContext(increments, assignment->value)));
+
+                if (!valid) {
+                    jtk_ArrayList_t* filtered = jtk_ArrayList_new();
+                    int32_t limit = jtk_ArrayList_getSize(result);
+                    int32_t j;
+                    for (j = 0; j < limit; j++) {
+                        Variable* variable = (Variable*)jtk_ArrayList_getValue(result, j);
+                        if (variable != assignment->target) {
+                            jtk_ArrayList_add(filtered, variable);
+                        }
+                    }
+                    jtk_ArrayList_delete(result);
+                    result = filtered;
+                    changed = true;
+                }
+            }
+        }
+    }
+    analyzer->scope = scope;
+
+    return result;
+}
+
+/* Returns the value of a decimal integer literal with at most nine digits,
+ * which fits in any integer type of Kush. Otherwise, returns -1.
+ */
+static int32_t getSmallLiteral(Context* context) {
+    int32_t result = -1;
+    context = unwrapExpression(context);
+    if (context->tag == CONTEXT_POSTFIX_EXPRESSION) {
+        PostfixExpression* expression = (PostfixExpression*)context;
+        if (expression->token && (jtk_ArrayList_getSize(expression->postfixParts) == 0)) {
+            Token* token = (Token*)expression->primary;
+            if ((token->type == TOKEN_INTEGER_LITERAL) && (token->length <= 9)) {
+                result = 0;
+                int32_t i;
+                for (i = 0; (i < token->length) && (result >= 0); i++) {
+                    uint8_t digit = token->text[i];
+                    result = ((digit >= '0') && (digit <= '9'))?
+                        (result * 10) + (digit - '0') : -1;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/* Records the increment if a fact bounds `variable + step`. */
+static void addIncrement(jtk_ArrayList_t* facts, Variable* variable, int32_t step,
+    Context* increment) {
+    int32_t count = jtk_ArrayList_getSize(facts);
+    int32_t i;
+    for (i = 0; (i < count) && (variable != NULL) && (step >= 0); i++) {
+        IndexFact* fact = (IndexFact*)jtk_ArrayList_getValue(facts, i);
+        if ((fact->index == variable) && (step <= fact->margin)) {
+            jtk_ArrayList_add(fact->increments, increment);
+            break;
+        }
+    }
+}
+
+/* Records the value if it is of the form `j + c`, where c is a literal. */
+static void addBoundedSum(Analyzer* analyzer, Context* value, jtk_ArrayList_t* facts) {
+    Context* sum = (value != NULL)? unwrapExpression(value) : NULL;
+    if ((sum != NULL) && (sum->tag == CONTEXT_ADDITIVE_EXPRESSION)) {
+        BinaryExpression* additive = (BinaryExpression*)sum;
+        jtk_Pair_t* term = (jtk_ArrayList_getSize(additive->others) == 1)?
+            (jtk_Pair_t*)jtk_ArrayList_getValue(additive->others, 0) : NULL;
+        if ((term != NULL) && (((Token*)term->m_left)->type == TOKEN_PLUS)) {
+            addIncrement(facts, getVariable(analyzer, (Context*)additive->left),
+                getSmallLiteral((Context*)term->m_right), sum);
+        }
+    }
+}
+
+/* Records the assignments and the initializers of the form `j + c`, and the
+ * assignments of the form `i += c`, where c is a literal, that begin while
+ * `j + c`, or `i + c` respectively, is known not to exceed a bound. The sum is
+ * at most the bound, so the increment does not overflow. For an i32 variable
+ * bounded by the size of an array, this relies on the array having fewer than
+ * 2^31 elements; beyond that, the increment overflows in C whether or not the
+ * subscript is checked.
+ */
+void addBoundedIncrement(Analyzer* analyzer, Context* statement, jtk_ArrayList_t* facts) {
+    if (statement->tag == CONTEXT_ASSIGNMENT_EXPRESSION) {
+        BinaryExpression* expression = (BinaryExpression*)statement;
+        jtk_Pair_t* pair = (jtk_ArrayList_getSize(expression->others) == 1)?
+            (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, 0) : NULL;
+        TokenType operator = (pair != NULL)? ((Token*)pair->m_left)->type : TOKEN_EQUAL;
+        if ((pair != NULL) && (operator == TOKEN_PLUS_EQUAL)) {
+            addIncrement(facts, getVariable(analyzer, (Context*)expression->left),
+                getSmallLiteral((Context*)pair->m_right), (Context*)pair->m_right);
+        }
+        else if ((pair != NULL) && (operator == TOKEN_EQUAL)) {
+            addBoundedSum(analyzer, (Context*)pair->m_right, facts);
+        }
+    }
+    else if (statement->tag == CONTEXT_VARIABLE_DECLARATION) {
+        VariableDeclaration* declaration = (VariableDeclaration*)statement;
+        int32_t count = jtk_ArrayList_getSize(declaration->variables);
+        int32_t i;
+        for (i = 0; i < count; i++) {
+            Variable* variable = (Variable*)jtk_ArrayList_getValue(declaration->variables, i);
+            addBoundedSum(analyzer, (Context*)variable->expression, facts);
+        }
+    }
+}
+
+/* Adds the facts established by a condition, when it evaluates to true. */
+void addIndexFacts(Analyzer* analyzer, Context* condition, jtk_ArrayList_t* nonNegative,
+    jtk_ArrayList_t* facts) {
+    condition = unwrapExpression(condition);
+    if (condition->tag == CONTEXT_LOGICAL_AND_EXPRESSION) {
+        BinaryExpression* expression = (BinaryExpression*)condition;
+        addIndexFacts(analyzer, (Context*)expression->left, nonNegative, facts);
+
+        int32_t count = jtk_ArrayList_getSize(expression->others);
+        int32_t i;
+        for (i = 0; i < count; i++) {
+            jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, i);
+            addIndexFacts(analyzer, (Context*)pair->m_right, nonNegative, facts);
+        }
+    }
+    else if (condition->tag == CONTEXT_RELATIONAL_EXPRESSION) {
+        BinaryExpression* expression = (BinaryExpression*)condition;
+        jtk_Pair_t* pair = (jtk_ArrayList_getSize(expression->others) == 1)?
+            (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, 0) : NULL;
+        TokenType operator = (pair != NULL)? ((Token*)pair->m_left)->type :
+            TOKEN_LEFT_ANGLE_BRACKET_2;
+        if ((operator == TOKEN_LEFT_ANGLE_BRACKET) ||
+            (operator == TOKEN_LEFT_ANGLE_BRACKET_EQUAL)) {
+            /* `i < bound` is `i + 1 <= bound`. With `<=`, the left operand must
+             * be of the form `i + c`, where c is a positive literal.
+             */
+            Context* left = (Context*)expression->left;
+            int32_t margin = 1;
+            if (operator == TOKEN_LEFT_ANGLE_BRACKET_EQUAL) {
+                margin = 0;
+                Context* sum = unwrapExpression(left);
+                if (sum->tag == CONTEXT_ADDITIVE_EXPRESSION) {
+                    BinaryExpression* additive = (BinaryExpression*)sum;
+                    jtk_Pair_t* term = (jtk_ArrayList_getSize(additive->others) == 1)?
+                        (jtk_Pair_t*)jtk_ArrayList_getValue(additive->others, 0) : NULL;
+                    if ((term != NULL) && (((Token*)term->m_left)->type == TOKEN_PLUS)) {
+                        left = (Context*)additive->left;
+                        margin = getSmallLiteral((Context*)term->m_right);
+                    }
+                }
+            }
+            Variable* index = (margin > 0)? getVariable(analyzer, left) : NULL;
+
+            /* The upper bound may be `array.size` or `array.size - c`, where
+             * c is non-negative.
+             */
+            Context* bound = unwrapExpression((Context*)pair->m_right);
+            if (bound->tag == CONTEXT_ADDITIVE_EXPRESSION) {
+                BinaryExpression* additive = (BinaryExpression*)bound;
+                bool valid = true;
+                int32_t count = jtk_ArrayList_getSize(additive->others);
+                int32_t i;
+                for (i = 0; i < count; i++) {
+                    jtk_Pair_t* term = (jtk_Pair_t*)jtk_ArrayList_getValue(additive->others, i);
+                    valid = valid && (((Token*)term->m_left)->type == TOKEN_DASH) &&
+                        isNonNegative(analyzer, (Context*)term->m_right, nonNegative, NULL);
+                }
+                bound = valid? (Context*)additive->left : NULL;
+            }
+            Variable* array = (bound != NULL)? getSizedVariable(analyzer, bound) : NULL;
+            bool literal = (bound != NULL) && (getSmallLiteral(bound) >= 0);
+
+            if ((index != NULL) && ((array != NULL) || literal)) {
+                IndexFact* fact = allocate(IndexFact, 1);
+                fact->index = index;
+                fact->array = array;
+                fact->margin = margin;
+                fact->subscripts = jtk_ArrayList_new();
+                fact->increments = jtk_ArrayList_new();
+                jtk_ArrayList_add(facts, fact);
+            }
+        }
+    }
+}
+
+/* Returns a copy of the facts that are not invalidated by the assignments in
+ * the specified statement. The facts themselves are shared.
+ */
+jtk_ArrayList_t* filterIndexFacts(Analyzer* analyzer, jtk_ArrayList_t* facts,
+    Context* statement) {
+    jtk_ArrayList_t* assignments = jtk_ArrayList_new();
+    if (statement != NULL) {
+        collectAssignments(analyzer, statement, assignments);
+    }
+
+    jtk_ArrayList_t* result = jtk_ArrayList_new();
+    int32_t count = jtk_ArrayList_getSize(facts);
+    int32_t limit = jtk_ArrayList_getSize(assignments);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        IndexFact* fact = (IndexFact*)jtk_ArrayList_getValue(facts, i);
+        bool valid = true;
+        int32_t j;
+        for (j = 0; (j < limit) && valid; j++) {
+            Assignment* assignment = (Assignment*)jtk_ArrayList_getValue(assignments, j);
+            valid = (assignment->target != fact->index) && (assignment->target != fact->array);
+        }
+
+        if (valid) {
+            jtk_ArrayList_add(result, fact);
+        }
+    }
+
+    deleteAssignments(assignments);
+
+    return result;
+}
+
+static void eliminateInBlock(Analyzer* analyzer, Block* block,
+    jtk_ArrayList_t* nonNegative, jtk_ArrayList_t* facts, jtk_ArrayList_t* trash);
+
+void eliminateInExpression(Analyzer* analyzer, Context* context,
+    jtk_ArrayList_t* facts) {
+    if (context == NULL) {
+        return;
+    }
+
+    if (isBinaryContext(context->tag)) {
+        BinaryExpression* expression = (BinaryExpression*)context;
+        eliminateInExpression(analyzer, (Context*)expression->left, facts);
+
+        int32_t count = jtk_ArrayList_getSize(expression->others);
+        int32_t i;
+        for (i = 0; i < count; i++) {
+            jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, i);
+            eliminateInExpression(analyzer, (Context*)pair->m_right, facts);
+        }
+        return;
+    }
+
+    switch (context->tag) {
+        case CONTEXT_CONDITIONAL_EXPRESSION: {
+            ConditionalExpression* expression = (ConditionalExpression*)context;
+            eliminateInExpression(analyzer, (Context*)expression->condition, facts);
+            eliminateInExpression(analyzer, (Context*)expression->then, facts);
+            eliminateInExpression(analyzer, (Context*)expression->otherwise, facts);
+            break;
+        }
+
+        case CONTEXT_UNARY_EXPRESSION: {
+            eliminateInExpression(analyzer, ((UnaryExpression*)context)->expression, facts);
+            break;
+        }
+
+        case CONTEXT_POSTFIX_EXPRESSION: {
+            PostfixExpression* expression = (PostfixExpression*)context;
+            if (!expression->token) {
+                eliminateInExpression(analyzer, (Context*)expression->primary, facts);
+            }
+
+            int32_t count = jtk_ArrayList_getSize(expression->postfixParts);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                Context* postfix = (Context*)jtk_ArrayList_getValue(expression->postfixParts, i);
+                if (postfix->tag == CONTEXT_SUBSCRIPT) {
+                    Subscript* subscript = (Subscript*)postfix;
+                    eliminateInExpression(analyzer, (Context*)subscript->expression, facts);
+
+                    Variable* array = getIndexedVariable(analyzer, expression, i);
+                    Variable* index = getVariable(analyzer, (Context*)subscript->expression);
+                    int32_t factCount = jtk_ArrayList_getSize(facts);
+                    int32_t j;
+                    for (j = 0; (j < factCount) && (array != NULL) && (index != NULL); j++) {
+                        IndexFact* fact = (IndexFact*)jtk_ArrayList_getValue(facts, j);
+                        if ((fact->array == array) && (fact->index == index)) {
+                            jtk_ArrayList_add(fact->subscripts, subscript);
+                            break;
+                        }
+                    }
+                    analyzer->function->boundsChecks++;
+                }
+                else if (postfix->tag == CONTEXT_FUNCTION_ARGUMENTS) {
+                    jtk_ArrayList_t* arguments = ((FunctionArguments*)postfix)->expressions;
+                    int32_t limit = jtk_ArrayList_getSize(arguments);
+                    int32_t j;
+                    for (j = 0; j < limit; j++) {
+                        eliminateInExpression(analyzer,
+                            (Context*)jtk_ArrayList_getValue(arguments, j), facts);
+                    }
+                }
+            }
+            break;
+        }
+
+        case CONTEXT_NEW_EXPRESSION: {
+            NewExpression* expression = (NewExpression*)context;
+            bool array = (expression->type != NULL) && (expression->type->tag == TYPE_ARRAY);
+            int32_t count = jtk_ArrayList_getSize(expression->expressions);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                void* value = jtk_ArrayList_getValue(expression->expressions, i);
+                eliminateInExpression(analyzer, array? (Context*)value :
+                    (Context*)((jtk_Pair_t*)value)->m_right, facts);
+            }
+            break;
+        }
+
+        case CONTEXT_ARRAY_EXPRESSION: {
+            ArrayExpression* expression = (ArrayExpression*)context;
+            int32_t count = jtk_ArrayList_getSize(expression->expressions);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                eliminateInExpression(analyzer,
+                    (Context*)jtk_ArrayList_getValue(expression->expressions, i), facts);
+            }
+            break;
+        }
+    }
+}
+
+/* Visits the body of a loop or an if clause with the facts established by its
+ * condition.
+ */
+static void eliminateInClause(Analyzer* analyzer, Context* condition, Block* body,
+    jtk_ArrayList_t* nonNegative, jtk_ArrayList_t* facts, jtk_ArrayList_t* trash) {
+    jtk_ArrayList_t* clauseFacts = filterIndexFacts(analyzer, facts, NULL);
+    int32_t previousSize = jtk_ArrayList_getSize(clauseFacts);
+    addIndexFacts(analyzer, condition, nonNegative, clauseFacts);
+
+    int32_t size = jtk_ArrayList_getSize(clauseFacts);
+    int32_t i;
+    for (i = previousSize; i < size; i++) {
+        jtk_ArrayList_add(trash, jtk_ArrayList_getValue(clauseFacts, i));
+    }
+
+    eliminateInBlock(analyzer, body, nonNegative, clauseFacts, trash);
+    jtk_ArrayList_delete(clauseFacts);
+}
+
+void eliminateInBlock(Analyzer* analyzer, Block* block, jtk_ArrayList_t* nonNegative,
+    jtk_ArrayList_t* facts, jtk_ArrayList_t* trash) {
+    Scope* scope = analyzer->scope;
+    analyzer->scope = block->scope;
+
+    jtk_ArrayList_t* current = filterIndexFacts(analyzer, facts, NULL);
+    int32_t count = jtk_ArrayList_getSize(block->statements);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        Context* statement = (Context*)jtk_ArrayList_getValue(block->statements, i);
+        addBoundedIncrement(analyzer, statement, current);
+
+        /* The facts invalidated anywhere within the statement are discarded
+         * before the statement is visited. This accounts for the assignments
+         * that are evaluated before a subscript, and for the assignments in the
+         * body of a nested loop which reach the beginning of the loop.
+         */
+        jtk_ArrayList_t* filtered = filterIndexFacts(analyzer, current, statement);
+        jtk_ArrayList_delete(current);
+        current = filtered;
+
+        switch (statement->tag) {
+            case CONTEXT_ITERATIVE_STATEMENT: {
+                IterativeStatement* loop = (IterativeStatement*)statement;
+                eliminateInExpression(analyzer, (Context*)loop->expression, current);
+                if (loop->keyword->type == TOKEN_KEYWORD_WHILE) {
+                    eliminateInClause(analyzer, (Context*)loop->expression, loop->body,
+                        nonNegative, current, trash);
+                }
+                else {
+                    eliminateInBlock(analyzer, loop->body, nonNegative, current, trash);
+                }
+                break;
+            }
+
+            case CONTEXT_IF_STATEMENT: {
+                IfStatement* ifStatement = (IfStatement*)statement;
+                IfClause* clause = ifStatement->ifClause;
+                eliminateInExpression(analyzer, (Context*)clause->expression, current);
+                eliminateInClause(analyzer, (Context*)clause->expression, clause->body,
+                    nonNegative, current, trash);
+
+                int32_t limit = jtk_ArrayList_getSize(ifStatement->elseIfClauses);
+                int32_t j;
+                for (j = 0; j < limit; j++) {
+                    clause = (IfClause*)jtk_ArrayList_getValue(ifStatement->elseIfClauses, j);
+                    eliminateInExpression(analyzer, (Context*)clause->expression, current);
+                    eliminateInClause(analyzer, (Context*)clause->expression, clause->body,
+                        nonNegative, current, trash);
+                }
+
+                if (ifStatement->elseClause != NULL) {
+                    eliminateInBlock(analyzer, ifStatement->elseClause, nonNegative,
+                        current, trash);
+                }
+                break;
+            }
+
+            case CONTEXT_TRY_STATEMENT: {
+                TryStatement* tryStatement = (TryStatement*)statement;
+                eliminateInBlock(analyzer, tryStatement->tryClause, nonNegative,
+                    current, trash);
+
+                int32_t limit = jtk_ArrayList_getSize(tryStatement->catchClauses);
+                int32_t j;
+                for (j = 0; j < limit; j++) {
+                    CatchClause* clause = (CatchClause*)jtk_ArrayList_getValue(
+                        tryStatement->catchClauses, j);
+                    eliminateInBlock(analyzer, clause->body, nonNegative, current, trash);
+                }
+
+                if (tryStatement->finallyClause != NULL) {
+                    eliminateInBlock(analyzer, tryStatement->finallyClause, nonNegative,
+                        current, trash);
+                }
+                break;
+            }
+
+            case CONTEXT_VARIABLE_DECLARATION: {
+                VariableDeclaration* declaration = (VariableDeclaration*)statement;
+                int32_t limit = jtk_ArrayList_getSize(declaration->variables);
+                int32_t j;
+                for (j = 0; j < limit; j++) {
+                    Variable* variable = (Variable*)jtk_ArrayList_getValue(
+                        declaration->variables, j);
+                    eliminateInExpression(analyzer, (Context*)variable->expression, current);
+                }
+                break;
+            }
+
+            case CONTEXT_ASSIGNMENT_EXPRESSION: {
+                eliminateInExpression(analyzer, statement, current);
+                break;
+            }
+
+            case CONTEXT_RETURN_STATEMENT: {
+                eliminateInExpression(analyzer,
+                    (Context*)((ReturnStatement*)statement)->expression, current);
+                break;
+            }
+
+            case CONTEXT_THROW_STATEMENT: {
+                eliminateInExpression(analyzer,
+                    (Context*)((ThrowStatement*)statement)->expression, current);
+                break;
+            }
+        }
+    }
+    jtk_ArrayList_delete(current);
+
+    analyzer->scope = scope;
+}
+
+void eliminateBoundsChecks(Analyzer* analyzer, Function* function) {
+    Scope* scope = analyzer->scope;
+    analyzer->scope = function->scope;
+
+    jtk_ArrayList_t* assignments = jtk_ArrayList_new();
+    collectBlockAssignments(analyzer, function->body, assignments);
+    /* The increments are only known once the facts are established. Until
+     * then, the terms subtracted from a size are proven without additions.
+     */
+    jtk_ArrayList_t* nonNegative = findNonNegativeVariables(analyzer, assignments, NULL);
+
+    jtk_ArrayList_t* facts = jtk_ArrayList_new();
+    jtk_ArrayList_t* trash = jtk_ArrayList_new();
+    eliminateInBlock(analyzer, function->body, nonNegative, facts, trash);
+
+    jtk_ArrayList_t* increments = jtk_ArrayList_new();
+    int32_t count = jtk_ArrayList_getSize(trash);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        IndexFact* fact = (IndexFact*)jtk_ArrayList_getValue(trash, i);
+        int32_t limit = jtk_ArrayList_getSize(fact->increments);
+        int32_t j;
+        for (j = 0; j < limit; j++) {
+            jtk_ArrayList_add(increments, jtk_ArrayList_getValue(fact->increments, j));
+        }
+    }
+    jtk_ArrayList_delete(nonNegative);
+    nonNegative = findNonNegativeVariables(analyzer, assignments, increments);
+
+    /* A check is eliminated only if the index is also non-negative. */
+    for (i = 0; i < count; i++) {
+        IndexFact* fact = (IndexFact*)jtk_ArrayList_getValue(trash, i);
+        if (containsVariable(nonNegative, fact->index)) {
+            int32_t limit = jtk_ArrayList_getSize(fact->subscripts);
+            int32_t j;
+            for (j = 0; j < limit; j++) {
+                Subscript* subscript = (Subscript*)jtk_ArrayList_getValue(fact->subscripts, j);
+                if (subscript->checked) {
+                    subscript->checked = false;
+                    analyzer->function->eliminatedChecks++;
+                }
+            }
+        }
+        jtk_ArrayList_delete(fact->subscripts);
+        jtk_ArrayList_delete(fact->increments);
+        deallocate(fact);
+    }
+    jtk_ArrayList_delete(trash);
+    jtk_ArrayList_delete(facts);
+    jtk_ArrayList_delete(increments);
+    jtk_ArrayList_delete(nonNegative);
+    deleteAssignments(assignments);
+
+    analyzer->scope = scope;
+}
+
+// Constructor
+
+Analyzer* newAnalyzer(Compiler* compiler) {
+    Analyzer* analyzer = allocate(Analyzer, 1);
+    analyzer->compiler = compiler;
+    analyzer->errorHandler = compiler->errorHandler;
+    analyzer->package = NULL;
+    analyzer->packageSize = -1;
+    analyzer->function = NULL;
+    analyzer->index = 0;
+
+    return analyzer;
+}
+
+// Destructor
+
+void deleteAnalyzer(Analyzer* analyzer) {
+    jtk_Assert_assertObject(analyzer, "The specified analyzer is null.");
+
+    deallocate(analyzer);
+}
+
+// Reset
+
+void resetAnalyzer(Analyzer* analyzer) {
+    analyzer->function = NULL;
+    analyzer->index = 0;
+}
+
+// Define
+
+Structure* addSyntheticStructure(Analyzer* analyzer, const uint8_t* name,
+    int32_t nameSize) {
+    Structure* structure = newStructure(name, nameSize, NULL, NULL);
+    structure->scope = scopeForStructure(NULL, structure);
+
+    defineSymbol(analyzer->scope, structure);
+
+    return structure;
+}
+
+Variable* addSyntheticMember(Analyzer* analyzer, Structure* structure,
+    bool constant, const uint8_t* name, int32_t nameSize, Type* type) {
+    Variable* variable = newVariable(false, constant, NULL, name, nameSize,
+        NULL, NULL, structure->scope);
+    variable->type = type;
+    defineSymbol(structure->scope, variable);
+
+    return variable;
+}
+
+void addSyntheticFunction(Analyzer* analyzer, const uint8_t* name,
+    int32_t nameSize, jtk_ArrayList_t* parameters, Type* returnType)  {
+    Function* function = newFunction(name, nameSize, NULL,
+        parameters, NULL, NULL, NULL);
+    function->returnType = returnType;
+    defineSymbol(analyzer->scope, function);
+}
+
+Variable* makeParameter(Analyzer* analyzer, const uint8_t* name, int32_t nameSize,
+    Type* type) {
+    Variable* variable = newVariable(false, false, NULL, name,
+        nameSize, NULL, NULL, analyzer->scope);
+    variable->type = type;
+    return variable;
+}
+
+/* Registers an intrinsic whose name ends with the suffix of the array element
+ * type, for example, `Array_sort_i32`, or the name of a vector type.
+ */
+void addArrayIntrinsic(Analyzer* analyzer, const uint8_t* name,
+    const uint8_t* suffix, jtk_ArrayList_t* parameters, Type* returnType) {
+    jtk_StringBuilder_t* builder = jtk_StringBuilder_new();
+    jtk_StringBuilder_appendEx_z(builder, name, jtk_CString_getSize(name));
+    jtk_StringBuilder_appendEx_z(builder, suffix, jtk_CString_getSize(suffix));
+
+    int32_t size;
+    uint8_t* fullName = jtk_StringBuilder_toCString(builder, &size);
+    addSyntheticFunction(analyzer, fullName, size, parameters, returnType);
+
+    jtk_CString_delete(fullName);
+    jtk_StringBuilder_delete(builder);
+}
+
+void defineArrayIntrinsics(Analyzer* analyzer) {
+    Type* elementTypes[] = {
+        &primitives.boolean,
+        &primitives.i8,
+        &primitives.i16,
+        &primitives.i32,
+        &primitives.i64,
+        &primitives.ui8,
+        &primitives.ui16,
+        &primitives.ui32,
+        &primitives.ui64,
+        &primitives.f32,
+        &primitives.f64
+    };
+    const uint8_t* suffixes[] = {
+        "boolean", "i8", "i16", "i32", "i64", "ui8", "ui16", "ui32", "ui64",
+        "f32", "f64"
+    };
+
+    int32_t count = sizeof (elementTypes) / sizeof (Type*);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        Type* elementType = elementTypes[i];
+        Type* arrayType = getArrayType(analyzer, elementType, 1);
+        const uint8_t* suffix = suffixes[i];
+
+        // Array_copy_*(T[], i64, T[], i64, i64)
+        jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "source", 6, arrayType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "sourceIndex", 11, &primitives.i64));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "destination", 11, arrayType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "destinationIndex", 16, &primitives.i64));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "size", 4, &primitives.i64));
+        addArrayIntrinsic(analyzer, "Array_copy_", suffix, parameters, &primitives.void_);
+
+        // Array_fill_*(T[], T)
+        parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, elementType));
+        addArrayIntrinsic(analyzer, "Array_fill_", suffix, parameters, &primitives.void_);
+
+        /* Booleans do not have an order. */
+        if (elementType != &primitives.boolean) {
+            // Array_sort_*(T[])
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+            addArrayIntrinsic(analyzer, "Array_sort_", suffix, parameters, &primitives.void_);
+
+            // Array_binarySearch_*(T[], T)
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "key", 3, elementType));
+            addArrayIntrinsic(analyzer, "Array_binarySearch_", suffix, parameters, &primitives.i64);
+        }
+
+        if (elementType->tag == TYPE_DECIMAL) {
+            // Array_sum_*(T[])
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+            addArrayIntrinsic(analyzer, "Array_sum_", suffix, parameters, elementType);
+
+            // Array_dot_*(T[], T[])
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "x", 1, arrayType));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "y", 1, arrayType));
+            addArrayIntrinsic(analyzer, "Array_dot_", suffix, parameters, elementType);
+
+            // Array_axpy_*(T, T[], T[])
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "a", 1, elementType));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "x", 1, arrayType));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "y", 1, arrayType));
+            addArrayIntrinsic(analyzer, "Array_axpy_", suffix, parameters, &primitives.void_);
+
+            // Array_scale_*(T[], T)
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "factor", 6, elementType));
+            addArrayIntrinsic(analyzer, "Array_scale_", suffix, parameters, &primitives.void_);
+        }
+    }
+
+    Type* bitArrayType = getArrayType(analyzer, &primitives.boolean, 1);
+
+    // BitArray_count(boolean[])
+    jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, bitArrayType));
+    addSyntheticFunction(analyzer, "BitArray_count", 14, parameters, &primitives.i64);
+
+    // BitArray_findFirst(boolean[], i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, bitArrayType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "fromIndex", 9, &primitives.i64));
+    addSyntheticFunction(analyzer, "BitArray_findFirst", 18, parameters, &primitives.i64);
+
+    const uint8_t* operations[] = { "BitArray_and", "BitArray_or", "BitArray_xor" };
+    for (i = 0; i < 3; i++) {
+        // BitArray_*(boolean[], boolean[])
+        parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "destination", 11, bitArrayType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "source", 6, bitArrayType));
+        addSyntheticFunction(analyzer, operations[i],
+            jtk_CString_getSize(operations[i]), parameters, &primitives.void_);
+    }
+}
+
+Type* addTypeParameter(Analyzer* analyzer, Structure* structure, bool hashable,
+    bool unboxed) {
+    if (structure->typeParameters == NULL) {
+        structure->typeParameters = jtk_ArrayList_new();
+    }
+    Type* type = newType(TYPE_PARAMETER, false, false, false, false, NULL);
+    type->parameter.index = jtk_ArrayList_getSize(structure->typeParameters);
+    type->parameter.hashable = hashable;
+    type->parameter.unboxed = unboxed;
+    jtk_ArrayList_add(structure->typeParameters, type);
+
+    return type;
+}
+
+/* The functions that accept `Map` are generic. The map passed as the first
+ * argument binds `K` and `V` for the remaining parameters and the return value.
+ */
+void defineMapIntrinsics(Analyzer* analyzer) {
+    // Map<K, V>
+    Structure* map = addSyntheticStructure(analyzer, "Map", 3);
+    Type* keyType = addTypeParameter(analyzer, map, true, false);
+    Type* valueType = addTypeParameter(analyzer, map, false, false);
+    Type* mapType = map->type;
+
+    // Map_put(Map<K, V>, K, V)
+    jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "key", 3, keyType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, valueType));
+    addSyntheticFunction(analyzer, "Map_put", 7, parameters, &primitives.void_);
+
+    // Map_get(Map<K, V>, K)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "key", 3, keyType));
+    addSyntheticFunction(analyzer, "Map_get", 7, parameters, valueType);
+
+    // Map_contains(Map<K, V>, K)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "key", 3, keyType));
+    addSyntheticFunction(analyzer, "Map_contains", 12, parameters, &primitives.boolean);
+
+    // Map_remove(Map<K, V>, K)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "key", 3, keyType));
+    addSyntheticFunction(analyzer, "Map_remove", 10, parameters, &primitives.boolean);
+
+    // Map_size(Map<K, V>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    addSyntheticFunction(analyzer, "Map_size", 8, parameters, &primitives.i64);
+
+    // Map_clear(Map<K, V>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    addSyntheticFunction(analyzer, "Map_clear", 9, parameters, &primitives.void_);
+
+    // Map_next(Map<K, V>, i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "slot", 4, &primitives.i64));
+    addSyntheticFunction(analyzer, "Map_next", 8, parameters, &primitives.i64);
+
+    // Map_keyAt(Map<K, V>, i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "slot", 4, &primitives.i64));
+    addSyntheticFunction(analyzer, "Map_keyAt", 9, parameters, keyType);
+
+    // Map_valueAt(Map<K, V>, i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "map", 3, mapType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "slot", 4, &primitives.i64));
+    addSyntheticFunction(analyzer, "Map_valueAt", 11, parameters, valueType);
+}
+
+/* Unlike the map, the list stores its elements unboxed. The functions that
+ * accept `List` bind `T` like the functions of the map.
+ */
+void defineListIntrinsics(Analyzer* analyzer) {
+    // List<T>
+    Structure* list = addSyntheticStructure(analyzer, "List", 4);
+    Type* elementType = addTypeParameter(analyzer, list, false, true);
+    Type* listType = list->type;
+
+    // List_add(List<T>, T)
+    jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, elementType));
+    addSyntheticFunction(analyzer, "List_add", 8, parameters, &primitives.void_);
+
+    // List_get(List<T>, i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "index", 5, &primitives.i64));
+    addSyntheticFunction(analyzer, "List_get", 8, parameters, elementType);
+
+    // List_set(List<T>, i64, T)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "index", 5, &primitives.i64));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, elementType));
+    addSyntheticFunction(analyzer, "List_set", 8, parameters, &primitives.void_);
+
+    // List_pop(List<T>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    addSyntheticFunction(analyzer, "List_pop", 8, parameters, elementType);
+
+    // List_size(List<T>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    addSyntheticFunction(analyzer, "List_size", 9, parameters, &primitives.i64);
+
+    // List_capacity(List<T>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    addSyntheticFunction(analyzer, "List_capacity", 13, parameters, &primitives.i64);
+
+    // List_reserve(List<T>, i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "capacity", 8, &primitives.i64));
+    addSyntheticFunction(analyzer, "List_reserve", 12, parameters, &primitives.void_);
+
+    // List_shrinkToFit(List<T>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    addSyntheticFunction(analyzer, "List_shrinkToFit", 16, parameters, &primitives.void_);
+
+    // List_clear(List<T>)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "list", 4, listType));
+    addSyntheticFunction(analyzer, "List_clear", 10, parameters, &primitives.void_);
+}
+
+/* The vector intrinsics load and store the lanes from consecutive elements of
+ * an array, starting at the specified index. A vector is a value, so it can be
+ * passed and returned like a primitive.
+ */
+void defineVectorIntrinsics(Analyzer* analyzer) {
+    int32_t i;
+    for (i = 0; i < VECTOR_TYPE_COUNT; i++) {
+        Type* vectorType = vectorTypes[i];
+        Type* laneType = vectorType->vector.lane;
+        Type* arrayType = getArrayType(analyzer, laneType, 1);
+        const uint8_t* suffix = vectorType->vector.name;
+
+        // Vector_splat_*(T)
+        jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, laneType));
+        addArrayIntrinsic(analyzer, "Vector_splat_", suffix, parameters, vectorType);
+
+        // Vector_load_*(T[], i64)
+        parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "index", 5, &primitives.i64));
+        addArrayIntrinsic(analyzer, "Vector_load_", suffix, parameters, vectorType);
+
+        // Vector_store_*(V, T[], i64)
+        parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "vector", 6, vectorType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "array", 5, arrayType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "index", 5, &primitives.i64));
+        addArrayIntrinsic(analyzer, "Vector_store_", suffix, parameters, &primitives.void_);
+
+        // Vector_get_*(V, i32)
+        parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "vector", 6, vectorType));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "lane", 4, &primitives.i32));
+        addArrayIntrinsic(analyzer, "Vector_get_", suffix, parameters, laneType);
+
+        // Vector_sum_*(V)
+        parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "vector", 6, vectorType));
+        addArrayIntrinsic(analyzer, "Vector_sum_", suffix, parameters, laneType);
+
+        const uint8_t* operations[] = { "Vector_min_", "Vector_max_" };
+        int32_t j;
+        for (j = 0; j < 2; j++) {
+            // Vector_*_*(V, V)
+            parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "first", 5, vectorType));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "second", 6, vectorType));
+            addArrayIntrinsic(analyzer, operations[j], suffix, parameters, vectorType);
+        }
+    }
+}
+
+/* The scalar math functions are specialized for each decimal type, because
+ * `f32` is not assignable to `f64`.
+ */
+void defineMathIntrinsics(Analyzer* analyzer) {
+    Type* decimalTypes[] = { &primitives.f32, &primitives.f64 };
+    const uint8_t* suffixes[] = { "f32", "f64" };
+
+    int32_t i;
+    for (i = 0; i < 2; i++) {
+        Type* type = decimalTypes[i];
+        const uint8_t* suffix = suffixes[i];
+
+        const uint8_t* unaryOperations[] = { "Math_sqrt_", "Math_exp_", "Math_log_" };
+        int32_t j;
+        for (j = 0; j < 3; j++) {
+            // Math_*_*(T)
+            jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, type));
+            addArrayIntrinsic(analyzer, unaryOperations[j], suffix, parameters, type);
+        }
+
+        const uint8_t* binaryOperations[] = { "Math_min_", "Math_max_" };
+        for (j = 0; j < 2; j++) {
+            // Math_*_*(T, T)
+            jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "first", 5, type));
+            jtk_ArrayList_add(parameters, makeParameter(analyzer, "second", 6, type));
+            addArrayIntrinsic(analyzer, binaryOperations[j], suffix, parameters, type);
+        }
+
+        // Math_fma_*(T, T, T)
+        jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "x", 1, type));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "y", 1, type));
+        jtk_ArrayList_add(parameters, makeParameter(analyzer, "z", 1, type));
+        addArrayIntrinsic(analyzer, "Math_fma_", suffix, parameters, type);
+    }
+}
+
+void defineBuiltins(Analyzer* analyzer) {
+    // $Array
+    Structure* array = addSyntheticStructure(analyzer, "$Array", 6);
+    addSyntheticMember(analyzer, array, true, "size", 4, &primitives.i64);
+
+    // $String
+    Structure* string = addSyntheticStructure(analyzer, "$String", 7);
+    // addSyntheticMember(analyzer, string, true, "size", 4, &primitives.i32);
+    /* The bytes of a string are stored inline, so `value` is not a `ui8[]`
+     * object. It is a view that can be indexed and measured, but it has a type
+     * of its own, which prevents it from being stored or passed around.
+     */
+    Type* valueType = newType(TYPE_ARRAY, true, true, false, false, NULL);
+    valueType->array.array = array;
+    valueType->array.base = &primitives.ui8;
+    valueType->array.component = &primitives.ui8;
+    valueType->array.dimensions = 1;
+    addSyntheticMember(analyzer, string, true, "value", 5, valueType);
+
+    // print_i
+    jtk_ArrayList_t* parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "n", 1, &primitives.i32));
     addSyntheticFunction(analyzer, "print_i", 7, parameters, &primitives.void_);
 
+    // print_l
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "n", 1, &primitives.i64));
+    addSyntheticFunction(analyzer, "print_l", 7, parameters, &primitives.void_);
+
+    // print_f
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "n", 1, &primitives.f64));
+    addSyntheticFunction(analyzer, "print_f", 7, parameters, &primitives.void_);
+
     // print_s
     parameters = jtk_ArrayList_new();
     jtk_ArrayList_add(parameters, makeParameter(analyzer, "s", 1, &primitives.string));
     addSyntheticFunction(analyzer, "print_s", 7, parameters, &primitives.void_);
 
+    // flush()
+    parameters = jtk_ArrayList_new();
+    addSyntheticFunction(analyzer, "flush", 5, parameters, &primitives.void_);
+
+    /* Integers are widened implicitly, but narrowing must be explicit. For
+     * example, the `i64` size of an array is narrowed with `Integer_toI32()`
+     * before it is passed to an `i32` parameter.
+     */
+    // Integer_toI32(i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "n", 1, &primitives.i64));
+    addSyntheticFunction(analyzer, "Integer_toI32", 13, parameters, &primitives.i32);
+
     // GC_printStats()
     parameters = jtk_ArrayList_new();
     addSyntheticFunction(analyzer, "GC_printStats", 13, parameters, &primitives.void_);
@@ -1504,10 +3252,122 @@ void defineBuiltins(Analyzer* analyzer) {
     // collect()
     parameters = jtk_ArrayList_new();
     addSyntheticFunction(analyzer, "collect", 7, parameters, &primitives.void_);
+
+    // String_equals(string, string)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string1", 7, &primitives.string));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string2", 7, &primitives.string));
+    addSyntheticFunction(analyzer, "String_equals", 13, parameters, &primitives.boolean);
+
+    // String_compare(string, string)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string1", 7, &primitives.string));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string2", 7, &primitives.string));
+    addSyntheticFunction(analyzer, "String_compare", 14, parameters, &primitives.i32);
+
+    // String_hash(string)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string", 6, &primitives.string));
+    addSyntheticFunction(analyzer, "String_hash", 11, parameters, &primitives.i32);
+
+    // String_indexOf(string, string, i32)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string", 6, &primitives.string));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "pattern", 7, &primitives.string));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "startIndex", 10, &primitives.i32));
+    addSyntheticFunction(analyzer, "String_indexOf", 14, parameters, &primitives.i32);
+
+    // String_concat(string, string)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string1", 7, &primitives.string));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string2", 7, &primitives.string));
+    addSyntheticFunction(analyzer, "String_concat", 13, parameters, &primitives.string);
+
+    // String_slice(string, i32, i32)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "string", 6, &primitives.string));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "startIndex", 10, &primitives.i32));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "stopIndex", 9, &primitives.i32));
+    addSyntheticFunction(analyzer, "String_slice", 12, parameters, &primitives.string);
+
+    // StringBuilder
+    Structure* builder = addSyntheticStructure(analyzer, "StringBuilder", 13);
+    addSyntheticMember(analyzer, builder, true, "size", 4, &primitives.i32);
+    Type* builderType = builder->type;
+
+    // StringBuilder_new()
+    parameters = jtk_ArrayList_new();
+    addSyntheticFunction(analyzer, "StringBuilder_new", 17, parameters, builderType);
+
+    // StringBuilder_append_s(StringBuilder, string)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "builder", 7, builderType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, &primitives.string));
+    addSyntheticFunction(analyzer, "StringBuilder_append_s", 22, parameters, &primitives.void_);
+
+    // StringBuilder_append_i(StringBuilder, i32)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "builder", 7, builderType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, &primitives.i32));
+    addSyntheticFunction(analyzer, "StringBuilder_append_i", 22, parameters, &primitives.void_);
+
+    // StringBuilder_append_l(StringBuilder, i64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "builder", 7, builderType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, &primitives.i64));
+    addSyntheticFunction(analyzer, "StringBuilder_append_l", 22, parameters, &primitives.void_);
+
+    // StringBuilder_append_f(StringBuilder, f64)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "builder", 7, builderType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "value", 5, &primitives.f64));
+    addSyntheticFunction(analyzer, "StringBuilder_append_f", 22, parameters, &primitives.void_);
+
+    // StringBuilder_toString(StringBuilder)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "builder", 7, builderType));
+    addSyntheticFunction(analyzer, "StringBuilder_toString", 22, parameters, &primitives.string);
+
+    // File_map(string)
+    Type* bytesType = getArrayType(analyzer, &primitives.ui8, 1);
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "path", 4, &primitives.string));
+    addSyntheticFunction(analyzer, "File_map", 8, parameters, bytesType);
+
+    // FileReader
+    Structure* reader = addSyntheticStructure(analyzer, "FileReader", 10);
+    Type* readerType = reader->type;
+
+    // FileReader_open(string)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "path", 4, &primitives.string));
+    addSyntheticFunction(analyzer, "FileReader_open", 15, parameters, readerType);
+
+    // FileReader_readLine(FileReader)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "reader", 6, readerType));
+    addSyntheticFunction(analyzer, "FileReader_readLine", 19, parameters, &primitives.string);
+
+    // FileReader_read(FileReader, ui8[])
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "reader", 6, readerType));
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "buffer", 6, bytesType));
+    addSyntheticFunction(analyzer, "FileReader_read", 15, parameters, &primitives.i32);
+
+    // FileReader_close(FileReader)
+    parameters = jtk_ArrayList_new();
+    jtk_ArrayList_add(parameters, makeParameter(analyzer, "reader", 6, readerType));
+    addSyntheticFunction(analyzer, "FileReader_close", 16, parameters, &primitives.void_);
+
+    defineArrayIntrinsics(analyzer);
+    defineMapIntrinsics(analyzer);
+    defineListIntrinsics(analyzer);
+    defineVectorIntrinsics(analyzer);
+    defineMathIntrinsics(analyzer);
 }
 
 void defineSymbols(Analyzer* analyzer, Module* module) {
-    ErrorHandler* handler = analyzer->compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
 
     module->scope = scopeForModule(module);
     analyzer->scope = module->scope;
@@ -1549,8 +3409,7 @@ void defineSymbols(Analyzer* analyzer, Module* module) {
 // Resolve
 
 void resolveSymbols(Analyzer* analyzer, Module* module) {
-    Compiler* compiler = analyzer->compiler;
-    ErrorHandler* handler = compiler->errorHandler;
+    ErrorHandler* handler = analyzer->errorHandler;
 
     analyzer->scope = module->scope;
 
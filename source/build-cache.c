@@ -0,0 +1,518 @@
+/*
+ * Copyright 2017-2020 Samuel Rowe, Joel E. Rego
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Sunday, October 18, 2026
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <jtk/core/CString.h>
+
+#include <kush/build-cache.h>
+
+static BuildCacheEntry* findEntry(BuildCache* cache, const uint8_t* path);
+static void loadBuildCache(BuildCache* cache);
+static bool getModificationTime(const char* path, struct timespec* time);
+static bool isNewer(const char* path, const struct timespec* time);
+static uint8_t* readFile(const char* path, size_t* size);
+static char* getObjectPath(ObjectCache* cache, uint64_t key);
+static bool copyFile(const char* source, const char* target);
+static int compareEntries(const void* entry1, const void* entry2);
+
+/*******************************************************************************
+ * BuildCache                                                                  *
+ *******************************************************************************/
+
+// Constructor
+
+BuildCache* newBuildCache(const char* path, uint64_t key) {
+    BuildCache* cache = allocate(BuildCache, 1);
+    cache->path = path;
+    cache->key = key;
+    cache->entries = jtk_ArrayList_new();
+    cache->dirty = false;
+
+    loadBuildCache(cache);
+
+    return cache;
+}
+
+// Destructor
+
+void deleteBuildCache(BuildCache* cache) {
+    jtk_Assert_assertObject(cache, "The specified build cache is null.");
+
+    int32_t count = jtk_ArrayList_getSize(cache->entries);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        BuildCacheEntry* entry = (BuildCacheEntry*)jtk_ArrayList_getValue(cache->entries, i);
+        jtk_CString_delete(entry->path);
+        deallocate(entry);
+    }
+    jtk_ArrayList_delete(cache->entries);
+    deallocate(cache);
+}
+
+// Load
+
+void loadBuildCache(BuildCache* cache) {
+    FILE* file = fopen(cache->path, "r");
+    if (file != NULL) {
+        uint64_t key;
+        if ((fscanf(file, "%" SCNx64 "\n", &key) == 1) && (key == cache->key)) {
+            char line[4096];
+            while (fgets(line, sizeof (line), file) != NULL) {
+                /* Each line is formatted as "<hash> <path>\n". */
+                char* path = strchr(line, ' ');
+                size_t size = strlen(line);
+                if ((path == NULL) || (line[size - 1] != '\n')) {
+                    continue;
+                }
+                line[size - 1] = '\0';
+                path++;
+
+                uint64_t hash = strtoull(line, NULL, 16);
+                updateBuildCache(cache, (const uint8_t*)path, hash);
+            }
+        }
+        fclose(file);
+    }
+    cache->dirty = false;
+}
+
+// Cache
+
+BuildCacheEntry* findEntry(BuildCache* cache, const uint8_t* path) {
+    BuildCacheEntry* result = NULL;
+    int32_t count = jtk_ArrayList_getSize(cache->entries);
+    int32_t i;
+    for (i = 0; (i < count) && (result == NULL); i++) {
+        BuildCacheEntry* entry = (BuildCacheEntry*)jtk_ArrayList_getValue(cache->entries, i);
+        if (strcmp((const char*)entry->path, (const char*)path) == 0) {
+            result = entry;
+        }
+    }
+    return result;
+}
+
+bool isUpToDate(BuildCache* cache, const uint8_t* path, uint64_t hash) {
+    BuildCacheEntry* entry = findEntry(cache, path);
+    return (entry != NULL) && (entry->hash == hash);
+}
+
+void updateBuildCache(BuildCache* cache, const uint8_t* path, uint64_t hash) {
+    BuildCacheEntry* entry = findEntry(cache, path);
+    if (entry == NULL) {
+        entry = allocate(BuildCacheEntry, 1);
+        entry->path = jtk_CString_new(path);
+        entry->hash = hash;
+        jtk_ArrayList_add(cache->entries, entry);
+        cache->dirty = true;
+    }
+    else if (entry->hash != hash) {
+        entry->hash = hash;
+        cache->dirty = true;
+    }
+}
+
+bool saveBuildCache(BuildCache* cache) {
+    bool result = true;
+    if (cache->dirty) {
+        FILE* file = fopen(cache->path, "w");
+        if (file == NULL) {
+            result = false;
+        }
+        else {
+            fprintf(file, "%016" PRIx64 "\n", cache->key);
+            int32_t count = jtk_ArrayList_getSize(cache->entries);
+            int32_t i;
+            for (i = 0; i < count; i++) {
+                BuildCacheEntry* entry = (BuildCacheEntry*)jtk_ArrayList_getValue(cache->entries, i);
+                fprintf(file, "%016" PRIx64 " %s\n", entry->hash, entry->path);
+            }
+            result = (fclose(file) == 0);
+            cache->dirty = false;
+        }
+    }
+    return result;
+}
+
+// Hash
+
+uint64_t hashBytes(uint64_t hash, const void* bytes, size_t size) {
+    const uint8_t* current = (const uint8_t*)bytes;
+    size_t i;
+    for (i = 0; i < size; i++) {
+        hash ^= current[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+bool hashFile(const char* path, uint64_t* hash) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    uint64_t result = KUSH_HASH_SEED;
+    uint8_t buffer[16384];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof (buffer), file)) > 0) {
+        result = hashBytes(result, buffer, size);
+    }
+    bool success = !ferror(file);
+    fclose(file);
+
+    *hash = result;
+    return success;
+}
+
+// File
+
+bool writeIfChanged(const char* path, const uint8_t* contents, size_t size) {
+    bool changed = true;
+    FILE* file = fopen(path, "rb");
+    if (file != NULL) {
+        /* Compare the existing contents block by block. */
+        uint8_t buffer[16384];
+        size_t offset = 0;
+        size_t count;
+        changed = false;
+        while (!changed && ((count = fread(buffer, 1, sizeof (buffer), file)) > 0)) {
+            changed = (offset + count > size) ||
+                (memcmp(buffer, contents + offset, count) != 0);
+            offset += count;
+        }
+        changed = changed || (offset != size);
+        fclose(file);
+    }
+
+    bool result = true;
+    if (changed) {
+        file = fopen(path, "wb");
+        if (file == NULL) {
+            result = false;
+        }
+        else {
+            result = (fwrite(contents, 1, size, file) == size);
+            result = (fclose(file) == 0) && result;
+        }
+    }
+    return result;
+}
+
+bool makeDirectories(const char* path) {
+    size_t size = strlen(path);
+    char* current = allocate(char, size + 1);
+    memcpy(current, path, size + 1);
+
+    bool result = true;
+    size_t i;
+    for (i = 1; (i <= size) && result; i++) {
+        if ((current[i] == '/') || (current[i] == '\0')) {
+            char separator = current[i];
+            current[i] = '\0';
+            result = (mkdir(current, 0755) == 0) || (errno == EEXIST);
+            current[i] = separator;
+        }
+    }
+    deallocate(current);
+
+    return result;
+}
+
+// Dependencies
+
+bool getModificationTime(const char* path, struct timespec* time) {
+    struct stat status;
+    bool result = (stat(path, &status) == 0);
+    if (result) {
+        *time = status.st_mtim;
+    }
+    return result;
+}
+
+/* A file that cannot be examined is treated as newer, so that the target is
+ * rebuilt.
+ */
+bool isNewer(const char* path, const struct timespec* time) {
+    struct timespec modified;
+    return !getModificationTime(path, &modified) ||
+        (modified.tv_sec > time->tv_sec) ||
+        ((modified.tv_sec == time->tv_sec) && (modified.tv_nsec > time->tv_nsec));
+}
+
+uint8_t* readFile(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    uint8_t* contents = allocate(uint8_t, capacity + 1);
+    size_t count;
+    *size = 0;
+    while ((count = fread(contents + *size, 1, capacity - *size, file)) > 0) {
+        *size += count;
+        if (*size == capacity) {
+            uint8_t* buffer = allocate(uint8_t, capacity * 2 + 1);
+            memcpy(buffer, contents, capacity);
+            deallocate(contents);
+            contents = buffer;
+            capacity *= 2;
+        }
+    }
+    contents[*size] = '\0';
+    fclose(file);
+
+    return contents;
+}
+
+bool isOutdated(const char* target, const char* commandFile,
+    const char* dependencyFile) {
+    struct timespec time;
+    if (!getModificationTime(target, &time) || isNewer(commandFile, &time)) {
+        return true;
+    }
+
+    size_t size;
+    uint8_t* contents = readFile(dependencyFile, &size);
+    if (contents == NULL) {
+        return true;
+    }
+
+    /* The dependencies follow the first colon. They are separated by
+     * whitespace and escaped newlines. A space within a path is escaped
+     * with a backslash.
+     */
+    bool result = false;
+    uint8_t* current = (uint8_t*)memchr(contents, ':', size);
+    uint8_t* end = contents + size;
+    char* path = allocate(char, size + 1);
+    if (current != NULL) {
+        current++;
+        while (!result && (current < end)) {
+            int32_t length = 0;
+            while (current < end) {
+                if ((current[0] == '\\') && (current + 1 < end) &&
+                    ((current[1] == ' ') || (current[1] == '\\'))) {
+                    path[length++] = (char)current[1];
+                    current += 2;
+                }
+                else if ((current[0] == '\\') && (current + 1 < end) &&
+                    ((current[1] == '\n') || (current[1] == '\r'))) {
+                    current++;
+                }
+                else if ((current[0] == ' ') || (current[0] == '\t') ||
+                    (current[0] == '\n') || (current[0] == '\r')) {
+                    current++;
+                    if (length > 0) {
+                        break;
+                    }
+                }
+                else {
+                    path[length++] = (char)*current;
+                    current++;
+                }
+            }
+
+            if (length > 0) {
+                path[length] = '\0';
+                result = isNewer(path, &time);
+            }
+        }
+    }
+    deallocate(path);
+    deallocate(contents);
+
+    return result;
+}
+
+/*******************************************************************************
+ * ObjectCache                                                                 *
+ *******************************************************************************/
+
+// Constructor
+
+ObjectCache* newObjectCache(const char* directory, uint64_t limit) {
+    if (!makeDirectories(directory)) {
+        return NULL;
+    }
+
+    ObjectCache* cache = allocate(ObjectCache, 1);
+    size_t size = strlen(directory);
+    cache->directory = allocate(char, size + 1);
+    memcpy(cache->directory, directory, size + 1);
+    cache->limit = limit;
+
+    return cache;
+}
+
+// Destructor
+
+void deleteObjectCache(ObjectCache* cache) {
+    jtk_Assert_assertObject(cache, "The specified object cache is null.");
+
+    deallocate(cache->directory);
+    deallocate(cache);
+}
+
+// Cache
+
+char* getObjectPath(ObjectCache* cache, uint64_t key) {
+    size_t size = strlen(cache->directory) + 20;
+    char* path = allocate(char, size + 1);
+    snprintf(path, size + 1, "%s/%016" PRIx64 ".o", cache->directory, key);
+    return path;
+}
+
+bool copyFile(const char* source, const char* target) {
+    FILE* input = fopen(source, "rb");
+    if (input == NULL) {
+        return false;
+    }
+
+    bool result = false;
+    FILE* output = fopen(target, "wb");
+    if (output != NULL) {
+        uint8_t buffer[16384];
+        size_t count;
+        result = true;
+        while (result && ((count = fread(buffer, 1, sizeof (buffer), input)) > 0)) {
+            result = (fwrite(buffer, 1, count, output) == count);
+        }
+        result = !ferror(input) && (fclose(output) == 0) && result;
+    }
+    fclose(input);
+
+    return result;
+}
+
+bool fetchObject(ObjectCache* cache, uint64_t key, const char* path) {
+    char* objectPath = getObjectPath(cache, key);
+    bool result = copyFile(objectPath, path);
+    if (result) {
+        /* Mark the object as recently used. */
+        utimensat(AT_FDCWD, objectPath, NULL, 0);
+    }
+    else {
+        remove(path);
+    }
+    deallocate(objectPath);
+
+    return result;
+}
+
+void storeObject(ObjectCache* cache, uint64_t key, const char* path) {
+    /* The object is copied to a temporary file and renamed into place, so
+     * that other builds never see a partial object.
+     */
+    char* objectPath = getObjectPath(cache, key);
+    size_t size = strlen(objectPath) + 32;
+    char* temporaryPath = allocate(char, size + 1);
+    snprintf(temporaryPath, size + 1, "%s.%ld.%lx.tmp", objectPath, (long)getpid(),
+        (unsigned long)pthread_self());
+
+    if (!copyFile(path, temporaryPath) || (rename(temporaryPath, objectPath) != 0)) {
+        remove(temporaryPath);
+    }
+    deallocate(temporaryPath);
+    deallocate(objectPath);
+}
+
+struct ObjectCacheEntry {
+    char* name;
+    uint64_t size;
+    struct timespec time;
+};
+
+typedef struct ObjectCacheEntry ObjectCacheEntry;
+
+int compareEntries(const void* entry1, const void* entry2) {
+    const ObjectCacheEntry* first = (const ObjectCacheEntry*)entry1;
+    const ObjectCacheEntry* second = (const ObjectCacheEntry*)entry2;
+    if (first->time.tv_sec != second->time.tv_sec) {
+        return (first->time.tv_sec < second->time.tv_sec)? -1 : 1;
+    }
+    if (first->time.tv_nsec != second->time.tv_nsec) {
+        return (first->time.tv_nsec < second->time.tv_nsec)? -1 : 1;
+    }
+    return 0;
+}
+
+void trimObjectCache(ObjectCache* cache) {
+    DIR* directory = opendir(cache->directory);
+    if (directory == NULL) {
+        return;
+    }
+
+    size_t directorySize = strlen(cache->directory);
+    int32_t capacity = 64;
+    int32_t count = 0;
+    ObjectCacheEntry* entries = allocate(ObjectCacheEntry, capacity);
+    uint64_t total = 0;
+    struct dirent* entry;
+    while ((entry = readdir(directory)) != NULL) {
+        size_t size = strlen(entry->d_name);
+        if ((size < 2) || (strcmp(entry->d_name + size - 2, ".o") != 0)) {
+            continue;
+        }
+
+        char* path = allocate(char, directorySize + size + 2);
+        snprintf(path, directorySize + size + 2, "%s/%s", cache->directory,
+            entry->d_name);
+        struct stat status;
+        if (stat(path, &status) != 0) {
+            deallocate(path);
+            continue;
+        }
+
+        if (count == capacity) {
+            ObjectCacheEntry* buffer = allocate(ObjectCacheEntry, capacity * 2);
+            memcpy(buffer, entries, sizeof (ObjectCacheEntry) * capacity);
+            deallocate(entries);
+            entries = buffer;
+            capacity *= 2;
+        }
+        entries[count].name = path;
+        entries[count].size = status.st_size;
+        entries[count].time = status.st_mtim;
+        total += status.st_size;
+        count++;
+    }
+    closedir(directory);
+
+    if (total > cache->limit) {
+        qsort(entries, count, sizeof (ObjectCacheEntry), compareEntries);
+    }
+
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        if ((total > cache->limit) && (remove(entries[i].name) == 0)) {
+            total -= entries[i].size;
+        }
+        deallocate(entries[i].name);
+    }
+    deallocate(entries);
+}
@@ -16,8 +16,18 @@
 
 // Monday, March 16, 2020
 
+#include <dirent.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 /* The JTK_LOGGER_DISABLE constant is defined in Configuration.h. Therefore,
  * make sure it is included before any other file which may
@@ -35,6 +45,7 @@
 #include <jtk/core/CStringObjectAdapter.h>
 #include <jtk/core/CString.h>
 
+#include <kush/build-cache.h>
 #include <kush/compiler.h>
 #include <kush/lexer.h>
 #include <kush/parser.h>
@@ -49,12 +60,65 @@ void printErrors(Compiler* compiler);
 // Phase
 
 static void initialize(Compiler* compiler);
+static void parseFile(Compiler* compiler, Lexer* lexer, TokenStream* tokens,
+    Parser* parser, int32_t index);
+static void* runLexer(void* argument);
+static void moveErrors(ErrorHandler* target, ErrorHandler* source);
+static Module* parsePipelined(Lexer* lexer, TokenStream* tokens, Parser* parser);
+static void parseTask(void* context, int32_t worker, int32_t index);
 static void buildAST(Compiler* compiler);
+static void resolveTask(void* context, int32_t worker, int32_t index);
 static void analyze(Compiler* compiler);
+static void printBoundsChecks(Compiler* compiler);
+static void generateTask(void* context, int32_t worker, int32_t index);
 static void generate(Compiler* compiler);
 static void printToken(Token* token);
 static void printTokens(Compiler* compiler, jtk_ArrayList_t* tokens);
 
+// Build Cache
+
+static bool getBuildCacheKey(Compiler* compiler, uint64_t* key);
+static uint8_t* getGeneratedPath(const uint8_t* path, const char* extension);
+static bool hasGeneratedFiles(const uint8_t* path);
+static void checkBuildCache(Compiler* compiler);
+static void updateBuildCacheEntries(Compiler* compiler);
+
+// Build
+
+typedef struct ObjectFile ObjectFile;
+typedef struct Build Build;
+
+static char* formatString(const char* format, ...);
+static const char* getRuntimeVariant(Compiler* compiler);
+static char* getCodeGenerationFlags(Compiler* compiler, const char* profileDirectory);
+static char* prepareProfileDirectory(Compiler* compiler);
+static void appendLinkerFlags(Compiler* compiler, jtk_StringBuilder_t* builder);
+static bool buildUnity(Compiler* compiler, const char* flags);
+static char** splitCommand(const char* command);
+static void deleteArguments(char** arguments);
+static bool spawnWithInput(Compiler* compiler, const char* command);
+static char* getObjectCacheDirectory(Compiler* compiler);
+static bool hashCCompiler(uint64_t* hash);
+static bool getObjectKey(Build* build, ObjectFile* object, uint64_t* key);
+static void writeDependencies(ObjectFile* object, const char* objectPath,
+    const char* dependencyPath);
+static void compileTask(void* context, int32_t worker, int32_t index);
+
+// Parallel Loop
+
+static void* runLoopWorker(void* argument);
+static int32_t getWorkerCount(Compiler* compiler);
+static void runParallelLoop(Compiler* compiler, int32_t workerCount,
+    void (*task)(void* context, int32_t worker, int32_t index), void* context);
+static void runParallelLoopEx(int32_t workerCount, int32_t size,
+    void (*task)(void* context, int32_t worker, int32_t index), void* context);
+static void collectErrors(ErrorHandler* handler, jtk_ArrayList_t** errors, int32_t index);
+static void mergeErrors(Compiler* compiler, jtk_ArrayList_t** errors);
+
+// Compiler
+
+static int32_t getProcessorCount();
+
 // Token
 
 void printToken(Token* token) {
@@ -221,6 +285,10 @@ const char* errorMessages[] = {
     "Empty array initializer",
     "Expected structure name",
     "Expected integer expression",
+    "Invalid number of type arguments",
+    "Invalid key type; expected string, integer, or reference type",
+    "Invalid native type; expected primitive, primitive array, or string",
+    "Escaping string value; it can only be indexed or measured",
 
     // General errors
     "Corrupted module",
@@ -266,118 +334,984 @@ void initialize(Compiler* compiler) {
     compiler->modules = allocate(Module*, size);
     compiler->packages = allocate(uint8_t* , size);
     compiler->packageSizes = allocate(int32_t, size);
+    compiler->hashes = allocate(uint64_t, size);
+    compiler->upToDate = allocate(bool, size);
+    compiler->generatedSources = allocate(char*, size);
+    compiler->generatedSizes = allocate(size_t, size);
+
+    int32_t i;
+    for (i = 0; i < size; i++) {
+        compiler->modules[i] = NULL;
+        compiler->packages[i] = NULL;
+        compiler->packageSizes[i] = 0;
+        compiler->hashes[i] = 0;
+        compiler->upToDate[i] = false;
+        compiler->generatedSources[i] = NULL;
+        compiler->generatedSizes[i] = 0;
+    }
 }
 
-void buildAST(Compiler* compiler) {
-    Lexer* lexer = lexerNew(compiler);
-    TokenStream* tokens = tokenStreamNew(compiler, lexer, TOKEN_CHANNEL_DEFAULT);
-    Parser* parser = parserNew(compiler, tokens);
+/******************************************************************************
+ * Build Cache                                                                *
+ ******************************************************************************/
+
+/* The key covers everything besides the input file that affects the generated
+ * code. The contents of the compiler executable are included, so that a
+ * rebuilt compiler does not reuse the files generated by its predecessor.
+ * Returns `false` if the executable cannot be read, in which case the
+ * generated files must not be reused.
+ */
+bool getBuildCacheKey(Compiler* compiler, uint64_t* key) {
+    uint64_t executable = 0;
+    bool identified = hashFile("/proc/self/exe", &executable);
+
+    char configuration[128];
+    int32_t size = snprintf(configuration, sizeof (configuration),
+        "kush %d.%d %016" PRIx64 " compressed=%d unity=%d", KUSH_VERSION_MAJOR,
+        KUSH_VERSION_MINOR, executable, compiler->compressedReferences,
+        compiler->unity);
+    *key = hashBytes(KUSH_HASH_SEED, configuration, size);
+    return identified;
+}
+
+/* Returns the path of a file generated for the input file, with the
+ * specified extension in place of "kush".
+ */
+uint8_t* getGeneratedPath(const uint8_t* path, const char* extension) {
+    int32_t size = jtk_CString_getSize(path) - 4;
+    int32_t extensionSize = strlen(extension);
+    uint8_t* result = allocate(uint8_t, size + extensionSize + 1);
+    memcpy(result, path, size);
+    memcpy(result + size, extension, extensionSize + 1);
+    return result;
+}
+
+bool hasGeneratedFiles(const uint8_t* path) {
+    uint8_t* sourceName = getGeneratedPath(path, "c");
+    uint8_t* headerName = getGeneratedPath(path, "h");
+    bool result = (access((const char*)sourceName, F_OK) == 0) &&
+        (access((const char*)headerName, F_OK) == 0);
+    deallocate(sourceName);
+    deallocate(headerName);
+    return result;
+}
+
+/* Hashes the input files and determines which of them were compiled before
+ * with the same contents. The modules that are up to date skip all the
+ * phases up to the C compiler.
+ */
+void checkBuildCache(Compiler* compiler) {
+    uint64_t key;
+    bool identified = getBuildCacheKey(compiler, &key);
+    /* The diagnostic flags need every module to be processed. */
+    bool reuse = identified && !compiler->dumpTokens && !compiler->dumpNodes &&
+        !compiler->reportBoundsChecks;
+    compiler->buildCache = newBuildCache(KUSH_BUILD_CACHE_FILE, key);
 
     int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
     int32_t i;
     for (i = 0; i < size; i++) {
-        compiler->currentFileIndex = i;
+        const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, i);
+        if (hashFile((const char*)path, &compiler->hashes[i])) {
+            compiler->upToDate[i] = reuse &&
+                isUpToDate(compiler->buildCache, path, compiler->hashes[i]) &&
+                hasGeneratedFiles(path);
+        }
+    }
+}
 
+/* Records the input files after their code is generated successfully. */
+void updateBuildCacheEntries(Compiler* compiler) {
+    int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+    int32_t i;
+    for (i = 0; i < size; i++) {
         const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, i);
-        if (!jtk_PathHelper_exists(path)) {
-            fprintf(stderr, "[error] Path '%s' does not exist.\n", path);
+        updateBuildCache(compiler->buildCache, path, compiler->hashes[i]);
+    }
+
+    if (!saveBuildCache(compiler->buildCache)) {
+        fprintf(stderr, "[warning] Failed to write the build cache to '%s'.\n",
+            KUSH_BUILD_CACHE_FILE);
+    }
+}
+
+/******************************************************************************
+ * Parallel Loop                                                              *
+ ******************************************************************************/
+
+/* A parallel loop invokes a task for each input file on a pool of workers.
+ * The files are claimed one at a time from a shared counter, so that a large
+ * file does not hold up the rest. The calling thread acts as the first worker.
+ * Each worker is identified by a number below the worker count, which the
+ * tasks use to select their own lexer, analyzer, or generator.
+ */
+typedef void (*Task)(void* context, int32_t worker, int32_t index);
+
+struct ParallelLoop {
+    int32_t size;
+    int32_t next;
+    Task task;
+    void* context;
+};
+
+typedef struct ParallelLoop ParallelLoop;
+
+struct LoopWorker {
+    ParallelLoop* loop;
+    int32_t number;
+    pthread_t thread;
+};
+
+typedef struct LoopWorker LoopWorker;
+
+void* runLoopWorker(void* argument) {
+    LoopWorker* worker = (LoopWorker*)argument;
+    ParallelLoop* loop = worker->loop;
+    while (true) {
+        int32_t index = __atomic_fetch_add(&loop->next, 1, __ATOMIC_RELAXED);
+        if (index >= loop->size) {
+            break;
         }
-        else {
-            int32_t packageSize;
-            uint8_t* package = jtk_PathHelper_getParent(path, -1, &packageSize);
-            compiler->packages[i] = package;
-            compiler->packageSizes[i] = packageSize;
-            jtk_Arrays_replace_b((int8_t*)package, packageSize, '/', '.');
+        loop->task(loop->context, worker->number, index);
+    }
+    return NULL;
+}
 
-            jtk_InputStream_t* stream = jtk_PathHelper_read(path);
-            resetLexer(lexer, stream);
+int32_t getWorkerCount(Compiler* compiler) {
+    int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+    return (compiler->threads < size)? compiler->threads : size;
+}
 
-            int32_t previousLexicalErrors = compiler->errorHandler->errors->m_size;
-            resetTokenStream(tokens);
-            fillTokenStream(tokens);
+void runParallelLoop(Compiler* compiler, int32_t workerCount, Task task,
+    void* context) {
+    runParallelLoopEx(workerCount, jtk_ArrayList_getSize(compiler->inputFiles),
+        task, context);
+}
+
+void runParallelLoopEx(int32_t workerCount, int32_t size, Task task,
+    void* context) {
+    ParallelLoop loop;
+    loop.size = size;
+    loop.next = 0;
+    loop.task = task;
+    loop.context = context;
+
+    LoopWorker* workers = allocate(LoopWorker, workerCount);
+    int32_t started;
+    for (started = 0; started < workerCount; started++) {
+        workers[started].loop = &loop;
+        workers[started].number = started;
+        if ((started > 0) && (pthread_create(&workers[started].thread, NULL,
+            runLoopWorker, &workers[started]) != 0)) {
+            /* The remaining files are claimed by the workers that are
+             * running.
+             */
+            break;
+        }
+    }
+    runLoopWorker(&workers[0]);
+
+    int32_t i;
+    for (i = 1; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+    }
+    deallocate(workers);
+}
 
-            int32_t currentLexicalErrors = compiler->errorHandler->errors->m_size;
+/* Each worker reports errors to its own handler. The errors of each file are
+ * handed over once the task finishes, and merged in the order of the input
+ * files after the loop. Therefore, the diagnostics do not depend on the
+ * number of workers.
+ */
+void collectErrors(ErrorHandler* handler, jtk_ArrayList_t** errors, int32_t index) {
+    errors[index] = handler->errors;
+    handler->errors = jtk_ArrayList_new();
+}
 
-            if (compiler->dumpTokens) {
-                printTokens(compiler, tokens->tokens);
+void mergeErrors(Compiler* compiler, jtk_ArrayList_t** errors) {
+    int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+    int32_t i;
+    for (i = 0; i < size; i++) {
+        if (errors[i] != NULL) {
+            int32_t count = jtk_ArrayList_getSize(errors[i]);
+            int32_t j;
+            for (j = 0; j < count; j++) {
+                jtk_ArrayList_add(compiler->errorHandler->errors,
+                    jtk_ArrayList_getValue(errors[i], j));
             }
-            else {
-                /* Perform syntax analysis for the current input source file only if
-                 * there are no lexical errors.
-                 */
-                if (previousLexicalErrors == currentLexicalErrors) {
-                    resetParser(parser, tokens);
-                    Module* module = parse(parser);
-                    compiler->modules[i] = module;
+            jtk_ArrayList_delete(errors[i]);
+        }
+    }
+}
 
-                    if (compiler->dumpNodes) {
-                        // TODO
-                    }
+/******************************************************************************
+ * Phase                                                                      *
+ ******************************************************************************/
+
+void parseFile(Compiler* compiler, Lexer* lexer, TokenStream* tokens,
+    Parser* parser, int32_t index) {
+    const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, index);
+    if (!jtk_PathHelper_exists(path)) {
+        fprintf(stderr, "[error] Path '%s' does not exist.\n", path);
+    }
+    else {
+        int32_t packageSize;
+        uint8_t* package = jtk_PathHelper_getParent(path, -1, &packageSize);
+        compiler->packages[index] = package;
+        compiler->packageSizes[index] = packageSize;
+        jtk_Arrays_replace_b((int8_t*)package, packageSize, '/', '.');
+
+        jtk_InputStream_t* stream = jtk_PathHelper_read(path);
+        lexer->file = (const char*)path;
+        resetLexer(lexer, stream);
+
+        if (compiler->pipeline && !compiler->dumpTokens) {
+            compiler->modules[index] = parsePipelined(lexer, tokens, parser);
+            jtk_InputStream_destroy(stream);
+            return;
+        }
+
+        int32_t previousLexicalErrors = lexer->errorHandler->errors->m_size;
+        resetTokenStream(tokens);
+        fillTokenStream(tokens);
+
+        int32_t currentLexicalErrors = lexer->errorHandler->errors->m_size;
+
+        if (compiler->dumpTokens) {
+            printTokens(compiler, tokens->tokens);
+        }
+        else {
+            /* Perform syntax analysis for the current input source file only if
+             * there are no lexical errors.
+             */
+            if (previousLexicalErrors == currentLexicalErrors) {
+                resetParser(parser, tokens);
+                Module* module = parse(parser);
+                compiler->modules[index] = module;
+
+                if (compiler->dumpNodes) {
+                    // TODO
                 }
             }
+        }
 
-            jtk_InputStream_destroy(stream);
+        jtk_InputStream_destroy(stream);
+    }
+}
+
+/* In the pipelined mode, the lexer runs on its own thread and hands the
+ * tokens over to the parser through a bounded ring, so that the parser
+ * starts before the whole file is lexed. The tokens are still retained until
+ * the compiler is destroyed, because the AST refers to them.
+ */
+struct LexerTask {
+    Lexer* lexer;
+    TokenRing* ring;
+};
+
+typedef struct LexerTask LexerTask;
+
+void* runLexer(void* argument) {
+    LexerTask* task = (LexerTask*)argument;
+    Token* token;
+    do {
+        token = nextToken(task->lexer);
+        pushToken(task->ring, token);
+    }
+    while (token->type != TOKEN_END_OF_STREAM);
+    return NULL;
+}
+
+/* Moves the errors of the source handler to the end of the target handler. */
+void moveErrors(ErrorHandler* target, ErrorHandler* source) {
+    int32_t count = jtk_ArrayList_getSize(source->errors);
+    int32_t i;
+    for (i = 0; i < count; i++) {
+        jtk_ArrayList_add(target->errors, jtk_ArrayList_getValue(source->errors, i));
+    }
+    jtk_ArrayList_clear(source->errors);
+}
+
+Module* parsePipelined(Lexer* lexer, TokenStream* tokens, Parser* parser) {
+    /* The lexer and the parser report errors concurrently. Therefore, they
+     * are collected separately, and merged the same way as in the sequential
+     * mode.
+     */
+    ErrorHandler* errorHandler = parser->errorHandler;
+    ErrorHandler* lexicalErrors = newErrorHandler();
+    ErrorHandler* syntaxErrors = newErrorHandler();
+    lexer->errorHandler = lexicalErrors;
+    parser->errorHandler = syntaxErrors;
+
+    LexerTask task;
+    task.lexer = lexer;
+    task.ring = newTokenRing(KUSH_TOKEN_RING_CAPACITY);
+
+    resetTokenStream(tokens);
+    pthread_t thread;
+    bool pipelined = (pthread_create(&thread, NULL, runLexer, &task) == 0);
+    if (pipelined) {
+        tokens->ring = task.ring;
+    }
+    else {
+        fillTokenStream(tokens);
+    }
+
+    resetParser(parser, tokens);
+    Module* module = parse(parser);
+
+    if (pipelined) {
+        /* The parser may stop before the end of the stream. The remaining
+         * tokens are drained to release the lexer.
+         */
+        while (!tokens->hitEndOfStream) {
+            fetchTokens(tokens, 1);
         }
+        pthread_join(thread, NULL);
+        tokens->ring = NULL;
     }
+    deleteTokenRing(task.ring);
 
-    compiler->trash = tokens->trash;
+    /* The syntax errors are ignored when the file has lexical errors. */
+    if (jtk_ArrayList_isEmpty(lexicalErrors->errors)) {
+        moveErrors(errorHandler, syntaxErrors);
+    }
+    else {
+        moveErrors(errorHandler, lexicalErrors);
+        module = NULL;
+    }
+
+    lexer->errorHandler = errorHandler;
+    parser->errorHandler = errorHandler;
+    deleteErrorHandler(lexicalErrors);
+    deleteErrorHandler(syntaxErrors);
+
+    return module;
+}
 
-    parserDelete(parser);
-    tokenStreamDelete(tokens);
-    lexerDelete(lexer);
+/* The input files are lexed and parsed by a pool of workers. Each worker
+ * owns a lexer, a token stream, a parser, and an error handler.
+ */
+struct Frontend {
+    Compiler* compiler;
+    ErrorHandler** errorHandlers;
+    Lexer** lexers;
+    TokenStream** tokenStreams;
+    Parser** parsers;
+    jtk_ArrayList_t** errors;
+};
+
+typedef struct Frontend Frontend;
+
+void parseTask(void* context, int32_t worker, int32_t index) {
+    Frontend* frontend = (Frontend*)context;
+    if (frontend->compiler->upToDate[index]) {
+        return;
+    }
+    parseFile(frontend->compiler, frontend->lexers[worker],
+        frontend->tokenStreams[worker], frontend->parsers[worker], index);
+    collectErrors(frontend->errorHandlers[worker], frontend->errors, index);
+}
+
+void buildAST(Compiler* compiler) {
+    int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+    /* The tokens are printed as they are recognized. A single worker keeps
+     * them in order.
+     */
+    int32_t workerCount = compiler->dumpTokens? 1 : getWorkerCount(compiler);
+
+    Frontend frontend;
+    frontend.compiler = compiler;
+    frontend.errorHandlers = allocate(ErrorHandler*, workerCount);
+    frontend.lexers = allocate(Lexer*, workerCount);
+    frontend.tokenStreams = allocate(TokenStream*, workerCount);
+    frontend.parsers = allocate(Parser*, workerCount);
+    frontend.errors = allocate(jtk_ArrayList_t*, size);
+
+    int32_t i;
+    for (i = 0; i < workerCount; i++) {
+        ErrorHandler* errorHandler = newErrorHandler();
+        Lexer* lexer = lexerNew(compiler);
+        lexer->errorHandler = errorHandler;
+        TokenStream* tokens = tokenStreamNew(compiler, lexer, TOKEN_CHANNEL_DEFAULT);
+        Parser* parser = parserNew(compiler, tokens);
+        parser->errorHandler = errorHandler;
+
+        frontend.errorHandlers[i] = errorHandler;
+        frontend.lexers[i] = lexer;
+        frontend.tokenStreams[i] = tokens;
+        frontend.parsers[i] = parser;
+    }
+    for (i = 0; i < size; i++) {
+        frontend.errors[i] = NULL;
+    }
+
+    runParallelLoop(compiler, workerCount, parseTask, &frontend);
+    mergeErrors(compiler, frontend.errors);
+
+    /* The tokens are referenced by the AST. Therefore, they are destroyed
+     * along with the compiler.
+     */
+    compiler->trash = frontend.tokenStreams[0]->trash;
+    for (i = 0; i < workerCount; i++) {
+        jtk_ArrayList_t* trash = frontend.tokenStreams[i]->trash;
+        if (i > 0) {
+            int32_t count = jtk_ArrayList_getSize(trash);
+            int32_t j;
+            for (j = 0; j < count; j++) {
+                jtk_ArrayList_add(compiler->trash, jtk_ArrayList_getValue(trash, j));
+            }
+            jtk_ArrayList_delete(trash);
+        }
+
+        parserDelete(frontend.parsers[i]);
+        tokenStreamDelete(frontend.tokenStreams[i]);
+        lexerDelete(frontend.lexers[i]);
+        deleteErrorHandler(frontend.errorHandlers[i]);
+    }
+
+    deallocate(frontend.errorHandlers);
+    deallocate(frontend.lexers);
+    deallocate(frontend.tokenStreams);
+    deallocate(frontend.parsers);
+    deallocate(frontend.errors);
 
     printErrors(compiler);
 }
 
+/* The symbols of all the modules are defined first, on the calling thread.
+ * Once they are defined, the modules are resolved independently of each
+ * other. Each worker owns an analyzer, so the cursor of the analyzer, such as
+ * the current scope and function, is private to the module being resolved.
+ */
+struct Backend {
+    Compiler* compiler;
+    Analyzer** analyzers;
+    Generator** generators;
+    jtk_ArrayList_t** errors;
+};
+
+typedef struct Backend Backend;
+
+void resolveTask(void* context, int32_t worker, int32_t index) {
+    Backend* backend = (Backend*)context;
+    if (backend->compiler->upToDate[index]) {
+        return;
+    }
+    Analyzer* analyzer = backend->analyzers[worker];
+    resetAnalyzer(analyzer);
+    resolveSymbols(analyzer, backend->compiler->modules[index]);
+    collectErrors(analyzer->errorHandler, backend->errors, index);
+}
+
 void analyze(Compiler* compiler) {
-    Analyzer* analyzer = newAnalyzer();
+    Analyzer* analyzer = newAnalyzer(compiler);
 
     int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
     int32_t i;
     for (i = 0; i < size; i++) {
-        compiler->currentFileIndex = i;
-        Module* module = compiler->modules[i];
-        defineSymbols(analyzer, module);
+        if (!compiler->upToDate[i]) {
+            Module* module = compiler->modules[i];
+            defineSymbols(analyzer, module);
+        }
     }
 
     if (jtk_ArrayList_isEmpty(compiler->errorHandler->errors)) {
+        int32_t workerCount = getWorkerCount(compiler);
+
+        Backend backend;
+        backend.compiler = compiler;
+        backend.analyzers = allocate(Analyzer*, workerCount);
+        backend.generators = NULL;
+        backend.errors = allocate(jtk_ArrayList_t*, size);
+        for (i = 0; i < workerCount; i++) {
+            backend.analyzers[i] = newAnalyzer(compiler);
+            backend.analyzers[i]->errorHandler = newErrorHandler();
+        }
         for (i = 0; i < size; i++) {
-            compiler->currentFileIndex = i;
-            Module* module = compiler->modules[i];
-            resolveSymbols(analyzer, module);
+            backend.errors[i] = NULL;
         }
+
+        runParallelLoop(compiler, workerCount, resolveTask, &backend);
+        mergeErrors(compiler, backend.errors);
+
+        for (i = 0; i < workerCount; i++) {
+            deleteErrorHandler(backend.analyzers[i]->errorHandler);
+            deleteAnalyzer(backend.analyzers[i]);
+        }
+        deallocate(backend.analyzers);
+        deallocate(backend.errors);
     }
 
     printErrors(compiler);
     deleteAnalyzer(analyzer);
+
+    if (compiler->reportBoundsChecks) {
+        printBoundsChecks(compiler);
+    }
 }
 
-void generate(Compiler* compiler) {
-    Generator* generator = newGenerator(compiler);
+void printBoundsChecks(Compiler* compiler) {
     int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
     int32_t i;
     for (i = 0; i < size; i++) {
-        compiler->currentFileIndex = i;
         Module* module = compiler->modules[i];
-        generateC(generator, module);
+        int32_t count = jtk_ArrayList_getSize(module->functions);
+        int32_t j;
+        for (j = 0; j < count; j++) {
+            Function* function = (Function*)jtk_ArrayList_getValue(module->functions, j);
+            printf("[bounds] %s: eliminated %d of %d checks\n", function->name,
+                function->eliminatedChecks, function->boundsChecks);
+        }
     }
-    deleteGenerator(generator);
 }
 
-void buildExecutable(Compiler* compiler) {
-    jtk_StringBuilder_t* builder = jtk_StringBuilder_new();
-    jtk_StringBuilder_appendEx_z(builder, "gcc ", 4);
+/* The generator does not modify the AST. Each worker owns a generator, which
+ * writes the files of one module at a time.
+ */
+void generateTask(void* context, int32_t worker, int32_t index) {
+    Backend* backend = (Backend*)context;
+    Compiler* compiler = backend->compiler;
+    if (compiler->upToDate[index]) {
+        return;
+    }
+    if (compiler->inMemory) {
+        generateInMemory(backend->generators[worker], compiler->modules[index],
+            &compiler->generatedSources[index], &compiler->generatedSizes[index]);
+    }
+    else {
+        const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, index);
+        generateC(backend->generators[worker], compiler->modules[index], path);
+    }
+}
 
-    int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+void generate(Compiler* compiler) {
+    int32_t workerCount = getWorkerCount(compiler);
+
+    Backend backend;
+    backend.compiler = compiler;
+    backend.analyzers = NULL;
+    backend.generators = allocate(Generator*, workerCount);
+    backend.errors = NULL;
     int32_t i;
-    for (i = 0; i < size; i++) {
-        const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, i);
-        int32_t size = jtk_CString_getSize(path) - 4;
-        jtk_StringBuilder_appendCodePoint(builder, (int32_t)'"');
-        jtk_StringBuilder_appendEx_z(builder, path, size);
-        jtk_StringBuilder_appendEx_z(builder, "c\" ", 3);
+    for (i = 0; i < workerCount; i++) {
+        backend.generators[i] = newGenerator(compiler);
+    }
+
+    runParallelLoop(compiler, workerCount, generateTask, &backend);
+
+    for (i = 0; i < workerCount; i++) {
+        deleteGenerator(backend.generators[i]);
     }
+    deallocate(backend.generators);
+}
 
+/******************************************************************************
+ * Build                                                                      *
+ ******************************************************************************/
+
+/* The generated files include the runtime header from this directory. */
+#define KUSH_RUNTIME_DIRECTORY "../runtime"
+
+/* The runtime is compiled and archived in this directory, relative to the
+ * working directory, so that the sources of the runtime are never mixed with
+ * the artifacts.
+ */
+#define KUSH_BUILD_DIRECTORY ".kush-build"
+
+/* The default directory of the profile collected by an instrumented
+ * executable.
+ */
+#define KUSH_PROFILE_DIRECTORY "kush-profile"
+
+char* formatString(const char* format, ...) {
+    va_list arguments;
+    va_start(arguments, format);
+    int32_t size = vsnprintf(NULL, 0, format, arguments);
+    va_end(arguments);
+
+    char* result = allocate(char, size + 1);
+    va_start(arguments, format);
+    vsnprintf(result, size + 1, format, arguments);
+    va_end(arguments);
+
+    return result;
+}
+
+/* Returns the name of the runtime variant that matches the flags. The debug
+ * and release variants are stored as separate libraries, so that switching
+ * between them does not rebuild the runtime.
+ */
+const char* getRuntimeVariant(Compiler* compiler) {
+    bool release = (compiler->optimization != OPTIMIZE_NONE);
+    if (compiler->compressedReferences) {
+        return release? "release-compressed" : "debug-compressed";
+    }
+    return release? "release" : "debug";
+}
+
+/* Returns the flags that are passed to the C compiler both when compiling and
+ * when linking. With link time optimization, the code is generated by the
+ * linker, which needs the same optimization and target flags.
+ */
+char* getCodeGenerationFlags(Compiler* compiler, const char* profileDirectory) {
+    static const char* levels[] = {
+        "-O0",
+        "-O1",
+        "-O2",
+        "-O3",
+        "-Os"
+    };
+    char* target = (compiler->targetCpu != NULL)?
+        formatString(" -march=%s", compiler->targetCpu) : formatString("");
+    char* profile = formatString("");
+    if (profileDirectory != NULL) {
+        deallocate(profile);
+        profile = formatString(" -fprofile-%s=\"%s\"",
+            compiler->profileGenerate? "generate" : "use", profileDirectory);
+    }
+    char* result = formatString("%s%s%s%s%s", levels[compiler->optimization],
+        target, compiler->linkTimeOptimization? " -flto" : "",
+        (compiler->debugInfo && !compiler->strip)? " -g" : "", profile);
+    deallocate(target);
+    deallocate(profile);
+    return result;
+}
+
+/* Each C file is compiled to an object file next to it. The command that
+ * compiles the object is stored in a ".cmd" file, and the C compiler lists
+ * the headers that the object depends on in a ".d" file. An object is
+ * compiled again only when it is older than any of these.
+ */
+struct ObjectFile {
+    char* source;
+    /* The path of the object without the "o" extension, which is shared by
+     * the command and dependency files.
+     */
+    char* base;
+    char* header;
+    /* The files that the object is compiled from, which are hashed into its
+     * key in the object cache.
+     */
+    const char* inputs[3];
+    int32_t inputCount;
+    bool compiled;
+};
+
+/* Returns the directory of the object cache. Unless it is specified with the
+ * `--object-cache` flag, it is taken from the `KUSH_CACHE_DIR` variable, or
+ * placed in the cache directory of the user. Returns `NULL` if none of them
+ * are available.
+ */
+char* getObjectCacheDirectory(Compiler* compiler) {
+    if (compiler->objectCacheDirectory != NULL) {
+        return formatString("%s", compiler->objectCacheDirectory);
+    }
+
+    const char* directory = getenv("KUSH_CACHE_DIR");
+    if ((directory != NULL) && (directory[0] != '\0')) {
+        return formatString("%s", directory);
+    }
+    directory = getenv("XDG_CACHE_HOME");
+    if ((directory != NULL) && (directory[0] != '\0')) {
+        return formatString("%s/kush/objects", directory);
+    }
+    directory = getenv("HOME");
+    if ((directory != NULL) && (directory[0] != '\0')) {
+        return formatString("%s/.cache/kush/objects", directory);
+    }
+    return NULL;
+}
+
+/* The version of the C compiler is hashed once per build, and only when the
+ * object cache is used. Returns `false` if the C compiler cannot be run.
+ */
+bool hashCCompiler(uint64_t* hash) {
+    FILE* pipe = popen("gcc --version 2>/dev/null", "r");
+    if (pipe == NULL) {
+        return false;
+    }
+
+    uint64_t result = KUSH_HASH_SEED;
+    uint8_t buffer[1024];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof (buffer), pipe)) > 0) {
+        result = hashBytes(result, buffer, size);
+    }
+    bool success = !ferror(pipe);
+    success = (pclose(pipe) == 0) && success;
+
+    *hash = result;
+    return success;
+}
+
+struct Build {
+    Compiler* compiler;
+    const char* flags;
+    ObjectFile* objects;
+    ObjectCache* objectCache;
+    uint64_t compilerHash;
+    /* Written by the workers, and read once they have been joined. */
+    bool failed;
+};
+
+/* The key of an object covers the version and the flags of the C compiler,
+ * and the contents of the inputs. The paths are left out, so that the key
+ * does not change when a project is moved or checked out elsewhere. Returns
+ * `false` if an input cannot be read.
+ */
+bool getObjectKey(Build* build, ObjectFile* object, uint64_t* key) {
+    bool result = true;
+    uint64_t hash = hashBytes(KUSH_HASH_SEED, &build->compilerHash,
+        sizeof (build->compilerHash));
+    hash = hashBytes(hash, build->flags, strlen(build->flags));
+    int32_t i;
+    for (i = 0; (i < object->inputCount) && result; i++) {
+        uint64_t inputHash;
+        result = hashFile(object->inputs[i], &inputHash);
+        hash = hashBytes(hash, &inputHash, sizeof (inputHash));
+    }
+    *key = hash;
+    return result;
+}
+
+/* An object copied from the object cache needs a dependency file, like the
+ * ones written by the C compiler, so that the next build can check it.
+ */
+void writeDependencies(ObjectFile* object, const char* objectPath,
+    const char* dependencyPath) {
+    FILE* file = fopen(dependencyPath, "w");
+    if (file != NULL) {
+        fprintf(file, "%s:", objectPath);
+        int32_t i;
+        for (i = 0; i < object->inputCount; i++) {
+            fputc(' ', file);
+            const char* current;
+            for (current = object->inputs[i]; *current != '\0'; current++) {
+                if (*current == ' ') {
+                    fputc('\\', file);
+                }
+                fputc(*current, file);
+            }
+        }
+        fputc('\n', file);
+        fclose(file);
+    }
+}
+
+void compileTask(void* context, int32_t worker, int32_t index) {
+    Build* build = (Build*)context;
+    ObjectFile* object = &build->objects[index];
+    char* objectPath = formatString("%so", object->base);
+    char* commandPath = formatString("%scmd", object->base);
+    char* dependencyPath = formatString("%sd", object->base);
+    char* command = formatString("gcc -c %s -I%s -MMD -MF \"%s\" \"%s\" -o \"%s\"",
+        build->flags, KUSH_RUNTIME_DIRECTORY, dependencyPath, object->source, objectPath);
+
+    /* The command file keeps its modification time when the command does not
+     * change.
+     */
+    writeIfChanged(commandPath, (const uint8_t*)command, strlen(command));
+    /* The dependency files do not list the profile, which may have been
+     * collected again since the last build.
+     */
+    if (build->compiler->profileUse ||
+        isOutdated(objectPath, commandPath, dependencyPath)) {
+        uint64_t key;
+        bool cacheable = (build->objectCache != NULL) &&
+            getObjectKey(build, object, &key);
+        if (cacheable && fetchObject(build->objectCache, key, objectPath)) {
+            printf("\033[1;33m[cache]\033[1;37m %s\n\033[0m", objectPath);
+            writeDependencies(object, objectPath, dependencyPath);
+        }
+        else {
+            printf("\033[1;33m[spawn]\033[1;37m %s\n\033[0m", command);
+            if (system(command) != 0) {
+                /* Delete the command file, so that the next build retries the
+                 * object.
+                 */
+                remove(commandPath);
+                __atomic_store_n(&build->failed, true, __ATOMIC_RELAXED);
+            }
+            else if (cacheable) {
+                storeObject(build->objectCache, key, objectPath);
+            }
+        }
+        object->compiled = true;
+    }
+
+    deallocate(objectPath);
+    deallocate(commandPath);
+    deallocate(dependencyPath);
+    deallocate(command);
+}
+
+/* Returns the absolute path of the profile directory, because the
+ * instrumented executable writes its profile relative to its own working
+ * directory. An instrumented build starts with an empty profile, so that
+ * the counters of a previous executable are not merged with the new ones.
+ *
+ * The profile of each object is named after the path of the object. The
+ * objects are always placed next to the generated files, which are named
+ * after the input files, so the names match across builds.
+ */
+char* prepareProfileDirectory(Compiler* compiler) {
+    const char* directory = compiler->profileDirectory;
+    if (compiler->profileGenerate) {
+        if (!makeDirectories(directory)) {
+            fprintf(stderr, "[error] Failed to create the profile directory '%s'.\n",
+                directory);
+            return NULL;
+        }
+
+        DIR* entries = opendir(directory);
+        if (entries != NULL) {
+            struct dirent* entry;
+            while ((entry = readdir(entries)) != NULL) {
+                size_t size = strlen(entry->d_name);
+                if ((size > 5) && (strcmp(entry->d_name + size - 5, ".gcda") == 0)) {
+                    char* path = formatString("%s/%s", directory, entry->d_name);
+                    remove(path);
+                    deallocate(path);
+                }
+            }
+            closedir(entries);
+        }
+    }
+
+    char* absolute = realpath(directory, NULL);
+    if (absolute == NULL) {
+        fprintf(stderr, "[warning] The profile directory '%s' does not exist. Run "
+            "an executable built with --profile-generate first.\n", directory);
+        return NULL;
+    }
+    char* result = formatString("%s", absolute);
+    free(absolute);
+    return result;
+}
+
+/* The environment of the compiler is passed on to the C compiler. */
+extern char** environ;
+
+/* Splits a command built by the driver into its arguments. The driver quotes
+ * the arguments that may contain spaces with double quotes, which are
+ * removed. The arguments are stored in a single buffer, which is freed along
+ * with the array.
+ */
+char** splitCommand(const char* command) {
+    size_t size = strlen(command);
+    char** arguments = allocate(char*, size / 2 + 2);
+    char* buffer = allocate(char, size + 1);
+    int32_t count = 0;
+    char* current = buffer;
+    const char* next = command;
+    while (*next != '\0') {
+        while (*next == ' ') {
+            next++;
+        }
+        if (*next == '\0') {
+            break;
+        }
+
+        arguments[count++] = current;
+        bool quoted = false;
+        while ((*next != '\0') && (quoted || (*next != ' '))) {
+            if (*next == '"') {
+                quoted = !quoted;
+            }
+            else {
+                *current++ = *next;
+            }
+            next++;
+        }
+        *current++ = '\0';
+    }
+    arguments[count] = NULL;
+    if (count == 0) {
+        deallocate(buffer);
+    }
+    return arguments;
+}
+
+void deleteArguments(char** arguments) {
+    if (arguments[0] != NULL) {
+        /* The first argument is at the start of the buffer. */
+        deallocate(arguments[0]);
+    }
+    deallocate(arguments);
+}
+
+/* Spawns the C compiler without a shell, and writes the generated code of
+ * every module to its standard input through a pipe. Returns `true` if the
+ * C compiler succeeds.
+ */
+bool spawnWithInput(Compiler* compiler, const char* command) {
+    int descriptors[2];
+    if (pipe(descriptors) != 0) {
+        fprintf(stderr, "[error] Failed to create a pipe for the C compiler.\n");
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, descriptors[0], STDIN_FILENO);
+    posix_spawn_file_actions_addclose(&actions, descriptors[0]);
+    posix_spawn_file_actions_addclose(&actions, descriptors[1]);
+
+    /* The messages of the C compiler follow the output of the driver. */
+    fflush(stdout);
+
+    char** arguments = splitCommand(command);
+    pid_t process;
+    int error = posix_spawnp(&process, arguments[0], &actions, NULL, arguments,
+        environ);
+    posix_spawn_file_actions_destroy(&actions);
+    deleteArguments(arguments);
+    close(descriptors[0]);
+
+    bool result = false;
+    if (error != 0) {
+        fprintf(stderr, "[error] Failed to spawn the C compiler: %s\n", strerror(error));
+        close(descriptors[1]);
+    }
+    else {
+        /* A C compiler that exits early closes the pipe. The failure is
+         * reported through its exit status, instead of a signal.
+         */
+        void (*handler)(int) = signal(SIGPIPE, SIG_IGN);
+        int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+        int32_t i;
+        bool written = true;
+        for (i = 0; (i < size) && written; i++) {
+            const char* contents = compiler->generatedSources[i];
+            size_t remaining = compiler->generatedSizes[i];
+            while ((remaining > 0) && written) {
+                ssize_t count = write(descriptors[1], contents, remaining);
+                if (count > 0) {
+                    contents += count;
+                    remaining -= count;
+                }
+                else {
+                    written = (count < 0) && (errno == EINTR);
+                }
+            }
+        }
+        close(descriptors[1]);
+        signal(SIGPIPE, handler);
+
+        int status;
+        while ((waitpid(process, &status, 0) < 0) && (errno == EINTR)) {
+        }
+        result = written && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+    }
+
+    return result;
+}
+
+/* Appends the output and the libraries to the command that links the
+ * executable.
+ */
+void appendLinkerFlags(Compiler* compiler, jtk_StringBuilder_t* builder) {
     uint8_t* output = "main";
     int32_t outputSize = 4;
     if (compiler->output != NULL) {
@@ -385,14 +1319,256 @@ void buildExecutable(Compiler* compiler) {
         outputSize = compiler->outputSize;
     }
 
-    jtk_StringBuilder_appendEx_z(builder, "../runtime/kush-runtime.c -I../runtime -g -o ", 45);
+    if (compiler->strip) {
+        jtk_StringBuilder_appendEx_z(builder, " -s", 3);
+    }
+    jtk_StringBuilder_appendEx_z(builder, " -o ", 4);
     jtk_StringBuilder_appendEx_z(builder, output, outputSize);
-    int32_t commandSize = -1;
-    uint8_t* command = jtk_StringBuilder_toCString(builder, &commandSize);
-    jtk_StringBuilder_delete(builder);
 
-    printf("\033[1;33m[spawn]\033[1;37m %s\n\033[0m", command);
-    system(command);
+    /* The libraries must follow the sources that refer to them. The math
+     * intrinsics of the runtime depend on the math library.
+     */
+    jtk_StringBuilder_appendEx_z(builder, " -lm", 4);
+    int32_t flagCount = jtk_ArrayList_getSize(compiler->linkerFlags);
+    int32_t i;
+    for (i = 0; i < flagCount; i++) {
+        const uint8_t* flag = (const uint8_t*)jtk_ArrayList_getValue(compiler->linkerFlags, i);
+        jtk_StringBuilder_appendEx_z(builder, " \"", 2);
+        jtk_StringBuilder_appendEx_z(builder, flag, jtk_CString_getSize(flag));
+        jtk_StringBuilder_appendCodePoint(builder, (int32_t)'"');
+    }
+}
+
+/* A unity build includes the runtime and every generated file in a single
+ * translation unit, named after the executable. The files are included by
+ * their absolute paths, so that the translation unit does not depend on the
+ * working directory. It is compiled and linked by a single C compiler
+ * process. Returns `true` if the executable is linked.
+ */
+bool buildUnity(Compiler* compiler, const char* flags) {
+    const char* output = (compiler->output != NULL)? (const char*)compiler->output : "main";
+    char* unityPath = formatString("%s.unity.c", output);
+
+    char* buffer;
+    size_t bufferSize;
+    FILE* unity = open_memstream(&buffer, &bufferSize);
+    fprintf(unity, "// Do not edit this file.\n"
+        "// It was automatically generated by kush v%d.%d.\n\n"
+        "#define KUSH_UNITY\n\n"
+        "#include \"kush-runtime.c\"\n\n",
+        KUSH_VERSION_MAJOR, KUSH_VERSION_MINOR);
+
+    bool failed = false;
+    int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
+    int32_t i;
+    for (i = 0; i < size; i++) {
+        const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, i);
+        char* source = formatString("%.*sc", jtk_CString_getSize(path) - 4, path);
+        char* absolute = realpath(source, NULL);
+        if (absolute == NULL) {
+            fprintf(stderr, "[error] Failed to locate the generated file '%s'.\n", source);
+            failed = true;
+        }
+        else {
+            fprintf(unity, "#include \"%s\"\n", absolute);
+            free(absolute);
+        }
+        deallocate(source);
+    }
+    fclose(unity);
+
+    if (!failed && !writeIfChanged(unityPath, (const uint8_t*)buffer, bufferSize)) {
+        fprintf(stderr, "[error] Failed to write the unity file '%s'.\n", unityPath);
+        failed = true;
+    }
+    if (!failed) {
+        jtk_StringBuilder_t* builder = jtk_StringBuilder_new();
+        jtk_StringBuilder_appendEx_z(builder, "gcc ", 4);
+        jtk_StringBuilder_appendEx_z(builder, flags, strlen(flags));
+        jtk_StringBuilder_appendEx_z(builder, " -I", 3);
+        jtk_StringBuilder_appendEx_z(builder, KUSH_RUNTIME_DIRECTORY,
+            strlen(KUSH_RUNTIME_DIRECTORY));
+        jtk_StringBuilder_appendEx_z(builder, " \"", 2);
+        jtk_StringBuilder_appendEx_z(builder, unityPath, strlen(unityPath));
+        jtk_StringBuilder_appendCodePoint(builder, (int32_t)'"');
+        appendLinkerFlags(compiler, builder);
+
+        int32_t commandSize = -1;
+        uint8_t* command = jtk_StringBuilder_toCString(builder, &commandSize);
+        jtk_StringBuilder_delete(builder);
+
+        printf("\033[1;33m[spawn]\033[1;37m %s\n\033[0m", command);
+        failed = (system(command) != 0);
+        jtk_CString_delete(command);
+    }
+    free(buffer);
+    deallocate(unityPath);
+
+    return !failed;
+}
+
+/* The generated files and the runtime are compiled to object files in
+ * parallel, skipping the objects that are up to date. The runtime object is
+ * archived in a static library for each variant, which is linked with the
+ * objects of the modules. Returns `true` if the executable is linked.
+ */
+bool buildExecutable(Compiler* compiler) {
+    const char* variant = getRuntimeVariant(compiler);
+    char* profileDirectory = NULL;
+    if (compiler->profileGenerate || compiler->profileUse) {
+        profileDirectory = prepareProfileDirectory(compiler);
+        if ((profileDirectory == NULL) && compiler->profileGenerate) {
+            return false;
+        }
+    }
+    if (!makeDirectories(KUSH_BUILD_DIRECTORY)) {
+        fprintf(stderr, "[error] Failed to create the build directory '%s'.\n",
+            KUSH_BUILD_DIRECTORY);
+        if (profileDirectory != NULL) {
+            deallocate(profileDirectory);
+        }
+        return false;
+    }
+    char* codeGenerationFlags = getCodeGenerationFlags(compiler, profileDirectory);
+    char* flags = formatString("%s%s", codeGenerationFlags,
+        compiler->compressedReferences? " -DKUSH_COMPRESSED_REFERENCES" : "");
+
+    if (compiler->unity) {
+        bool linked = buildUnity(compiler, flags);
+        deallocate(flags);
+        deallocate(codeGenerationFlags);
+        if (profileDirectory != NULL) {
+            deallocate(profileDirectory);
+        }
+        return linked;
+    }
+
+    /* In memory, the generated code is piped to the C compiler that links the
+     * executable. Only the runtime is compiled to an object file.
+     */
+    char* runtimeHeader = formatString("%s/kush-runtime.h", KUSH_RUNTIME_DIRECTORY);
+    int32_t size = compiler->inMemory? 0 : jtk_ArrayList_getSize(compiler->inputFiles);
+    ObjectFile* objects = allocate(ObjectFile, size + 1);
+    int32_t i;
+    for (i = 0; i < size; i++) {
+        const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles, i);
+        int32_t baseSize = jtk_CString_getSize(path) - 4;
+        objects[i].source = formatString("%.*sc", baseSize, path);
+        objects[i].base = formatString("%.*s", baseSize, path);
+        objects[i].header = formatString("%.*sh", baseSize, path);
+        objects[i].inputs[0] = objects[i].source;
+        objects[i].inputs[1] = objects[i].header;
+        objects[i].inputs[2] = runtimeHeader;
+        objects[i].inputCount = 3;
+        objects[i].compiled = false;
+    }
+    ObjectFile* runtime = &objects[size];
+    runtime->source = formatString("%s/kush-runtime.c", KUSH_RUNTIME_DIRECTORY);
+    runtime->base = formatString("%s/kushrt-%s.", KUSH_BUILD_DIRECTORY, variant);
+    runtime->header = NULL;
+    runtime->inputs[0] = runtime->source;
+    runtime->inputs[1] = runtimeHeader;
+    runtime->inputCount = 2;
+    runtime->compiled = false;
+
+    Build build;
+    build.compiler = compiler;
+    build.flags = flags;
+    build.objects = objects;
+    build.objectCache = NULL;
+    build.compilerHash = 0;
+    build.failed = false;
+    /* The objects optimized with a profile depend on the profile, which is
+     * not part of the key. Without the version of the C compiler, an object
+     * built by another version could be reused.
+     */
+    if (compiler->useBuildCache && !compiler->profileUse &&
+        hashCCompiler(&build.compilerHash)) {
+        char* directory = getObjectCacheDirectory(compiler);
+        if (directory != NULL) {
+            build.objectCache = newObjectCache(directory,
+                (uint64_t)compiler->objectCacheSize << 20);
+            deallocate(directory);
+        }
+    }
+
+    int32_t workerCount = (compiler->jobs < size + 1)? compiler->jobs : size + 1;
+    runParallelLoopEx(workerCount, size + 1, compileTask, &build);
+
+    if (build.objectCache != NULL) {
+        trimObjectCache(build.objectCache);
+        deleteObjectCache(build.objectCache);
+    }
+
+    char* library = formatString("%s/libkushrt-%s.a", KUSH_BUILD_DIRECTORY, variant);
+    if (!build.failed && (runtime->compiled || (access(library, F_OK) != 0))) {
+        /* The objects compiled for link time optimization carry a symbol
+         * table that only the plugin aware archiver writes.
+         */
+        char* command = formatString("%s rcs \"%s\" \"%so\"",
+            compiler->linkTimeOptimization? "gcc-ar" : "ar", library, runtime->base);
+        printf("\033[1;33m[spawn]\033[1;37m %s\n\033[0m", command);
+        build.failed = (system(command) != 0);
+        deallocate(command);
+    }
+
+    if (!build.failed) {
+        jtk_StringBuilder_t* builder = jtk_StringBuilder_new();
+        jtk_StringBuilder_appendEx_z(builder, "gcc ", 4);
+        if (compiler->inMemory) {
+            jtk_StringBuilder_appendEx_z(builder, flags, strlen(flags));
+            jtk_StringBuilder_appendEx_z(builder, " -I", 3);
+            jtk_StringBuilder_appendEx_z(builder, KUSH_RUNTIME_DIRECTORY,
+                strlen(KUSH_RUNTIME_DIRECTORY));
+            /* The standard input is compiled as C, while the language of the
+             * remaining inputs is deduced from their extensions.
+             */
+            jtk_StringBuilder_appendEx_z(builder, " -x c - -x none", 15);
+        }
+        else {
+            jtk_StringBuilder_appendEx_z(builder, codeGenerationFlags, strlen(codeGenerationFlags));
+        }
+        for (i = 0; i < size; i++) {
+            jtk_StringBuilder_appendEx_z(builder, " \"", 2);
+            jtk_StringBuilder_appendEx_z(builder, objects[i].base, strlen(objects[i].base));
+            jtk_StringBuilder_appendEx_z(builder, "o\"", 2);
+        }
+        jtk_StringBuilder_appendEx_z(builder, " \"", 2);
+        jtk_StringBuilder_appendEx_z(builder, library, strlen(library));
+        jtk_StringBuilder_appendCodePoint(builder, (int32_t)'"');
+        appendLinkerFlags(compiler, builder);
+
+        int32_t commandSize = -1;
+        uint8_t* command = jtk_StringBuilder_toCString(builder, &commandSize);
+        jtk_StringBuilder_delete(builder);
+
+        printf("\033[1;33m[spawn]\033[1;37m %s\n\033[0m", command);
+        if (compiler->inMemory) {
+            build.failed = !spawnWithInput(compiler, (const char*)command);
+        }
+        else {
+            build.failed = (system(command) != 0);
+        }
+        jtk_CString_delete(command);
+    }
+
+    for (i = 0; i <= size; i++) {
+        deallocate(objects[i].source);
+        deallocate(objects[i].base);
+        if (objects[i].header != NULL) {
+            deallocate(objects[i].header);
+        }
+    }
+    deallocate(objects);
+    deallocate(runtimeHeader);
+    deallocate(library);
+    deallocate(flags);
+    deallocate(codeGenerationFlags);
+    if (profileDirectory != NULL) {
+        deallocate(profileDirectory);
+    }
+
+    return !build.failed;
 }
 
 jtk_ArrayList_t* k_CString_split_c(const uint8_t* sequence, int32_t size,
@@ -415,18 +1591,43 @@ jtk_ArrayList_t* k_CString_split_c(const uint8_t* sequence, int32_t size,
 void printHelp() {
     printf(
         "[Usage]\n"
-        "    kush [--tokens] [--nodes] [--footprint] [--instructions] [--core-api] [--log <level>] [--help] [--output|-o <path>] <inputFiles> [--run <arguments>]\n\n"
+        "    kush [--tokens] [--nodes] [--footprint] [--instructions] [--bounds-report] [--compressed-references] [--core-api] [--log <level>] [--help] [--output|-o <path>] [-l<library>] [-L<directory>] [--linker-flag <flag>] [--threads <count>] [--pipeline] [--no-cache] [--object-cache <directory>] [--object-cache-size <megabytes>] [--jobs|-j <count>] [--opt=<level>] [--march=<cpu>] [--lto] [--debug] [--strip] [--release] [--profile-generate[=<directory>]] [--profile-use[=<directory>]] [--unity] [--in-memory] <inputFiles> [--run <arguments>]\n\n"
         "[Options]\n"
         "    --tokens            Print the tokens recognized by the lexer.\n"
         "    --nodes             Print the AST recognized by the parser.\n"
         "    --footprint         Print diagnostic information about the memory footprint of the compiler.\n"
         "    --instructions      Disassemble the binary entity generated.\n"
+        "    --bounds-report     Print the number of array bounds checks eliminated in each function.\n"
+        "    --compressed-references\n"
+        "                        Store the references inside objects as 32-bit offsets into a heap of up to 32 GiB.\n"
         "    --core-api          Disables the internal constant pool function index cache. This flag is valid only when compiling foreign function interfaces.\n"
         "    --run               Run the virtual machine after compiling the source files.\n"
         "    --log               Generate log messages. This flag is valid only if log messages were enabled at compile time.\n"
         "    --help              Print the help message.\n"
         "    --version           Print the current version of the compiler.\n"
         "    -o, --output path   Generate the executable to the specified file.\n"
+        "    -l<library>         Link the executable with the specified library, which implements native functions.\n"
+        "    -L<directory>       Search the specified directory for libraries.\n"
+        "    --linker-flag flag  Forward the specified flag to the linker.\n"
+        "    --threads count     Compile the input files with the specified number of threads. By default, one thread is used for each processor.\n"
+        "    --pipeline          Lex each input file on a separate thread, while it is being parsed.\n"
+        "    --no-cache          Compile every input file and object, ignoring the build cache in '.kush-cache' and the object cache.\n"
+        "    --object-cache dir  Store the compiled objects in the specified directory. By default, $KUSH_CACHE_DIR or ~/.cache/kush/objects is used.\n"
+        "    --object-cache-size megabytes\n"
+        "                        Evict the least recently used objects beyond the specified size. The default is 256 megabytes.\n"
+        "    --jobs|-j count     Run the specified number of C compiler jobs at once. By default, one job is run for each processor.\n"
+        "    --opt=level         Optimize the generated code and the runtime at the specified level: 0, 1, 2, 3, or size. The default is 0.\n"
+        "    --march=cpu         Generate instructions for the specified CPU, such as native.\n"
+        "    --lto               Optimize across the modules and the runtime at link time.\n"
+        "    --debug             Include debugging information in the executable. This is the default.\n"
+        "    --strip             Remove the symbols and debugging information from the executable.\n"
+        "    --release           Equivalent to --opt=2 without debugging information.\n"
+        "    --profile-generate[=directory]\n"
+        "                        Build an executable that writes a profile to the specified directory when it runs. The default is 'kush-profile'.\n"
+        "    --profile-use[=directory]\n"
+        "                        Optimize the executable with the profile in the specified directory. The default is 'kush-profile'.\n"
+        "    --unity             Compile the whole program and the runtime as a single translation unit, where the functions are inlined across the modules.\n"
+        "    --in-memory         Pipe the generated code to the C compiler, without writing any file next to the input files. It cannot be combined with --unity.\n"
         );
 }
 
@@ -443,6 +1644,7 @@ bool compileEx(Compiler* compiler, char** arguments, int32_t length) {
     int32_t i;
     bool showVersion = false;
     bool showHelp = false;
+    bool result = true;
     for (i = 1; i < length; i++) {
         if (arguments[i][0] == '-') {
             if (strcmp(arguments[i], "--tokens") == 0) {
@@ -457,6 +1659,12 @@ bool compileEx(Compiler* compiler, char** arguments, int32_t length) {
             else if (strcmp(arguments[i], "--instructions") == 0) {
                 compiler->dumpInstructions = true;
             }
+            else if (strcmp(arguments[i], "--bounds-report") == 0) {
+                compiler->reportBoundsChecks = true;
+            }
+            else if (strcmp(arguments[i], "--compressed-references") == 0) {
+                compiler->compressedReferences = true;
+            }
             else if (strcmp(arguments[i], "--core-api") == 0) {
                 compiler->coreApi = true;
             }
@@ -485,6 +1693,147 @@ bool compileEx(Compiler* compiler, char** arguments, int32_t length) {
                     compiler->outputSize = strlen(arguments[i]);
                 }
             }
+            else if ((arguments[i][1] == 'l') || (arguments[i][1] == 'L')) {
+                // Didn't make a copy of the flag. DO NOT DELETE IT.
+                jtk_ArrayList_add(compiler->linkerFlags, arguments[i]);
+            }
+            else if (strcmp(arguments[i], "--linker-flag") == 0) {
+                if ((i + 1) < length) {
+                    i++;
+                    jtk_ArrayList_add(compiler->linkerFlags, arguments[i]);
+                }
+                else {
+                    printf("[error] The `--linker-flag` flag expects an argument.\n");
+                    invalidCommandLine = true;
+                }
+            }
+            else if ((strcmp(arguments[i], "--jobs") == 0) || (strcmp(arguments[i], "-j") == 0)) {
+                if ((i + 1) < length) {
+                    i++;
+                    compiler->jobs = atoi(arguments[i]);
+                    if (compiler->jobs <= 0) {
+                        printf("[error] The `--jobs` flag expects a positive integer.\n");
+                        invalidCommandLine = true;
+                    }
+                }
+                else {
+                    printf("[error] The `--jobs` flag expects an argument.\n");
+                    invalidCommandLine = true;
+                }
+            }
+            else if (strcmp(arguments[i], "--object-cache") == 0) {
+                if ((i + 1) < length) {
+                    i++;
+                    // Didn't make a copy of the directory. DO NOT DELETE IT.
+                    compiler->objectCacheDirectory = arguments[i];
+                }
+                else {
+                    printf("[error] The `--object-cache` flag expects an argument.\n");
+                    invalidCommandLine = true;
+                }
+            }
+            else if (strcmp(arguments[i], "--object-cache-size") == 0) {
+                if ((i + 1) < length) {
+                    i++;
+                    compiler->objectCacheSize = atoi(arguments[i]);
+                    if (compiler->objectCacheSize <= 0) {
+                        printf("[error] The `--object-cache-size` flag expects a positive integer.\n");
+                        invalidCommandLine = true;
+                    }
+                }
+                else {
+                    printf("[error] The `--object-cache-size` flag expects an argument.\n");
+                    invalidCommandLine = true;
+                }
+            }
+            else if (strncmp(arguments[i], "--opt=", 6) == 0) {
+                const char* level = arguments[i] + 6;
+                if (strcmp(level, "0") == 0) {
+                    compiler->optimization = OPTIMIZE_NONE;
+                }
+                else if (strcmp(level, "1") == 0) {
+                    compiler->optimization = OPTIMIZE_BASIC;
+                }
+                else if (strcmp(level, "2") == 0) {
+                    compiler->optimization = OPTIMIZE_DEFAULT;
+                }
+                else if (strcmp(level, "3") == 0) {
+                    compiler->optimization = OPTIMIZE_AGGRESSIVE;
+                }
+                else if (strcmp(level, "size") == 0) {
+                    compiler->optimization = OPTIMIZE_SIZE;
+                }
+                else {
+                    printf("[error] The `--opt` flag expects 0, 1, 2, 3, or size.\n");
+                    invalidCommandLine = true;
+                }
+            }
+            else if (strncmp(arguments[i], "--march=", 8) == 0) {
+                // Didn't make a copy of the target. DO NOT DELETE IT.
+                compiler->targetCpu = arguments[i] + 8;
+                if (compiler->targetCpu[0] == '\0') {
+                    printf("[error] The `--march` flag expects a target CPU, such as native.\n");
+                    invalidCommandLine = true;
+                }
+            }
+            else if (strcmp(arguments[i], "--lto") == 0) {
+                compiler->linkTimeOptimization = true;
+            }
+            else if (strcmp(arguments[i], "--debug") == 0) {
+                compiler->debugInfo = true;
+                compiler->strip = false;
+            }
+            else if (strcmp(arguments[i], "--strip") == 0) {
+                compiler->strip = true;
+            }
+            else if ((strcmp(arguments[i], "--profile-generate") == 0) ||
+                (strncmp(arguments[i], "--profile-generate=", 19) == 0)) {
+                compiler->profileGenerate = true;
+                compiler->profileUse = false;
+                if (arguments[i][18] == '=') {
+                    // Didn't make a copy of the directory. DO NOT DELETE IT.
+                    compiler->profileDirectory = arguments[i] + 19;
+                }
+            }
+            else if ((strcmp(arguments[i], "--profile-use") == 0) ||
+                (strncmp(arguments[i], "--profile-use=", 14) == 0)) {
+                compiler->profileUse = true;
+                compiler->profileGenerate = false;
+                if (arguments[i][13] == '=') {
+                    // Didn't make a copy of the directory. DO NOT DELETE IT.
+                    compiler->profileDirectory = arguments[i] + 14;
+                }
+            }
+            else if (strcmp(arguments[i], "--in-memory") == 0) {
+                compiler->inMemory = true;
+            }
+            else if (strcmp(arguments[i], "--unity") == 0) {
+                compiler->unity = true;
+            }
+            else if (strcmp(arguments[i], "--release") == 0) {
+                compiler->optimization = OPTIMIZE_DEFAULT;
+                compiler->debugInfo = false;
+            }
+            else if (strcmp(arguments[i], "--no-cache") == 0) {
+                compiler->useBuildCache = false;
+            }
+            else if (strcmp(arguments[i], "--pipeline") == 0) {
+                compiler->pipeline = true;
+            }
+            else if (strcmp(arguments[i], "--threads") == 0) {
+                if ((i + 1) < length) {
+                    i++;
+                    compiler->threads = atoi(arguments[i]);
+                    if (compiler->threads <= 0) {
+                        printf("[error] The `--threads` flag expects a positive integer.\n");
+                        invalidCommandLine = true;
+                    }
+                }
+                else {
+                    printf("[error] The `--threads` flag expects an argument.\n");
+                    invalidCommandLine = true;
+                }
+            }
             else if (strcmp(arguments[i], "--log") == 0) {
                 if ((i + 1) < length) {
                     i++;
@@ -549,30 +1898,54 @@ bool compileEx(Compiler* compiler, char** arguments, int32_t length) {
         }
     }
 
+    /* The unity file includes the generated files from the disk, which are
+     * never written in memory.
+     */
+    if (compiler->unity && compiler->inMemory) {
+        printf("[error] The `--unity` flag cannot be combined with the `--in-memory` flag.\n");
+        invalidCommandLine = true;
+    }
+
     if (showVersion) {
         printf("kush v%d.%d\n", KUSH_VERSION_MAJOR, KUSH_VERSION_MINOR);
     }
     else if (showHelp) {
         printHelp();
     }
+    else if (invalidCommandLine) {
+        result = false;
+    }
     else {
 
         int32_t size = jtk_ArrayList_getSize(compiler->inputFiles);
         bool noErrors = false;
         if (size == 0) {
             fprintf(stderr, "\033[1;31m[error]\033[0m Please specify input files.\n");
+            result = false;
         }
         else {
             initializePrimitives();
             initialize(compiler);
+            if (compiler->useBuildCache && !compiler->inMemory) {
+                checkBuildCache(compiler);
+            }
             buildAST(compiler);
             if (!compiler->dumpTokens && (noErrors = (compiler->errorHandler->errors->m_size == 0))) {
                 analyze(compiler);
 
                 if (jtk_ArrayList_isEmpty(compiler->errorHandler->errors)) {
                     generate(compiler);
-                    buildExecutable(compiler);
+                    if (compiler->useBuildCache && !compiler->inMemory) {
+                        updateBuildCacheEntries(compiler);
+                    }
+                    result = buildExecutable(compiler);
                 }
+                else {
+                    result = false;
+                }
+            }
+            else if (!jtk_ArrayList_isEmpty(compiler->errorHandler->errors)) {
+                result = false;
             }
             destroyPrimitives();
         }
@@ -588,14 +1961,25 @@ bool compileEx(Compiler* compiler, char** arguments, int32_t length) {
         }
     }
 
-    // TODO: Return true only if the compilation suceeded.
-    return true;
+    return result;
 }
 
 bool compile(Compiler* compiler) {
     return compileEx(compiler, NULL, -1);
 }
 
+/* Returns the number of processors that are online, which is the default
+ * number of threads.
+ */
+int32_t getProcessorCount() {
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0)? (int32_t)count : 1;
+#else
+    return 1;
+#endif
+}
+
 // Constructor
 
 Compiler* newCompiler() {
@@ -606,8 +1990,31 @@ Compiler* newCompiler() {
     compiler->dumpNodes = false;
     compiler->footprint = false;
     compiler->dumpInstructions = false;
+    compiler->reportBoundsChecks = false;
+    compiler->compressedReferences = false;
     compiler->inputFiles = jtk_ArrayList_new();
-    compiler->currentFileIndex = -1;
+    compiler->linkerFlags = jtk_ArrayList_new();
+    compiler->threads = getProcessorCount();
+    compiler->jobs = compiler->threads;
+    compiler->optimization = OPTIMIZE_NONE;
+    compiler->targetCpu = NULL;
+    compiler->linkTimeOptimization = false;
+    compiler->debugInfo = true;
+    compiler->strip = false;
+    compiler->profileGenerate = false;
+    compiler->profileUse = false;
+    compiler->profileDirectory = KUSH_PROFILE_DIRECTORY;
+    compiler->unity = false;
+    compiler->inMemory = false;
+    compiler->objectCacheDirectory = NULL;
+    compiler->objectCacheSize = KUSH_OBJECT_CACHE_SIZE;
+    compiler->pipeline = false;
+    compiler->useBuildCache = true;
+    compiler->buildCache = NULL;
+    compiler->hashes = NULL;
+    compiler->upToDate = NULL;
+    compiler->generatedSources = NULL;
+    compiler->generatedSizes = NULL;
     compiler->errorHandler = newErrorHandler();
     compiler->modules = NULL;
     compiler->packages = NULL;
@@ -656,10 +2063,25 @@ void deleteCompiler(Compiler* compiler) {
         int32_t i;
         int32_t inputCount = jtk_ArrayList_getSize(compiler->inputFiles);
         for (i = 0; i < inputCount; i++) {
-            jtk_CString_delete(compiler->packages[i]);
+            if (compiler->packages[i] != NULL) {
+                jtk_CString_delete(compiler->packages[i]);
+            }
         }
         deallocate(compiler->packages);
         deallocate(compiler->packageSizes);
+        deallocate(compiler->hashes);
+        deallocate(compiler->upToDate);
+
+        for (i = 0; i < inputCount; i++) {
+            /* The buffers are allocated by open_memstream(). */
+            free(compiler->generatedSources[i]);
+        }
+        deallocate(compiler->generatedSources);
+        deallocate(compiler->generatedSizes);
+    }
+
+    if (compiler->buildCache != NULL) {
+        deleteBuildCache(compiler->buildCache);
     }
 
     jtk_Iterator_t* iterator = jtk_HashMap_getKeyIterator(compiler->repository);
@@ -676,6 +2098,7 @@ void deleteCompiler(Compiler* compiler) {
     jtk_Logger_delete(compiler->logger);
 #endif
 
+    jtk_ArrayList_delete(compiler->linkerFlags);
     jtk_ArrayList_delete(compiler->inputFiles);
     deallocate(compiler);
 }
\ No newline at end of file
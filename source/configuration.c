@@ -19,12 +19,13 @@
 static int32_t s_footprint = 0;
 
 void* allocate0(int32_t size) {
-    s_footprint += size;
+    /* The input files are parsed by multiple threads. */
+    __atomic_fetch_add(&s_footprint, size, __ATOMIC_RELAXED);
 
     void* object = malloc(size);
     return object;
 }
 
 int32_t k_Memory_getFootprint() {
-    return s_footprint;
+    return __atomic_load_n(&s_footprint, __ATOMIC_RELAXED);
 }
\ No newline at end of file
@@ -35,6 +35,8 @@ Type* newType(uint8_t tag, bool indexable, bool accessible, bool callable,
     type->reference = allocatable;
     type->identifier = identifier;
     type->arrayTypes = jtk_ArrayList_new();
+    type->instances = NULL;
+    type->arguments = NULL;
 
     return type;
 }
@@ -197,6 +199,126 @@ Primitives primitives = {
         }
     },
 
+    .i32x4 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "i32x4",
+            .lane = &primitives.i32,
+            .lanes = 4
+        }
+    },
+
+    .i32x8 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "i32x8",
+            .lane = &primitives.i32,
+            .lanes = 8
+        }
+    },
+
+    .i64x2 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "i64x2",
+            .lane = &primitives.i64,
+            .lanes = 2
+        }
+    },
+
+    .i64x4 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "i64x4",
+            .lane = &primitives.i64,
+            .lanes = 4
+        }
+    },
+
+    .f32x4 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "f32x4",
+            .lane = &primitives.f32,
+            .lanes = 4
+        }
+    },
+
+    .f32x8 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "f32x8",
+            .lane = &primitives.f32,
+            .lanes = 8
+        }
+    },
+
+    .f64x2 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "f64x2",
+            .lane = &primitives.f64,
+            .lanes = 2
+        }
+    },
+
+    .f64x4 = {
+        .tag = TYPE_VECTOR,
+        .indexable = false,
+        .accessible = false,
+        .callable = false,
+        .reference = false,
+        .identifier = NULL,
+        .arrayTypes = NULL,
+        .vector = {
+            .name = "f64x4",
+            .lane = &primitives.f64,
+            .lanes = 4
+        }
+    },
+
     .void_ = {
         .tag = TYPE_VOID,
         .indexable = false,
@@ -385,6 +507,8 @@ MemberAccess* newMemberAccess() {
     MemberAccess* result = allocate(MemberAccess, 1);
     result->tag = CONTEXT_MEMBER_ACCESS;
     result->identifier = NULL;
+    result->previous = NULL;
+    result->type = NULL;
     return result;
 }
 
@@ -439,10 +563,16 @@ FunctionArguments* newFunctionArguments() {
     result->tag = CONTEXT_FUNCTION_ARGUMENTS;
     result->parenthesis = NULL;
     result->expressions = jtk_ArrayList_new();
+    result->function = NULL;
+    result->instance = NULL;
+    result->types = NULL;
     return result;
 }
 
 void deleteFunctionArguments(FunctionArguments* self) {
+    if (self->types != NULL) {
+        jtk_ArrayList_delete(self->types);
+    }
     jtk_ArrayList_delete(self->expressions);
     deallocate(self);
 }
@@ -456,6 +586,8 @@ Subscript* newSubscript() {
     result->tag = CONTEXT_SUBSCRIPT;
     result->bracket = NULL;
     result->expression = NULL;
+    result->checked = true;
+    result->type = NULL;
     return result;
 }
 
@@ -499,7 +631,10 @@ Function* newFunction(const uint8_t* name, int32_t nameSize, Token* identifier,
     result->returnType = NULL;
     result->type = newType(TYPE_FUNCTION, false, false, true, false, identifier);
     result->scope = NULL;
+    result->modifiers = 0;
     result->totalReferences = 0;
+    result->boundsChecks = 0;
+    result->eliminatedChecks = 0;
 
     // TODO: Probably move this to newType(), or some overloaded version of it?
     result->type->function = result;
@@ -526,6 +661,7 @@ Structure* newStructure(const uint8_t* name, int32_t nameSize,
     result->declarations = variables;
     result->type = newType(TYPE_STRUCTURE, false, true, false, true, identifier);
     result->scope = NULL;
+    result->typeParameters = NULL;
 
     // TODO: Probably move this to newType(), or some overloaded version of it?
     result->type->structure = result;
@@ -634,6 +770,7 @@ void deleteCatchClause(CatchClause* self) {
 VariableType* newVariableType(Token* token, int32_t dimensions) {
     VariableType* self = allocate(VariableType, 1);
     self->token = token;
+    self->arguments = NULL;
     self->dimensions = dimensions;
 
     return self;
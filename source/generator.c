@@ -16,8 +16,11 @@
 
 // Sunday, June 18 2020
 
+#include <string.h>
+
 #include <jtk/collection/Pair.h>
 #include <jtk/core/CString.h>
+#include <kush/build-cache.h>
 #include <kush/generator.h>
 
 #define invalidate(generator) generator->scope = generator->scope->parent
@@ -26,7 +29,10 @@
  * Generator                                                                  *
  ******************************************************************************/
 
+static void generateArrayType(Generator* generator, Type* type);
 static void generateType(Generator* generator, Type* type);
+static void generateNativeType(Generator* generator, Type* type);
+static void generateNativePrototype(Generator* generator, Function* function);
 static void generateForwardReferences(Generator* generator, Module* module);
 static void generateStructures(Generator* generator, Module* module);
 static void generateBinary(Generator* generator, BinaryExpression* expression);
@@ -34,9 +40,22 @@ static void generateConditional(Generator* generator, ConditionalExpression* exp
 static void generateUnary(Generator* generator, UnaryExpression* expression);
 static void generateSubscript(Generator* generator, Subscript* subscript);
 static void generateFunctionArguments(Generator* generator, FunctionArguments* arguments);
+static void generateNativeArguments(Generator* generator, FunctionArguments* arguments);
 static void generateMemberAccess(Generator* generator, MemberAccess* access);
+static Type* getSlotType(Context* postfix);
+static const char* getValueMember(Type* type);
+static bool isUnboxed(Type* instance);
+static Type* getBoundReturnType(Context* postfix);
+static bool isBitSubscript(Context* postfix);
+static void generateBitAccess(Generator* generator, PostfixExpression* expression,
+    int32_t count, const char* operation);
+static void generateSlot(Generator* generator, PostfixExpression* expression,
+    int32_t count);
+static void generatePostfixParts(Generator* generator, PostfixExpression* expression,
+    int32_t count);
 static void generatePostfix(Generator* generator, PostfixExpression* expression);
 static void generateToken(Generator* generator, Token* token);
+static void generateGenericObject(Generator* generator, Type* type);
 static void generateNewExpression(Generator* generator, NewExpression* expression);
 static void generateArray(Generator* generator, ArrayExpression* expression);
 static void generateExpression(Generator* generator, Context* context);
@@ -46,6 +65,51 @@ static void generateFunction(Generator* generator, Function* function);
 static void generateFunctions(Generator* generator, Module* module);
 static void generateConstructors(Generator* generator, Module* module);
 static void generateHeader(Generator* generator, Module* module);
+static void generateLinkage(Generator* generator, const uint8_t* name);
+
+/* Arrays of primitive values have a structure for each element type. The other
+ * arrays store references.
+ */
+void generateArrayType(Generator* generator, Type* type) {
+    Type* base = type->array.base;
+    const char* output = "k_Array_t*";
+    if (type->array.dimensions == 1) {
+        if (base == &primitives.boolean) {
+            output = "k_ArrayBoolean_t*";
+        }
+        else if (base == &primitives.i8) {
+            output = "k_ArrayI8_t*";
+        }
+        else if (base == &primitives.i16) {
+            output = "k_ArrayI16_t*";
+        }
+        else if (base == &primitives.i32) {
+            output = "k_IntegerArray_t*";
+        }
+        else if (base == &primitives.i64) {
+            output = "k_ArrayI64_t*";
+        }
+        else if (base == &primitives.ui8) {
+            output = "k_ArrayUi8_t*";
+        }
+        else if (base == &primitives.ui16) {
+            output = "k_ArrayUi16_t*";
+        }
+        else if (base == &primitives.ui32) {
+            output = "k_ArrayUi32_t*";
+        }
+        else if (base == &primitives.ui64) {
+            output = "k_ArrayUi64_t*";
+        }
+        else if (base == &primitives.f32) {
+            output = "k_ArrayF32_t*";
+        }
+        else if (base == &primitives.f64) {
+            output = "k_ArrayF64_t*";
+        }
+    }
+    fprintf(generator->output, "%s", output);
+}
 
 void generateType(Generator* generator, Type* type) {
     const char* output = NULL;
@@ -93,16 +157,69 @@ void generateType(Generator* generator, Type* type) {
     }
     else {
         if (type->tag == TYPE_ARRAY) {
-            if (type->array.base == &primitives.i32) {
-                fprintf(generator->output, "k_IntegerArray_t*");
-            }
-            else {
-                fprintf(generator->output, "k_Array_t*");
-            }
+            generateArrayType(generator, type);
         }
         else if (type->tag == TYPE_STRUCTURE) {
             fprintf(generator->output, "kush_%s*", type->structure->name);
         }
+        else if (type->tag == TYPE_VECTOR) {
+            fprintf(generator->output, "k_%s_t", type->vector.name);
+        }
+    }
+}
+
+/* Arrays of primitives and strings are passed to native functions as pointers
+ * to their elements. Boolean arrays are passed as their 64-bit words.
+ */
+void generateNativeType(Generator* generator, Type* type) {
+    if (type->tag == TYPE_ARRAY) {
+        if (type->array.component == &primitives.boolean) {
+            fprintf(generator->output, "uint64_t*");
+        }
+        else {
+            generateType(generator, type->array.component);
+            fprintf(generator->output, "*");
+        }
+    }
+    else if (type == &primitives.string) {
+        fprintf(generator->output, "const char*");
+    }
+    else {
+        generateType(generator, type);
+    }
+}
+
+/* A native function is declared with the `kush_` prefix, like any other
+ * function, and bound to the C symbol with an assembler label. Therefore, the
+ * prototype never conflicts with a declaration from a C header.
+ */
+void generateNativePrototype(Generator* generator, Function* function) {
+    generateType(generator, function->returnType);
+    fprintf(generator->output, " kush_%s(", function->name);
+    int32_t parameterCount = jtk_ArrayList_getSize(function->parameters);
+    int32_t i;
+    for (i = 0; i < parameterCount; i++) {
+        Variable* parameter = (Variable*)jtk_ArrayList_getValue(function->parameters, i);
+        if (i > 0) {
+            fprintf(generator->output, ", ");
+        }
+        generateNativeType(generator, parameter->type);
+        fprintf(generator->output, " %s", parameter->name);
+    }
+    if (parameterCount == 0) {
+        fprintf(generator->output, "void");
+    }
+    fprintf(generator->output, ") __asm__(K_NATIVE_SYMBOL(\"%s\"));\n", function->name);
+}
+
+/* In a unity build, every function except the entry point has internal
+ * linkage. The C compiler can then inline the functions across the modules
+ * and discard the ones that are not used.
+ */
+void generateLinkage(Generator* generator, const uint8_t* name) {
+    if (generator->compiler->unity &&
+        ((name == NULL) || (strcmp((const char*)name, "main") != 0))) {
+        fprintf(generator->output, "static ");
     }
 }
 
@@ -121,6 +238,11 @@ void generateForwardReferences(Generator* generator, Module* module) {
     for (i = 0; i < functionCount; i++) {
         Function* function = (Function*)jtk_ArrayList_getValue(
             module->functions, i);
+        if (hasNative(function->modifiers)) {
+            generateNativePrototype(generator, function);
+            continue;
+        }
+        generateLinkage(generator, function->name);
         generateType(generator, function->returnType);
         fprintf(generator->output, " kush_%s(k_Runtime_t* runtime", function->name);
         int32_t parameterCount = jtk_ArrayList_getSize(function->parameters);
@@ -145,19 +267,33 @@ void generateStructures(Generator* generator, Module* module) {
         fprintf(generator->output, "struct kush_%s {\n", structure->name);
         fprintf(generator->output, "    k_ObjectHeader_t header;\n");
 
+        /* The reference fields are laid out first, so that the collector can
+         * trace them without knowing the structure. They are stored as
+         * k_Reference_t, which may be compressed.
+         */
         int32_t declarationCount = jtk_ArrayList_getSize(structure->declarations);
-        int32_t i;
-        for (i = 0; i < declarationCount; i++) {
-            VariableDeclaration* declaration =
-                (VariableDeclaration*)jtk_ArrayList_getValue(structure->declarations, i);
-
-            int32_t limit = jtk_ArrayList_getSize(declaration->variables);
-            int32_t j;
-            for (j = 0; j < limit; j++) {
-                Variable* variable = (Variable*)jtk_ArrayList_getValue(declaration->variables, j);
-                fprintf(generator->output, "    ");
-                generateType(generator, variable->type);
-                fprintf(generator->output, " %s;\n", variable->name);
+        int32_t pass;
+        for (pass = 0; pass < 2; pass++) {
+            int32_t i;
+            for (i = 0; i < declarationCount; i++) {
+                VariableDeclaration* declaration =
+                    (VariableDeclaration*)jtk_ArrayList_getValue(structure->declarations, i);
+
+                int32_t limit = jtk_ArrayList_getSize(declaration->variables);
+                int32_t j;
+                for (j = 0; j < limit; j++) {
+                    Variable* variable = (Variable*)jtk_ArrayList_getValue(declaration->variables, j);
+                    if (variable->type->reference == (pass == 0)) {
+                        fprintf(generator->output, "    ");
+                        if (variable->type->reference) {
+                            fprintf(generator->output, "k_Reference_t");
+                        }
+                        else {
+                            generateType(generator, variable->type);
+                        }
+                        fprintf(generator->output, " %s;\n", variable->name);
+                    }
+                }
             }
         }
 
@@ -168,6 +304,7 @@ void generateStructures(Generator* generator, Module* module) {
     for (j = 0; j < structureCount; j++) {
         Structure* structure = (Structure*)jtk_ArrayList_getValue(
             module->structures, j);
+        generateLinkage(generator, NULL);
         fprintf(generator->output, "kush_%s* $%s_new(k_Runtime_t* runtime", structure->name, structure->name);
 
         int32_t declarationCount = jtk_ArrayList_getSize(structure->declarations);
@@ -196,15 +333,35 @@ void generateStructures(Generator* generator, Module* module) {
  */
 void generateAssignment(Generator* generator, BinaryExpression* expression) {
     int32_t count = jtk_ArrayList_getSize(expression->others);
+    generator->assignment = (count > 0)? (Token*)((jtk_Pair_t*)jtk_ArrayList_getValue(
+        expression->others, 0))->m_left : NULL;
+    generator->encoding = false;
+    generator->packing = false;
     generateExpression(generator, (Context*)expression->left);
+    generator->assignment = NULL;
 
     if (count > 0) {
+        /* A reference stored to a field or an array element is encoded. An
+         * element of a boolean array is stored by the macro that the target
+         * opened.
+         */
+        bool encoding = generator->encoding;
+        bool packing = generator->packing;
         int32_t i;
         for (i = 0; i < count; i++) {
             jtk_Pair_t* pair = (jtk_Pair_t*)jtk_ArrayList_getValue(expression->others, i);
-            fprintf(generator->output, " %s ", ((Token*)pair->m_left)->text);
+            if (!packing || (i > 0)) {
+                fprintf(generator->output, " %s ", ((Token*)pair->m_left)->text);
+            }
+            if (encoding && (i == 0)) {
+                fprintf(generator->output, "K_ENCODE(");
+            }
             generateExpression(generator, (Context*)pair->m_right);
         }
+
+        if (encoding || packing) {
+            fprintf(generator->output, ")");
+        }
     }
 }
 
@@ -253,51 +410,313 @@ void generateSubscript(Generator* generator, Subscript* subscript) {
     fprintf(generator->output, "]");
 }
 
+/* The arguments of a generic function that are bound to type parameters are
+ * passed as k_Value_t. When the type stores its values unboxed, the C types of
+ * the type arguments are passed after the runtime instead.
+ *
+ * A native function does not receive the runtime. Its array and string
+ * arguments are passed as pointers to their elements, without copying.
+ */
 void generateFunctionArguments(Generator* generator, FunctionArguments* arguments) {
+    if ((arguments->function != NULL) && hasNative(arguments->function->modifiers)) {
+        generateNativeArguments(generator, arguments);
+        return;
+    }
+
     fprintf(generator->output, "(runtime");
+    bool unboxed = (arguments->instance != NULL) && isUnboxed(arguments->instance);
+    if (unboxed) {
+        int32_t typeCount = jtk_ArrayList_getSize(arguments->instance->arguments);
+        int32_t i;
+        for (i = 0; i < typeCount; i++) {
+            fprintf(generator->output, ", ");
+            generateType(generator, (Type*)jtk_ArrayList_getValue(
+                arguments->instance->arguments, i));
+        }
+    }
+
     int32_t count = jtk_ArrayList_getSize(arguments->expressions);
     int32_t j;
     for (j = 0; j < count; j++) {
         Context* context = (Context*)jtk_ArrayList_getValue(arguments->expressions, j);
         fprintf(generator->output, ", ");
-        generateExpression(generator, context);
+
+        Type* parameterType = NULL;
+        if ((arguments->instance != NULL) && !unboxed) {
+            Variable* parameter = (Variable*)jtk_ArrayList_getValue(
+                arguments->function->parameters, j);
+            parameterType = parameter->type;
+        }
+
+        if ((parameterType != NULL) && (parameterType->tag == TYPE_PARAMETER)) {
+            Type* type = (Type*)jtk_ArrayList_getValue(arguments->instance->arguments,
+                parameterType->parameter.index);
+            fprintf(generator->output, "(k_Value_t){ .%s = ", getValueMember(type));
+            generateExpression(generator, context);
+            fprintf(generator->output, " }");
+        }
+        else {
+            generateExpression(generator, context);
+        }
+    }
+    fprintf(generator->output, ")");
+}
+
+void generateNativeArguments(Generator* generator, FunctionArguments* arguments) {
+    fprintf(generator->output, "(");
+    int32_t count = jtk_ArrayList_getSize(arguments->expressions);
+    int32_t j;
+    for (j = 0; j < count; j++) {
+        Context* context = (Context*)jtk_ArrayList_getValue(arguments->expressions, j);
+        Variable* parameter = (Variable*)jtk_ArrayList_getValue(
+            arguments->function->parameters, j);
+        if (j > 0) {
+            fprintf(generator->output, ", ");
+        }
+
+        /* The value of a string is the only array type that is not a
+         * reference. It is generated as the string itself, whose bytes are
+         * stored inline.
+         */
+        Type* type = (Type*)jtk_ArrayList_getValue(arguments->types, j);
+        bool bytes = (type != NULL) && (type->tag == TYPE_ARRAY) && !type->reference;
+
+        const char* wrapper = NULL;
+        if (bytes) {
+            wrapper = "K_NATIVE_BYTES";
+        }
+        else if (parameter->type->tag == TYPE_ARRAY) {
+            wrapper = "K_NATIVE_ARRAY";
+        }
+        else if (parameter->type == &primitives.string) {
+            wrapper = "K_NATIVE_STRING";
+        }
+
+        if (wrapper != NULL) {
+            /* The type is repeated, because a `null` literal does not have
+             * the type of the parameter.
+             */
+            fprintf(generator->output, "%s(", wrapper);
+            if (!bytes && (parameter->type->tag == TYPE_ARRAY)) {
+                generateType(generator, parameter->type);
+                fprintf(generator->output, ", ");
+            }
+            generateExpression(generator, context);
+            fprintf(generator->output, ")");
+        }
+        else {
+            generateExpression(generator, context);
+        }
     }
     fprintf(generator->output, ")");
 }
 
 void generateMemberAccess(Generator* generator, MemberAccess* access) {
-    fprintf(generator->output, "->%s", access->identifier->text);
+    /* A string object is laid out as its own byte array. Therefore, `value`
+     * on a string does not generate any code.
+     */
+    bool stringValue = (access->previous == &primitives.string) &&
+        jtk_CString_equals(access->identifier->text, access->identifier->length,
+            "value", 5);
+    if (!stringValue) {
+        fprintf(generator->output, "->%s", access->identifier->text);
+    }
 }
 
-void generatePostfix(Generator* generator, PostfixExpression* expression) {
-    if (expression->token) {
-        generateToken(generator, (Token*)expression->primary);
+/* Returns the type of the reference that the specified postfix part loads
+ * from a structure field or an array element. Such references are stored as
+ * k_Reference_t. If the part does not load a reference from an object, the
+ * result is `NULL`.
+ */
+Type* getSlotType(Context* postfix) {
+    Type* result = NULL;
+    if (postfix->tag == CONTEXT_SUBSCRIPT) {
+        result = ((Subscript*)postfix)->type;
     }
-    else {
-        fprintf(generator->output, "(");
-        generateExpression(generator, (Context*)expression->primary);
+    else if (postfix->tag == CONTEXT_MEMBER_ACCESS) {
+        MemberAccess* access = (MemberAccess*)postfix;
+        if ((access->previous != NULL) && (access->previous->tag == TYPE_STRUCTURE)) {
+            result = access->type;
+        }
+    }
+    return ((result != NULL) && result->reference)? result : NULL;
+}
+
+/* Returns the member of k_Value_t that holds values of the specified type. */
+const char* getValueMember(Type* type) {
+    const char* result = "reference";
+    if ((type->tag == TYPE_INTEGER) || (type->tag == TYPE_BOOLEAN)) {
+        result = "integer";
+    }
+    else if (type->tag == TYPE_DECIMAL) {
+        result = "decimal";
+    }
+    return result;
+}
+
+/* Determines whether the instance of a generic type stores its values
+ * unboxed.
+ */
+bool isUnboxed(Type* instance) {
+    Type* parameter = (Type*)jtk_ArrayList_getValue(
+        instance->structure->typeParameters, 0);
+    return parameter->parameter.unboxed;
+}
+
+/* Returns the type that the return type of a generic function is bound to, if
+ * the specified postfix part invokes such a function and the value is wrapped
+ * in k_Value_t. Otherwise, the result is `NULL`.
+ */
+Type* getBoundReturnType(Context* postfix) {
+    Type* result = NULL;
+    if (postfix->tag == CONTEXT_FUNCTION_ARGUMENTS) {
+        FunctionArguments* arguments = (FunctionArguments*)postfix;
+        if ((arguments->instance != NULL) && !isUnboxed(arguments->instance)) {
+            Type* returnType = arguments->function->returnType;
+            if (returnType->tag == TYPE_PARAMETER) {
+                result = (Type*)jtk_ArrayList_getValue(arguments->instance->arguments,
+                    returnType->parameter.index);
+            }
+        }
+    }
+    return result;
+}
+
+/* Determines whether the specified postfix part accesses an element of a
+ * boolean array, which is packed into bits.
+ */
+bool isBitSubscript(Context* postfix) {
+    return (postfix->tag == CONTEXT_SUBSCRIPT) &&
+        (((Subscript*)postfix)->type == &primitives.boolean);
+}
+
+/* Opens the macro that accesses an element of a boolean array, with the
+ * runtime, whether the index is checked, the array and the index as the
+ * arguments. The caller generates the remaining arguments, if any.
+ */
+void generateBitAccess(Generator* generator, PostfixExpression* expression,
+    int32_t count, const char* operation) {
+    Subscript* subscript = (Subscript*)jtk_ArrayList_getValue(
+        expression->postfixParts, count - 1);
+    fprintf(generator->output, "%s(runtime, %d, ", operation, subscript->checked);
+    generatePostfixParts(generator, expression, count - 1);
+    fprintf(generator->output, ", ");
+    generateExpression(generator, (Context*)subscript->expression);
+}
+
+/* Generates the primary expression followed by the first `count` postfix parts.
+ * A reference loaded from an object is decoded. A value returned by a generic
+ * function is unwrapped from k_Value_t.
+ */
+void generatePostfixParts(Generator* generator, PostfixExpression* expression,
+    int32_t count) {
+    Context* postfix = (count > 0)? (Context*)jtk_ArrayList_getValue(
+        expression->postfixParts, count - 1) : NULL;
+    Type* slotType = (postfix != NULL)? getSlotType(postfix) : NULL;
+    Type* boundType = (postfix != NULL)? getBoundReturnType(postfix) : NULL;
+    if (boundType != NULL) {
+        fprintf(generator->output, "((");
+        generateType(generator, boundType);
+        fprintf(generator->output, ")");
+        generateSlot(generator, expression, count);
+        fprintf(generator->output, ".%s)", getValueMember(boundType));
+    }
+    else if ((postfix != NULL) && isBitSubscript(postfix)) {
+        generateBitAccess(generator, expression, count, "K_LOAD_BIT");
+        fprintf(generator->output, ")");
+    }
+    else if (slotType != NULL) {
+        fprintf(generator->output, "K_DECODE(");
+        generateType(generator, slotType);
+        fprintf(generator->output, ", ");
+        generateSlot(generator, expression, count);
         fprintf(generator->output, ")");
     }
+    else {
+        generateSlot(generator, expression, count);
+    }
+}
 
-    int32_t count = jtk_ArrayList_getSize(expression->postfixParts);
-    int32_t i;
-    for (i = 0; i < count; i++) {
+/* Generates the primary expression followed by the first `count` postfix parts,
+ * without decoding the result. A checked subscript wraps the code generated
+ * for the parts before it.
+ */
+void generateSlot(Generator* generator, PostfixExpression* expression,
+    int32_t count) {
+    if (count == 0) {
+        if (expression->token) {
+            generateToken(generator, (Token*)expression->primary);
+        }
+        else {
+            fprintf(generator->output, "(");
+            generateExpression(generator, (Context*)expression->primary);
+            fprintf(generator->output, ")");
+        }
+    }
+    else {
         Context* postfix = (Context*)jtk_ArrayList_getValue(
-            expression->postfixParts, i);
+            expression->postfixParts, count - 1);
 
-        if (postfix->tag == CONTEXT_SUBSCRIPT) {
-            generateSubscript(generator, (Subscript*)postfix);
+        if ((postfix->tag == CONTEXT_SUBSCRIPT) && ((Subscript*)postfix)->checked) {
+            fprintf(generator->output, "K_CHECKED_ELEMENT(runtime, ");
+            generatePostfixParts(generator, expression, count - 1);
+            fprintf(generator->output, ", ");
+            generateExpression(generator, (Context*)((Subscript*)postfix)->expression);
+            fprintf(generator->output, ")");
         }
-        else if (postfix->tag == CONTEXT_FUNCTION_ARGUMENTS) {
-            generateFunctionArguments(generator, (FunctionArguments*)postfix);
+        else {
+            generatePostfixParts(generator, expression, count - 1);
+
+            if (postfix->tag == CONTEXT_SUBSCRIPT) {
+                generateSubscript(generator, (Subscript*)postfix);
+            }
+            else if (postfix->tag == CONTEXT_FUNCTION_ARGUMENTS) {
+                generateFunctionArguments(generator, (FunctionArguments*)postfix);
+            }
+            else if (postfix->tag == CONTEXT_MEMBER_ACCESS) {
+                generateMemberAccess(generator, (MemberAccess*)postfix);
+            }
+            else {
+                controlError();
+            }
         }
-        else if (postfix->tag == CONTEXT_MEMBER_ACCESS) {
-            generateMemberAccess(generator, (MemberAccess*)postfix);
+    }
+}
+
+void generatePostfix(Generator* generator, PostfixExpression* expression) {
+    int32_t count = jtk_ArrayList_getSize(expression->postfixParts);
+    Context* postfix = (count > 0)? (Context*)jtk_ArrayList_getValue(
+        expression->postfixParts, count - 1) : NULL;
+    if (generator->assignment != NULL) {
+        /* The target of an assignment is a slot that is stored to. The flags
+         * are set after the slot is generated, since the indices are
+         * expressions of their own.
+         */
+        Token* operator = generator->assignment;
+        generator->assignment = NULL;
+        bool encoding = false;
+        bool packing = false;
+        if ((postfix != NULL) && isBitSubscript(postfix)) {
+            if (operator->type == TOKEN_EQUAL) {
+                generateBitAccess(generator, expression, count, "K_STORE_BIT");
+                fprintf(generator->output, ", ");
+            }
+            else {
+                /* The compound operator is passed without the equal sign. */
+                generateBitAccess(generator, expression, count, "K_UPDATE_BIT");
+                fprintf(generator->output, ", %.*s, ", operator->length - 1, operator->text);
+            }
+            packing = true;
         }
         else {
-            controlError();
-            break;
+            encoding = (postfix != NULL) && (getSlotType(postfix) != NULL);
+            generateSlot(generator, expression, count);
         }
+        generator->encoding = encoding;
+        generator->packing = packing;
+    }
+    else {
+        generatePostfixParts(generator, expression, count);
     }
 }
 
@@ -458,6 +877,32 @@ void generateObjectExpression(Generator* generator, NewExpression* expression) {
     fprintf(generator->output, ")");
 }
 
+/* Instances of the generic builtins are created by the runtime, which is told
+ * how to treat the type arguments.
+ */
+void generateGenericObject(Generator* generator, Type* type) {
+    if (isUnboxed(type)) {
+        /* The storage is laid out for the element type. */
+        Type* elementType = (Type*)jtk_ArrayList_getValue(type->arguments, 0);
+        fprintf(generator->output, "kush_%s_new(runtime, sizeof (", type->structure->name);
+        generateType(generator, elementType);
+        fprintf(generator->output, "), %s)", elementType->reference? "true" : "false");
+    }
+    else {
+        Type* keyType = (Type*)jtk_ArrayList_getValue(type->arguments, 0);
+        Type* valueType = (Type*)jtk_ArrayList_getValue(type->arguments, 1);
+        const char* keyKind = "K_MAP_KEY_REFERENCE";
+        if (keyType == &primitives.string) {
+            keyKind = "K_MAP_KEY_STRING";
+        }
+        else if (keyType->tag == TYPE_INTEGER) {
+            keyKind = "K_MAP_KEY_INTEGER";
+        }
+        fprintf(generator->output, "kush_%s_new(runtime, %s, %s)", type->structure->name,
+            keyKind, valueType->reference? "true" : "false");
+    }
+}
+
 void generateNewExpression(Generator* generator, NewExpression* expression) {
     Type* type = expression->type;
     if (type->tag == TYPE_ARRAY) {
@@ -467,12 +912,19 @@ void generateNewExpression(Generator* generator, NewExpression* expression) {
         int32_t limit = jtk_ArrayList_getSize(expression->expressions);
         int32_t i;
         for (i = 0; i < limit; i++) {
-            fprintf(generator->output, ", ");
+            /* The sizes are passed as variable arguments, which are read as
+             * 64-bit integers.
+             */
+            fprintf(generator->output, ", (int64_t)(");
             Context* context = (Context*)jtk_ArrayList_getValue(expression->expressions, i);
             generateExpression(generator, context);
+            fprintf(generator->output, ")");
         }
         fprintf(generator->output, ")");
     }
+    else if (type->arguments != NULL) {
+        generateGenericObject(generator, type);
+    }
     else {
         generateObjectExpression(generator, expression);
     }
@@ -734,6 +1186,7 @@ void generateFunction(Generator* generator, Function* function) {
     generator->scope = function->scope;
 
     generator->index = 0;
+    generateLinkage(generator, function->name);
     generateType(generator, function->returnType);
     fprintf(generator->output, " kush_%s(k_Runtime_t* runtime", function->name);
 
@@ -774,7 +1227,9 @@ void generateFunctions(Generator* generator, Module* module) {
     for (i = 0; i < functionCount; i++) {
         Function* function = (Function*)jtk_ArrayList_getValue(
             module->functions, i);
-        generateFunction(generator, function);
+        if (!hasNative(function->modifiers)) {
+            generateFunction(generator, function);
+        }
     }
 }
 
@@ -785,6 +1240,7 @@ void generateConstructors(Generator* generator, Module* module) {
         Structure* structure = (Structure*)jtk_ArrayList_getValue(
             module->structures, j);
 
+        generateLinkage(generator, NULL);
         fprintf(generator->output, "kush_%s* $%s_new(k_Runtime_t* runtime", structure->name, structure->name);
 
         int32_t declarationCount = jtk_ArrayList_getSize(structure->declarations);
@@ -824,7 +1280,8 @@ void generateConstructors(Generator* generator, Module* module) {
             structure->name, structure->nameSize + 5, references + 1);
         fprintf(generator->output, "    kush_%s* self = (kush_%s*)k_Allocator_allocate(runtime->allocator, sizeof (kush_%s));\n",
             structure->name, structure->name, structure->name);
-        fprintf(generator->output, "    self->header.type = K_OBJECT_STRUCTURE_INSTANCE;\n\n");
+        fprintf(generator->output, "    self->header.type = K_OBJECT_STRUCTURE_INSTANCE;\n");
+        fprintf(generator->output, "    self->header.references = %d;\n\n", references);
         fprintf(generator->output, "    $stackFrame->pointers[0] = self;\n");
 
         int32_t index = 1;
@@ -853,8 +1310,9 @@ void generateConstructors(Generator* generator, Module* module) {
             int32_t j;
             for (j = 0; j < limit; j++) {
                 Variable* variable = (Variable*)jtk_ArrayList_getValue(declaration->variables, j);
-                fprintf(generator->output, "    self->%s = %s;\n", variable->name,
-                    variable->name);
+                const char* format = variable->type->reference?
+                    "    self->%s = K_ENCODE(%s);\n" : "    self->%s = %s;\n";
+                fprintf(generator->output, format, variable->name, variable->name);
             }
         }
 
@@ -868,7 +1326,9 @@ void generateHeader(Generator* generator, Module* module) {
     fprintf(generator->output, "// Do not edit this file.\n"
         "// It was automatically generated by kush v%d.%d.\n\n",
         KUSH_VERSION_MAJOR, KUSH_VERSION_MINOR);
-    fprintf(generator->output, "#pragma once\n\n");
+    if (!generator->compiler->inMemory) {
+        fprintf(generator->output, "#pragma once\n\n");
+    }
     fprintf(generator->output, "#include \"kush-runtime.h\"\n\n");
 
     generateForwardReferences(generator, module);
@@ -879,20 +1339,22 @@ void generateSource(Generator* generator, Module* module, const uint8_t* headerN
     fprintf(generator->output, "// Do not edit this file.\n"
         "// It was automatically generated by kush v%d.%d.\n\n",
         KUSH_VERSION_MAJOR, KUSH_VERSION_MINOR);
-    fprintf(generator->output, "#include \"%s\"\n\n", headerName);
+    if (headerName != NULL) {
+        fprintf(generator->output, "#include \"%s\"\n\n", headerName);
+    }
 
     generateConstructors(generator, module);
     generateFunctions(generator, module);
 }
 
-void generateC(Generator* generator, Module* module) {
-    Compiler* compiler = generator->compiler;
-    const uint8_t* path = (const uint8_t*)jtk_ArrayList_getValue(compiler->inputFiles,
-        compiler->currentFileIndex);
-
+/* Generates the source and header files of the module next to its input file,
+ * the path of which is specified.
+ */
+void generateC(Generator* generator, Module* module, const uint8_t* path) {
     int pathSize = jtk_CString_getSize(path);
-    uint8_t* sourceName = allocate(uint8_t, pathSize - 3);
-    uint8_t* headerName = allocate(uint8_t, pathSize - 3);
+    /* The "kush" extension is replaced by "c" or "h" and a null terminator. */
+    uint8_t* sourceName = allocate(uint8_t, pathSize - 2);
+    uint8_t* headerName = allocate(uint8_t, pathSize - 2);
 
     int32_t i;
     for (i = 0; i < pathSize - 4; i++) {
@@ -904,23 +1366,54 @@ void generateC(Generator* generator, Module* module) {
     headerName[i] = 'h';
     headerName[i + 1] = '\0';
 
-    generator->output = fopen(sourceName, "w+");
-    generateSource(generator, module, headerName);
+    /* The files are generated in memory and written only when their contents
+     * change, so that the C compiler can skip the unchanged files.
+     */
+    char* buffer;
+    size_t size;
+
+    /* The header is next to the source, where the C compiler looks first.
+     * Therefore, it is included by its name alone.
+     */
+    const uint8_t* includeName = (const uint8_t*)strrchr((const char*)headerName, '/');
+    includeName = (includeName == NULL)? headerName : includeName + 1;
+
+    generator->output = open_memstream(&buffer, &size);
+    generateSource(generator, module, includeName);
     fclose(generator->output);
+    writeIfChanged((const char*)sourceName, (const uint8_t*)buffer, size);
+    free(buffer);
 
-    generator->output = fopen(headerName, "w+");
+    generator->output = open_memstream(&buffer, &size);
     generateHeader(generator, module);
     fclose(generator->output);
+    writeIfChanged((const char*)headerName, (const uint8_t*)buffer, size);
+    free(buffer);
 
     deallocate(sourceName);
     deallocate(headerName);
 }
 
+/* Generates the header and the source of the module into a buffer, which is
+ * allocated with malloc. The header precedes the source, instead of being
+ * included by it, since no file is written.
+ */
+void generateInMemory(Generator* generator, Module* module, char** buffer,
+    size_t* size) {
+    generator->output = open_memstream(buffer, size);
+    generateHeader(generator, module);
+    generateSource(generator, module, NULL);
+    fclose(generator->output);
+}
+
 Generator* newGenerator(Compiler* compiler) {
     Generator* generator = allocate(Generator, 1);
     generator->compiler = compiler;
     generator->scope = NULL;
     generator->index = 0;
+    generator->assignment = NULL;
+    generator->encoding = false;
+    generator->packing = false;
     return generator;
 }
 
@@ -19,6 +19,7 @@ qualifiedName
 
 functionDeclaration
 :   returnType IDENTIFIER functionParameters functionBody
+|   'native' returnType IDENTIFIER functionParameters ';'
 ;
 
 functionParameters
@@ -167,7 +168,7 @@ type
 ;
 
 componentType
-:   IDENTIFIER
+:   IDENTIFIER typeArguments?
 |   'boolean',
 |   'i8'
 |   'i16',
@@ -177,6 +178,10 @@ componentType
 |   'f64'
 ;
 
+typeArguments
+:   '<' type (',' type)* '>'
+;
+
 returnType
 :   'void'
 |   type
@@ -100,6 +100,8 @@ Lexer* lexerNew(Compiler* compiler) {
 
     Lexer* lexer = allocate(Lexer, 1);
     lexer->compiler = compiler;
+    lexer->errorHandler = compiler->errorHandler;
+    lexer->file = NULL;
     lexer->inputStream = NULL;
     lexer->la1 = 0;
     lexer->index = -1;
@@ -148,9 +150,7 @@ Token* createToken(Lexer* lexer) {
     uint8_t* text = jtk_CString_newEx(lexer->text->m_value, lexer->text->m_size); // jtk_StringBuilder_toCString(lexer->text);
     int32_t length = jtk_StringBuilder_getSize(lexer->text);
 
-    Compiler* compiler = lexer->compiler;
-    const char* file = jtk_ArrayList_getValue(compiler->inputFiles,
-                       compiler->currentFileIndex);
+    const char* file = lexer->file;
     Token* token =
         newToken(
             lexer->channel,
@@ -666,9 +666,7 @@ void integerLiteral(Lexer* lexer) {
 Token* nextToken(Lexer* lexer) {
     jtk_Assert_assertObject(lexer, "The specified lexer is null.");
 
-    Compiler* compiler = lexer->compiler;
-    const char* file = jtk_ArrayList_getValue(compiler->inputFiles,
-                       compiler->currentFileIndex);
+    const char* file = lexer->file;
 
     /* The lexer does not bother to recognize a token
      * from the input stream unless necessary.
@@ -1801,7 +1799,7 @@ Token* nextToken(Lexer* lexer) {
          * Therefore, all types of errors are collectively recorded at this point.
          */
         if (lexer->errorCode != ERROR_NONE) {
-            handleLexicalError(lexer->compiler->errorHandler,
+            handleLexicalError(lexer->errorHandler,
                                               lexer, lexer->errorCode, newToken);
         }
     }
@@ -92,6 +92,7 @@ static Token* matchAndYield(Parser* parser, TokenType type);
 // Rules
 
 static bool followVariableDeclaration(Parser* parser);
+static bool followTypeArguments(Parser* parser, int32_t index);
 
 // Rules
 
@@ -100,6 +101,7 @@ static ImportDeclaration* parseImportDeclaration(Parser* parser);
 static VariableType* parseTypeEx(Parser* parser, bool includeVoid);
 static VariableType* parseType(Parser* parser);
 static VariableType* parseReturnType(Parser* parser);
+static jtk_ArrayList_t* parseTypeArguments(Parser* parser);
 static Function* parseFunctionDeclaration(Parser* parser, uint32_t modifiers);
 static void parseFunctionParameters(Parser* parser, jtk_ArrayList_t* fixedParameters,
     Variable** variableParameter);
@@ -228,8 +230,7 @@ void reportAndRecover(Parser* parser, TokenType expected) {
     */
     if (!parser->recovery) {
         Token* lt1 = lt(parser, 1);
-        Compiler* compiler = parser->compiler;
-        ErrorHandler* errorHandler = compiler->errorHandler;
+        ErrorHandler* errorHandler = parser->errorHandler;
         handleSyntaxError(errorHandler, parser,
             ERROR_UNEXPECTED_TOKEN, lt1, expected);
     }
@@ -391,7 +392,8 @@ Token* matchAndYield(Parser* parser, TokenType type) {
     (token == TOKEN_IDENTIFIER)
 
 #define isComponentFollow(token) \
-    (token == TOKEN_KEYWORD_STRUCT) || isReturnType(token)
+    (token == TOKEN_KEYWORD_STRUCT) || (token == TOKEN_KEYWORD_NATIVE) || \
+    isReturnType(token)
 
 // TODO: Add the string keyword.
 #define isType(token) \
@@ -595,7 +597,12 @@ Module* parseModule(Parser* parser) {
             jtk_ArrayList_add(context->structures, structure);
         }
         else {
-            Function* function = parseFunctionDeclaration(parser, 0);
+            uint32_t modifiers = 0;
+            if (la(parser, 1) == TOKEN_KEYWORD_NATIVE) {
+                Token* native = consumeAndYield(parser);
+                modifiers |= k_TokenType_toModifiers(native->type);
+            }
+            Function* function = parseFunctionDeclaration(parser, modifiers);
             jtk_ArrayList_add(context->functions, function);
         }
     }
@@ -694,6 +701,11 @@ VariableType* parseTypeEx(Parser* parser, bool includeVoid) {
     int32_t size = sizeof (tokens) / sizeof (TokenType);
     Token* token = matchAndYieldEx(parser, tokens, includeVoid? size : (size - 1),
         &index);
+    jtk_ArrayList_t* arguments = NULL;
+    if ((token->type == TOKEN_IDENTIFIER) && (la(parser, 1) == TOKEN_LEFT_ANGLE_BRACKET)) {
+        arguments = parseTypeArguments(parser);
+    }
+
     int32_t dimensions = 0;
     while (la(parser, 1) == TOKEN_LEFT_SQUARE_BRACKET) {
         consume(parser);
@@ -701,12 +713,46 @@ VariableType* parseTypeEx(Parser* parser, bool includeVoid) {
         match(parser, TOKEN_RIGHT_SQUARE_BRACKET);
     }
 
-    return newVariableType(token, dimensions);
+    VariableType* variableType = newVariableType(token, dimensions);
+    variableType->arguments = arguments;
+    return variableType;
+}
+
+/*
+ * typeArguments
+ * :    '<' type (',' type)* '>'
+ * ;
+ */
+jtk_ArrayList_t* parseTypeArguments(Parser* parser) {
+    jtk_ArrayList_t* arguments = jtk_ArrayList_new();
+    match(parser, TOKEN_LEFT_ANGLE_BRACKET);
+    pushFollowToken(parser, TOKEN_RIGHT_ANGLE_BRACKET);
+
+    jtk_ArrayList_add(arguments, parseType(parser));
+    while (la(parser, 1) == TOKEN_COMMA) {
+        consume(parser);
+        jtk_ArrayList_add(arguments, parseType(parser));
+    }
+
+    popFollowToken(parser);
+    if (la(parser, 1) == TOKEN_RIGHT_ANGLE_BRACKET_2) {
+        /* In `Map<string, Map<string, i32>>`, the lexer recognizes the closing
+         * brackets as the right shift operator. The operator is split into
+         * two brackets, the second of which is left for the enclosing type.
+         */
+        lt(parser, 1)->type = TOKEN_RIGHT_ANGLE_BRACKET;
+    }
+    else {
+        match(parser, TOKEN_RIGHT_ANGLE_BRACKET);
+    }
+
+    return arguments;
 }
 
 /**
  * componentType
- * :    'i8'
+ * :    IDENTIFIER typeArguments?
+ * |    'i8'
  * |    'i16'
  * |    'i32'
  * |    'i64'
@@ -757,15 +803,17 @@ Function* parseFunctionDeclaration(Parser* parser,
     popFollowToken(parser);
 
     Block* body = NULL;
-    if (false /*k_Modifier_hasNative(modifiers) */) {
+    if (hasNative(modifiers)) {
         match(parser, TOKEN_SEMICOLON);
     }
     else {
 	    body = parseBlock(parser);
     }
 
-    return newFunction(identifier->text, identifier->length, identifier,
-        parameters, variableParameter, body, returnVariableType);
+    Function* function = newFunction(identifier->text, identifier->length,
+        identifier, parameters, variableParameter, body, returnVariableType);
+    function->modifiers = modifiers;
+    return function;
 }
 
 /*
@@ -889,12 +937,14 @@ Block* parseBlock(Parser* parser) {
     (token == TOKEN_KEYWORD_STRING)
 
 /* The parser needs to look ahead 3 tokens to differentiate between variable
- * declarations and expressions, recognizing an LL(3) grammar.
+ * declarations and expressions, recognizing an LL(3) grammar. Types with type
+ * arguments are the exception, where the lookahead extends past the closing
+ * angle bracket.
  *
  * followVariableDeclaration
  * :    'let'
  * |    'var'
- * |    IDENTIFIER (('[' ']') | IDENTIFIER)
+ * |    IDENTIFIER (('[' ']') | IDENTIFIER | typeArguments)
  * ;
  */
 bool followVariableDeclaration(Parser* parser) {
@@ -904,7 +954,47 @@ bool followVariableDeclaration(Parser* parser) {
            isPrimitiveType(la1) ||
            ((la1 == TOKEN_IDENTIFIER) &&
             (((la(parser, 2) == TOKEN_LEFT_SQUARE_BRACKET) && (la(parser, 3) == TOKEN_RIGHT_SQUARE_BRACKET)) ||
-            (la(parser, 2) == TOKEN_IDENTIFIER)));
+            (la(parser, 2) == TOKEN_IDENTIFIER) ||
+            ((la(parser, 2) == TOKEN_LEFT_ANGLE_BRACKET) && followTypeArguments(parser, 2))));
+}
+
+/* Determines whether the tokens starting at the specified lookahead index,
+ * which is a left angle bracket, are type arguments followed by the name of a
+ * variable. Otherwise, the angle bracket is the less than operator.
+ */
+bool followTypeArguments(Parser* parser, int32_t index) {
+    int32_t depth = 0;
+    bool result = false;
+    bool done = false;
+    while (!done) {
+        TokenType type = la(parser, index++);
+        if (type == TOKEN_LEFT_ANGLE_BRACKET) {
+            depth++;
+        }
+        else if (type == TOKEN_RIGHT_ANGLE_BRACKET) {
+            depth--;
+        }
+        else if (type == TOKEN_RIGHT_ANGLE_BRACKET_2) {
+            depth -= 2;
+        }
+        else if ((type != TOKEN_IDENTIFIER) && (type != TOKEN_COMMA) &&
+            (type != TOKEN_LEFT_SQUARE_BRACKET) && (type != TOKEN_RIGHT_SQUARE_BRACKET) &&
+            !(isPrimitiveType(type))) {
+            done = true;
+        }
+
+        if (depth <= 0) {
+            done = true;
+            if (depth == 0) {
+                while ((la(parser, index) == TOKEN_LEFT_SQUARE_BRACKET) &&
+                    (la(parser, index + 1) == TOKEN_RIGHT_SQUARE_BRACKET)) {
+                    index += 2;
+                }
+                result = (la(parser, index) == TOKEN_IDENTIFIER);
+            }
+        }
+    }
+    return result;
 }
 
 /*
@@ -1019,7 +1109,7 @@ void parseVariableDeclarator(Parser* parser, bool infer, bool constant,
 
     TokenType la1 = la(parser, 1);
     if ((infer || constant) && (la1 != TOKEN_EQUAL)) {
-        ErrorHandler* errorHandler = parser->compiler->errorHandler;
+        ErrorHandler* errorHandler = parser->errorHandler;
         handleSyntaxError(errorHandler, parser,
             ERROR_VARIABLE_INITIALIZER_EXPECTED, identifier, TOKEN_UNKNOWN);
     }
@@ -1266,7 +1356,7 @@ TryStatement* parseTryStatement(Parser* parser) {
          * this is not an error. However, the KUSH specification requires a try
          * clause to be followed by at least a catch or finally clause.
          */
-        handleSyntaxError(parser->compiler->errorHandler,
+        handleSyntaxError(parser->errorHandler,
             parser, ERROR_TRY_STATEMENT_EXPECTS_CATCH_OR_FINALLY,
             tryKeyword, TOKEN_UNKNOWN);
 	}
@@ -1409,7 +1499,7 @@ BinaryExpression* parseAssignmentExpression(Parser* parser) {
         pair->m_left = consumeAndYield(parser);
 
         if (!parser->placeholder) {
-            ErrorHandler* handler = parser->compiler->errorHandler;
+            ErrorHandler* handler = parser->errorHandler;
             handleSyntaxError(handler, parser, ERROR_INVALID_LVALUE,
                 (Token*)pair->m_left, TOKEN_UNKNOWN);
         }
@@ -1899,6 +1989,11 @@ NewExpression* parseNewExpression(Parser* parser) {
     Token* token = matchAndYieldEx(parser, tokens, size, &index);
     int32_t dimensions = 0;
 
+    jtk_ArrayList_t* arguments = NULL;
+    if ((token->type == TOKEN_IDENTIFIER) && (la(parser, 1) == TOKEN_LEFT_ANGLE_BRACKET)) {
+        arguments = parseTypeArguments(parser);
+    }
+
     NewExpression* context = newNewExpression();
     if ((token->type == TOKEN_IDENTIFIER) && (la(parser, 1) == TOKEN_LEFT_BRACE)) {
         consume(parser);
@@ -1933,6 +2028,7 @@ NewExpression* parseNewExpression(Parser* parser) {
         while (la(parser, 1) == TOKEN_LEFT_SQUARE_BRACKET);
     }
     context->variableType = newVariableType(token, dimensions);
+    context->variableType->arguments = arguments;
     parser->placeholder = false;
 
     return context;
@@ -1968,7 +2064,7 @@ ArrayExpression* parseArrayExpression(Parser* parser) {
         popFollowToken(parser);
     }
     else {
-        ErrorHandler* errorHandler = parser->compiler->errorHandler;
+        ErrorHandler* errorHandler = parser->errorHandler;
         handleSyntaxError(errorHandler, parser,
             ERROR_EMPTY_ARRAY_INITIALIZER, context->token, TOKEN_UNKNOWN);
     }
@@ -1985,6 +2081,7 @@ Parser* parserNew(Compiler* compiler, TokenStream* tokens) {
 
     Parser* parser = allocate(Parser, 1);
     parser->compiler = compiler;
+    parser->errorHandler = compiler->errorHandler;
     parser->tokens = tokens;
     parser->followSet = allocate(int32_t, 16);
     parser->followSetSize = 0;
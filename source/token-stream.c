@@ -14,9 +14,61 @@
  * limitations under the License.
  */
 
+#include <sched.h>
+
 #include <jtk/collection/array/Arrays.h>
 #include <kush/token-stream.h>
 
+/*******************************************************************************
+ * TokenRing                                                                   *
+ *******************************************************************************/
+
+TokenRing* newTokenRing(uint32_t capacity) {
+    jtk_Assert_assertTrue((capacity & (capacity - 1)) == 0,
+        "The specified capacity is not a power of two.");
+
+    TokenRing* ring = allocate(TokenRing, 1);
+    ring->slots = allocate(Token*, capacity);
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+
+    return ring;
+}
+
+void deleteTokenRing(TokenRing* ring) {
+    jtk_Assert_assertObject(ring, "The specified token ring is null.");
+
+    deallocate(ring->slots);
+    deallocate(ring);
+}
+
+/* The release store of a counter publishes the slot that was written or read
+ * before it. It pairs with the acquire load on the other side.
+ */
+void pushToken(TokenRing* ring, Token* token) {
+    uint32_t tail = ring->tail;
+    while ((tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) == ring->capacity) {
+        sched_yield();
+    }
+    ring->slots[tail & (ring->capacity - 1)] = token;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+Token* popToken(TokenRing* ring) {
+    uint32_t head = ring->head;
+    while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) == head) {
+        sched_yield();
+    }
+    Token* token = ring->slots[head & (ring->capacity - 1)];
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    return token;
+}
+
+/*******************************************************************************
+ * TokenStream                                                                 *
+ *******************************************************************************/
+
 static void initialize(TokenStream* stream);
 
 TokenStream* tokenStreamNew(Compiler* compiler,
@@ -31,6 +83,7 @@ TokenStream* tokenStreamNew(Compiler* compiler,
     stream->hitEndOfStream = false;
     stream->channel = channel;
     stream->trash = jtk_ArrayList_new();
+    stream->ring = NULL;
 
     return stream;
 }
@@ -52,6 +105,7 @@ void resetTokenStream(TokenStream* stream) {
     jtk_ArrayList_clear(stream->tokens);
     stream->p = -1;
     stream->hitEndOfStream = false;
+    stream->ring = NULL;
 }
 
 int32_t k_TokenStream_getIndex(TokenStream* stream) {
@@ -114,7 +168,8 @@ int32_t fetchTokens(TokenStream* stream, int32_t n) {
     int32_t oldSize = jtk_ArrayList_getSize(stream->tokens);
     int32_t i;
     for (i = 0; i < n; i++) {
-        Token* token = nextToken(stream->lexer);
+        Token* token = (stream->ring != NULL)? popToken(stream->ring) :
+            nextToken(stream->lexer);
         token->index = oldSize + i;
         jtk_ArrayList_add(stream->tokens, token);
         jtk_ArrayList_add(stream->trash, token);
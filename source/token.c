@@ -183,7 +183,7 @@ uint32_t k_TokenType_toModifiers(TokenType type) {
     uint32_t modifiers = 0;
     switch (type) {
     case TOKEN_KEYWORD_NATIVE: {
-        // modifiers |= KUSH_MODIFIER_NATIVE;
+        modifiers |= KUSH_MODIFIER_NATIVE;
         break;
     }
     }